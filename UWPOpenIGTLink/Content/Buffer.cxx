@@ -26,11 +26,52 @@ OTHER DEALINGS IN THE SOFTWARE.
 
 #include "pch.h"
 #include "Buffer.h"
+#include "VolumeView.h"
 
 namespace
 {
   static const float NEGLIGIBLE_TIME_DIFFERENCE = 0.00001f; // in seconds, used for comparing between exact timestamps
   static const float ANGLE_INTERPOLATION_WARNING_THRESHOLD_DEG = 10.f; // if the interpolated orientation differs from both the interpolated orientation by more than this threshold then display a warning
+
+  //----------------------------------------------------------------------------
+  // A clip rectangle is defined if it has at least two components and every size component is positive, missing z components select every slice
+  // Returns false if the clip rectangle is defined but does not fit inside the frame
+  bool GetClipRegion(const FrameSize& frameSize,
+                     const Platform::Array<int>^ clipRectangleOrigin,
+                     const Platform::Array<int>^ clipRectangleSize,
+                     FrameSize& outOrigin,
+                     FrameSize& outSize)
+  {
+    outOrigin = { 0, 0, 0 };
+    outSize = frameSize;
+
+    if (clipRectangleOrigin == nullptr || clipRectangleSize == nullptr || clipRectangleOrigin->Length < 2 || clipRectangleSize->Length < 2)
+    {
+      return true;
+    }
+
+    for (uint32 i = 0; i < 3; ++i)
+    {
+      if (i < clipRectangleSize->Length && clipRectangleSize[i] <= 0)
+      {
+        return true;
+      }
+    }
+
+    for (uint32 i = 0; i < 3; ++i)
+    {
+      const int origin = i < clipRectangleOrigin->Length ? clipRectangleOrigin[i] : 0;
+      const uint64 size = i < clipRectangleSize->Length ? static_cast<uint64>(clipRectangleSize[i]) : frameSize[i];
+      if (origin < 0 || static_cast<uint64>(origin) + size > frameSize[i])
+      {
+        return false;
+      }
+      outOrigin[i] = static_cast<uint32>(origin);
+      outSize[i] = static_cast<uint32>(size);
+    }
+
+    return true;
+  }
 }
 
 using namespace Platform::Collections;
@@ -80,9 +121,9 @@ namespace UWPOpenIGTLink
   }
 
   //----------------------------------------------------------------------------
-  Platform::Array<uint16>^ Buffer::GetFrameSize()
+  FrameSizeABI^ Buffer::GetFrameSize()
   {
-    return ref new Platform::Array<uint16>(3) { FrameSize[0], FrameSize[1], FrameSize[2] };
+    return ref new FrameSizeABI(3) { FrameSize[0], FrameSize[1], FrameSize[2] };
   }
 
   //----------------------------------------------------------------------------
@@ -125,7 +166,7 @@ namespace UWPOpenIGTLink
   }
 
   //----------------------------------------------------------------------------
-  bool Buffer::CheckFrameFormat(const std::array<uint16, 3>& frameSize, int pixelType, int imgType, uint16 numberOfScalarComponents)
+  bool Buffer::CheckFrameFormat(const UWPOpenIGTLink::FrameSize& frameSize, int pixelType, int imgType, uint16 numberOfScalarComponents)
   {
     // don't add a frame if it doesn't match the buffer frame format
     if (frameSize[0] != this->GetFrameSize()[0] ||
@@ -171,6 +212,22 @@ namespace UWPOpenIGTLink
                        FrameFieldsABI^ frameFields,
                        float unfilteredTimestamp,
                        float filteredTimestamp)
+  {
+    return this->AddImage(image, usImageOrientation, imageType, frameNumber, clipRectangleOrigin, clipRectangleSize, frameFields, unfilteredTimestamp, filteredTimestamp, float4x4::identity(), nullptr);
+  }
+
+  //----------------------------------------------------------------------------
+  bool Buffer::AddImage(Image^ image,
+                        int usImageOrientation,
+                        int imageType,
+                        uint32 frameNumber,
+                        const Platform::Array<int>^ clipRectangleOrigin,
+                        const Platform::Array<int>^ clipRectangleSize,
+                        FrameFieldsABI^ frameFields,
+                        float unfilteredTimestamp,
+                        float filteredTimestamp,
+                        const float4x4& embeddedImageTransform,
+                        TransformName^ embeddedImageTransformName)
   {
     if (image == nullptr)
     {
@@ -200,7 +257,14 @@ namespace UWPOpenIGTLink
       }
     }
 
-    auto frameSize = image->GetFrameSize();
+    UWPOpenIGTLink::FrameSize clipOrigin;
+    UWPOpenIGTLink::FrameSize frameSize;
+    if (!GetClipRegion(image->GetFrameSize(), clipRectangleOrigin, clipRectangleSize, clipOrigin, frameSize))
+    {
+      OutputDebugStringA("Buffer: Unable to add frame to video buffer - clip rectangle is outside of the frame!");
+      return false;
+    }
+
     if (!this->CheckFrameFormat(frameSize, image->ScalarType, imageType, image->NumberOfScalarComponents))
     {
       OutputDebugStringA("Buffer: Unable to add frame to video buffer - frame format doesn't match!");
@@ -235,9 +299,30 @@ namespace UWPOpenIGTLink
       return false;
     }
 
+    if (frameSize != image->GetFrameSize())
+    {
+      // Copy only the clipped rows into a buffer sized to the clip region
+      auto clippedImage = VolumeView(image).Crop({ clipOrigin[0], clipOrigin[1], clipOrigin[2] }, { frameSize[0], frameSize[1], frameSize[2] }).ToImage();
+      if (clippedImage == nullptr)
+      {
+        OutputDebugStringA("Buffer: Unable to add frame to video buffer - failed to clip frame!");
+        return false;
+      }
+      clippedImage->Timestamp = image->Timestamp;
+      image = clippedImage;
+    }
+
     // Shallow set image pointer, ref count will increase
     newObjectInBuffer->GetFrame()->ShallowCopy(image, (US_IMAGE_ORIENTATION)usImageOrientation, (US_IMAGE_TYPE)imageType);
 
+    // Pixel (0,0,0) of the clipped frame is pixel clipOrigin of the received frame
+    float4x4 clipTranslation(float4x4::identity());
+    clipTranslation.m14 = clipOrigin[0];
+    clipTranslation.m24 = clipOrigin[1];
+    clipTranslation.m34 = clipOrigin[2];
+    newObjectInBuffer->GetFrame()->EmbeddedImageTransform = embeddedImageTransform * clipTranslation;
+    newObjectInBuffer->GetFrame()->EmbeddedImageTransformName = embeddedImageTransformName;
+
     newObjectInBuffer->SetFilteredTimestamp(filteredTimestamp);
     newObjectInBuffer->SetUnfilteredTimestamp(unfilteredTimestamp);
     newObjectInBuffer->SetIndex(frameNumber);
@@ -273,7 +358,7 @@ namespace UWPOpenIGTLink
       return false;
     }
 
-    return this->AddItem(frame->Image, frame->Orientation, frame->Type, frameNumber, clipRectangleOrigin, clipRectangleSize, frameFields, unfilteredTimestamp, filteredTimestamp);
+    return this->AddImage(frame->Image, frame->Orientation, frame->Type, frameNumber, clipRectangleOrigin, clipRectangleSize, frameFields, unfilteredTimestamp, filteredTimestamp, frame->EmbeddedImageTransform, frame->EmbeddedImageTransformName);
   }
 
   //----------------------------------------------------------------------------
@@ -567,7 +652,7 @@ namespace UWPOpenIGTLink
   }
 
   //----------------------------------------------------------------------------
-  bool Buffer::SetFrameSize(uint16 x, uint16 y, uint16 z)
+  bool Buffer::SetFrameSize(uint32 x, uint32 y, uint32 z)
   {
     if (x != 0 && y != 0 && z == 0)
     {
@@ -586,7 +671,7 @@ namespace UWPOpenIGTLink
   }
 
   //----------------------------------------------------------------------------
-  bool Buffer::SetFrameSize(const Platform::Array<uint16>^ frameSize)
+  bool Buffer::SetFrameSize(const FrameSizeABI^ frameSize)
   {
     return SetFrameSize(frameSize[0], frameSize[1], frameSize[2]);
   }
@@ -60,6 +60,8 @@ namespace UWPOpenIGTLink
     or if the frame's format doesn't match the buffer's frame format,
     then the frame is not added to the buffer. If a clip rectangle is defined
     then only that portion of the frame is extracted.
+    The clip rectangle is defined when every component of clipRectangleSize is positive,
+    the buffer frame size must then match the clip rectangle size.
     */
     bool AddItem(Image^ frame,
                  int usImageOrientation,
@@ -188,11 +190,11 @@ namespace UWPOpenIGTLink
     float GetStartTime();
 
     /*! Set the frame size in pixel  */
-    bool SetFrameSize(uint16 x, uint16 y, uint16 z);
+    bool SetFrameSize(uint32 x, uint32 y, uint32 z);
     /*! Set the frame size in pixel  */
-    bool SetFrameSize(const Platform::Array<uint16>^ frameSize);
+    bool SetFrameSize(const FrameSizeABI^ frameSize);
     /*! Get the frame size in pixel  */
-    Platform::Array<uint16>^ GetFrameSize();
+    FrameSizeABI^ GetFrameSize();
 
     /*! Set the pixel type */
     bool SetPixelType(int pixelType);
@@ -234,7 +236,24 @@ namespace UWPOpenIGTLink
     Compares frame format with new frame imaging parameters.
     \return true if current buffer frame format matches the method arguments, otherwise false
     */
-    bool CheckFrameFormat(const std::array<uint16, 3>& frameSize, int pixelType, int imgType, uint16 numberOfScalarComponents);
+    bool CheckFrameFormat(const UWPOpenIGTLink::FrameSize& frameSize, int pixelType, int imgType, uint16 numberOfScalarComponents);
+
+    /*!
+    Add an image to the buffer, cropped to the clip rectangle if one is defined.
+    The buffered frame's embedded image transform is embeddedImageTransform followed by the translation
+    of the clip rectangle origin, so that it maps the pixels of the cropped frame.
+    */
+    bool AddImage(Image^ frame,
+                  int usImageOrientation,
+                  int imageType,
+                  uint32 frameNumber,
+                  const Platform::Array<int>^ clipRectangleOrigin,
+                  const Platform::Array<int>^ clipRectangleSize,
+                  FrameFieldsABI^ customFields,
+                  float unfilteredTimestamp,
+                  float filteredTimestamp,
+                  const Windows::Foundation::Numerics::float4x4& embeddedImageTransform,
+                  TransformName^ embeddedImageTransformName);
 
     /*! Returns the two buffer items that are closest previous and next buffer items relative to the specified time. itemA is the closest item */
     Windows::Foundation::Collections::IVectorView<StreamBufferItem^>^ GetPrevNextBufferItemFromTime(float time);
@@ -253,7 +272,7 @@ namespace UWPOpenIGTLink
     StreamBufferItem^ GetStreamBufferItemFromClosestTime(float time);
 
   protected private:
-    std::array<uint16, 3> FrameSize = { 0, 0, 1 };
+    UWPOpenIGTLink::FrameSize FrameSize = { 0, 0, 1 };
     IGTL_SCALAR_TYPE PixelType = IGTL_SCALARTYPE_UINT8;
     uint16 NumberOfScalarComponents = 1;
     US_IMAGE_TYPE ImageType = US_IMG_BRIGHTNESS;
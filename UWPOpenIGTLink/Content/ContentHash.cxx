@@ -0,0 +1,217 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+// Local includes
+#include "pch.h"
+#include "ContentHash.h"
+#include "PixelConversion.h"
+
+// STL includes
+#include <cstring>
+
+#if defined(_M_IX86) || defined(_M_X64)
+  #define CONTENT_HASH_X86
+  #include <emmintrin.h>
+#endif
+
+namespace UWPOpenIGTLink
+{
+  namespace
+  {
+    static const size_t STRIPE_SIZE = 64;
+    // Accumulators are scrambled after each block of stripes so that the multiplies cannot saturate them
+    static const size_t STRIPES_PER_BLOCK = 16;
+    static const size_t ACCUMULATOR_COUNT = 8;
+
+    static const uint64_t PRIME32_1 = 0x9E3779B1ULL;
+    static const uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+    static const uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+    static const uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+    static const uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+
+    // Each stripe of a block uses the keys starting at its index, the last ACCUMULATOR_COUNT keys scramble the accumulators
+    static const uint64_t SECRET[STRIPES_PER_BLOCK + ACCUMULATOR_COUNT] =
+    {
+      0xE220A8397B1DCDAFULL, 0x6E789E6AA1B965F4ULL, 0x06C45D188009454FULL,
+      0xF88BB8A8724C81ECULL, 0x1B39896A51A8749BULL, 0x53CB9F0C747EA2EAULL,
+      0x2C829ABE1F4532E1ULL, 0xC584133AC916AB3CULL, 0x3EE5789041C98AC3ULL,
+      0xF3B8488C368CB0A6ULL, 0x657EECDD3CB13D09ULL, 0xC2D326E0055BDEF6ULL,
+      0x8621A03FE0BBDB7BULL, 0x8E1F7555983AA92FULL, 0xB54E0F1600CC4D19ULL,
+      0x84BB3F97971D80ABULL, 0x7D29825C75521255ULL, 0xC3CF17102B7F7F86ULL,
+      0x3466E9A083914F64ULL, 0xD81A8D2B5A4485ACULL, 0xDB01602B100B9ED7ULL,
+      0xA9038A921825F10DULL, 0xEDF5F1D90DCA2F6AULL, 0x54496AD67BD2634CULL,
+    };
+    static const uint64_t* SCRAMBLE_KEYS = SECRET + STRIPES_PER_BLOCK;
+
+    //----------------------------------------------------------------------------
+    inline uint64_t Read64(const byte* data)
+    {
+      uint64_t value;
+      memcpy(&value, data, sizeof(value));
+      return value;
+    }
+
+    //----------------------------------------------------------------------------
+    inline uint64_t RotateLeft(uint64_t value, int bits)
+    {
+      return (value << bits) | (value >> (64 - bits));
+    }
+
+    //----------------------------------------------------------------------------
+    void AccumulateScalar(uint64_t* acc, const byte* data, size_t stripes, const uint64_t* keys)
+    {
+      for (size_t s = 0; s < stripes; ++s, data += STRIPE_SIZE)
+      {
+        for (size_t i = 0; i < ACCUMULATOR_COUNT; ++i)
+        {
+          const uint64_t value = Read64(data + i * 8);
+          const uint64_t key = value ^ keys[s + i];
+          acc[i ^ 1] += value;
+          acc[i] += (key & 0xFFFFFFFFULL) * (key >> 32);
+        }
+      }
+    }
+
+    //----------------------------------------------------------------------------
+    void ScrambleScalar(uint64_t* acc)
+    {
+      for (size_t i = 0; i < ACCUMULATOR_COUNT; ++i)
+      {
+        acc[i] = ((acc[i] ^ (acc[i] >> 47)) ^ SCRAMBLE_KEYS[i]) * PRIME32_1;
+      }
+    }
+
+#if defined(CONTENT_HASH_X86)
+    //----------------------------------------------------------------------------
+    void AccumulateSSE2(uint64_t* acc, const byte* data, size_t stripes, const uint64_t* keys)
+    {
+      __m128i a[4];
+      for (int i = 0; i < 4; ++i)
+      {
+        a[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc) + i);
+      }
+
+      for (size_t s = 0; s < stripes; ++s, data += STRIPE_SIZE)
+      {
+        for (int i = 0; i < 4; ++i)
+        {
+          const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data) + i);
+          const __m128i key = _mm_xor_si128(value, _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + s) + i));
+          // Low 32 bits of each lane times its high 32 bits, plus the other lane's value
+          const __m128i product = _mm_mul_epu32(key, _mm_srli_epi64(key, 32));
+          const __m128i swapped = _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+          a[i] = _mm_add_epi64(a[i], _mm_add_epi64(product, swapped));
+        }
+      }
+
+      for (int i = 0; i < 4; ++i)
+      {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(acc) + i, a[i]);
+      }
+    }
+
+    //----------------------------------------------------------------------------
+    void ScrambleSSE2(uint64_t* acc)
+    {
+      const __m128i prime = _mm_set1_epi32(static_cast<int>(PRIME32_1));
+      for (int i = 0; i < 4; ++i)
+      {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc) + i);
+        a = _mm_xor_si128(a, _mm_srli_epi64(a, 47));
+        a = _mm_xor_si128(a, _mm_loadu_si128(reinterpret_cast<const __m128i*>(SCRAMBLE_KEYS) + i));
+        // 64x32 bit multiply from two 32x32 bit multiplies
+        const __m128i low = _mm_mul_epu32(a, prime);
+        const __m128i high = _mm_mul_epu32(_mm_srli_epi64(a, 32), prime);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(acc) + i, _mm_add_epi64(low, _mm_slli_epi64(high, 32)));
+      }
+    }
+#endif
+
+    //----------------------------------------------------------------------------
+    inline uint64_t MergeRound(uint64_t value)
+    {
+      return RotateLeft(value * PRIME64_2, 31) * PRIME64_1;
+    }
+
+    //----------------------------------------------------------------------------
+    inline uint64_t Avalanche(uint64_t hash)
+    {
+      hash ^= hash >> 33;
+      hash *= PRIME64_2;
+      hash ^= hash >> 29;
+      hash *= PRIME64_3;
+      hash ^= hash >> 32;
+      return hash;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  uint64_t HashBytes(const void* data, size_t size, uint64_t seed)
+  {
+    auto accumulate = &AccumulateScalar;
+    auto scramble = &ScrambleScalar;
+#if defined(CONTENT_HASH_X86)
+    if (PixelConversion::GetInstructionSetLevel() >= PIXEL_CONVERSION_ISA_SSE2)
+    {
+      accumulate = &AccumulateSSE2;
+      scramble = &ScrambleSSE2;
+    }
+#endif
+
+    uint64_t acc[ACCUMULATOR_COUNT] =
+    {
+      PRIME32_1 + seed, PRIME64_1 - seed, PRIME64_2 + seed, PRIME64_3 - seed,
+      PRIME64_4 + seed, PRIME32_1 - seed, PRIME64_2 ^ seed, PRIME64_3 ^ seed
+    };
+
+    const byte* input = static_cast<const byte*>(data);
+    const size_t blockSize = STRIPE_SIZE * STRIPES_PER_BLOCK;
+    size_t remaining = size;
+    for (; remaining >= blockSize; remaining -= blockSize, input += blockSize)
+    {
+      accumulate(acc, input, STRIPES_PER_BLOCK, SECRET);
+      scramble(acc);
+    }
+
+    const size_t stripes = remaining / STRIPE_SIZE;
+    accumulate(acc, input, stripes, SECRET);
+    input += stripes * STRIPE_SIZE;
+    remaining -= stripes * STRIPE_SIZE;
+
+    // The tail is zero padded into a last stripe, the size is mixed in below so that padding cannot collide with real zeros
+    if (remaining > 0)
+    {
+      byte lastStripe[STRIPE_SIZE] = {};
+      memcpy(lastStripe, input, remaining);
+      accumulate(acc, lastStripe, 1, SECRET + stripes);
+    }
+
+    uint64_t hash = (static_cast<uint64_t>(size) * PRIME64_1) ^ seed;
+    for (size_t i = 0; i < ACCUMULATOR_COUNT; ++i)
+    {
+      hash ^= MergeRound(acc[i]);
+      hash = hash * PRIME64_1 + PRIME64_4;
+    }
+    return Avalanche(hash);
+  }
+}
@@ -0,0 +1,38 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+#pragma once
+
+// STL includes
+#include <cstddef>
+#include <cstdint>
+
+namespace UWPOpenIGTLink
+{
+  /*!
+    Fast non-cryptographic 64 bit hash of size bytes, in the style of XXH3 (64 byte stripes folded into 8 independent
+    accumulators by 32x32 bit multiplies, SSE2 when available). Intended to tell identical image payloads apart, e.g. to detect a
+    device resending the same frame, not to protect against deliberate collisions. The result is identical with and without SIMD.
+  */
+  uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 0);
+}
@@ -55,6 +55,15 @@ namespace UWPOpenIGTLink
   FrameFieldsABI^ TrackedFrame::Fields::get()
   {
     auto map = ref new Map<Platform::String^, Platform::String^>();
+    if (m_frameFieldTable != nullptr)
+    {
+      FrameFields received;
+      m_frameFieldTable->GetFields(received);
+      for (auto pair : received)
+      {
+        map->Insert(ref new Platform::String(pair.first.c_str()), ref new Platform::String(pair.second.c_str()));
+      }
+    }
     for (auto pair : m_frameFields)
     {
       map->Insert(ref new Platform::String(pair.first.c_str()), ref new Platform::String(pair.second.c_str()));
@@ -112,6 +121,30 @@ namespace UWPOpenIGTLink
     m_frame->Timestamp = arg;
   }
 
+  //----------------------------------------------------------------------------
+  uint64 TrackedFrame::ImageContentHash::get()
+  {
+    return m_imageContentHash;
+  }
+
+  //----------------------------------------------------------------------------
+  void TrackedFrame::ImageContentHash::set(uint64 arg)
+  {
+    m_imageContentHash = arg;
+  }
+
+  //----------------------------------------------------------------------------
+  bool TrackedFrame::IsDuplicate::get()
+  {
+    return m_isDuplicate;
+  }
+
+  //----------------------------------------------------------------------------
+  void TrackedFrame::IsDuplicate::set(bool arg)
+  {
+    m_isDuplicate = arg;
+  }
+
   //----------------------------------------------------------------------------
   TrackedFrame::TrackedFrame()
   {
@@ -155,12 +188,10 @@ namespace UWPOpenIGTLink
   //----------------------------------------------------------------------------
   Platform::String^ TrackedFrame::GetFrameField(Platform::String^ fieldName)
   {
-    std::wstring field(fieldName->Data());
-    FrameFields::iterator fieldIterator;
-    fieldIterator = m_frameFields.find(field);
-    if (fieldIterator != m_frameFields.end())
+    std::wstring value;
+    if (GetFrameField(std::wstring(fieldName->Data()), value))
     {
-      return ref new Platform::String(fieldIterator->second.c_str());
+      return ref new Platform::String(value.c_str());
     }
     return nullptr;
   }
@@ -193,9 +224,26 @@ namespace UWPOpenIGTLink
       value = fieldIterator->second;
       return true;
     }
+
+    if (m_frameFieldTable != nullptr)
+    {
+      auto index = m_frameFieldTable->FindField(fieldName);
+      if (index < m_frameFieldTable->GetFieldCount() && !m_frameFieldTable->IsTransformField(index))
+      {
+        // The table is immutable once set, decoding on every read keeps concurrent readers from writing m_frameFields
+        value = m_frameFieldTable->GetWideFieldValue(index);
+        return true;
+      }
+    }
     return false;
   }
 
+  //----------------------------------------------------------------------------
+  void TrackedFrame::SetFrameFieldTable(std::shared_ptr<FrameFieldTable> table)
+  {
+    m_frameFieldTable = table;
+  }
+
   //----------------------------------------------------------------------------
   bool TrackedFrame::IsTransform(const std::wstring& str)
   {
@@ -27,6 +27,7 @@ OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 // Local includes
+#include "FrameFieldTable.h"
 #include "IGTCommon.h"
 #include "Transform.h"
 #include "TransformName.h"
@@ -45,6 +46,10 @@ namespace UWPOpenIGTLink
     property FrameSizeABI^ Dimensions { FrameSizeABI ^ get(); }
     property TransformListABI^ Transforms { TransformListABI ^ get(); void set(TransformListABI ^ arg); }
     property double Timestamp { double get(); void set(double arg); }
+    /// Content hash of the image as received, 0 if it was not computed
+    property uint64 ImageContentHash { uint64 get(); void set(uint64 arg); }
+    /// True if the image is identical to the previous image received from the same device
+    property bool IsDuplicate { bool get(); void set(bool arg); }
 
   public:
     TrackedFrame();
@@ -64,6 +69,9 @@ namespace UWPOpenIGTLink
     void SetFrameField(const std::wstring& fieldName, const std::wstring& value);
     bool GetFrameField(const std::wstring& fieldName, std::wstring& value);
 
+    /// Fields received with the frame, decoded on each access without modifying the frame. Fields set with SetFrameField take precedence.
+    void SetFrameFieldTable(std::shared_ptr<FrameFieldTable> table);
+
     void SetFrameSize(const FrameSize& frameSize);
     FrameSize GetFrameSize()const;
 
@@ -85,11 +93,14 @@ namespace UWPOpenIGTLink
 
   protected private:
     // Tracking/other related fields
-    FrameFields               m_frameFields;
+    FrameFields                       m_frameFields;      // fields that were set locally
+    std::shared_ptr<FrameFieldTable>  m_frameFieldTable = nullptr;
     TransformListInternal     m_frameTransforms;
 
     // Image related fields
     VideoFrame^               m_frame = ref new VideoFrame();
     FrameSize                 m_frameSize = { 0, 0, 0 };
+    uint64                    m_imageContentHash = 0;
+    bool                      m_isDuplicate = false;
   };
 }
\ No newline at end of file
@@ -0,0 +1,117 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+// Local includes
+#include "pch.h"
+#include "FastCopy.h"
+#include "PixelConversion.h"
+
+// STL includes
+#include <cstdint>
+#include <cstring>
+
+// Windows includes
+#include <ppl.h>
+
+#if defined(_M_IX86) || defined(_M_X64)
+  #define FAST_COPY_X86
+  #include <emmintrin.h>
+#endif
+
+namespace UWPOpenIGTLink
+{
+  namespace
+  {
+    // Smaller copies are likely to be read again soon and fit the caches, they are left to memcpy
+    static const size_t STREAMING_THRESHOLD = 2 * 1024 * 1024;
+    // Each worker copies at least this much, a worker per 2 MB up to MAXIMUM_WORKERS
+    static const size_t MINIMUM_WORKER_SIZE = 2 * 1024 * 1024;
+    static const size_t MAXIMUM_WORKERS = 4;
+
+    //----------------------------------------------------------------------------
+    void StreamCopy(byte* destination, const byte* source, size_t size)
+    {
+#if defined(FAST_COPY_X86)
+      if (PixelConversion::GetInstructionSetLevel() >= PIXEL_CONVERSION_ISA_SSE2)
+      {
+        // Streaming stores need a 16 byte aligned destination, the unaligned head is copied normally
+        const size_t head = (16 - (reinterpret_cast<uintptr_t>(destination) & 15)) & 15;
+        if (head >= size)
+        {
+          memcpy(destination, source, size);
+          return;
+        }
+        memcpy(destination, source, head);
+
+        size_t i = head;
+        for (; i + 64 <= size; i += 64)
+        {
+          const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+          const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 16));
+          const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 32));
+          const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 48));
+          _mm_stream_si128(reinterpret_cast<__m128i*>(destination + i), a);
+          _mm_stream_si128(reinterpret_cast<__m128i*>(destination + i + 16), b);
+          _mm_stream_si128(reinterpret_cast<__m128i*>(destination + i + 32), c);
+          _mm_stream_si128(reinterpret_cast<__m128i*>(destination + i + 48), d);
+        }
+        for (; i + 16 <= size; i += 16)
+        {
+          _mm_stream_si128(reinterpret_cast<__m128i*>(destination + i), _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i)));
+        }
+        // Streaming stores are weakly ordered, make them visible before the copy is reported done
+        _mm_sfence();
+
+        memcpy(destination + i, source + i, size - i);
+        return;
+      }
+#endif
+      memcpy(destination, source, size);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  void FastCopy(void* destination, const void* source, size_t size)
+  {
+    if (size < STREAMING_THRESHOLD)
+    {
+      memcpy(destination, source, size);
+      return;
+    }
+
+    size_t workers = size / MINIMUM_WORKER_SIZE;
+    workers = workers > MAXIMUM_WORKERS ? MAXIMUM_WORKERS : workers;
+
+    // Chunks are whole cache lines, so every chunk starts at the same alignment as the first
+    const size_t chunkSize = (size / workers + 63) & ~static_cast<size_t>(63);
+    Concurrency::parallel_for(static_cast<size_t>(0), workers, [&](size_t worker)
+    {
+      const size_t offset = worker * chunkSize;
+      if (offset < size)
+      {
+        const size_t count = size - offset < chunkSize ? size - offset : chunkSize;
+        StreamCopy(static_cast<byte*>(destination) + offset, static_cast<const byte*>(source) + offset, count);
+      }
+    });
+  }
+}
@@ -0,0 +1,38 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+#pragma once
+
+// STL includes
+#include <cstddef>
+
+namespace UWPOpenIGTLink
+{
+  /*!
+    Copy size bytes from source to destination, which must not overlap (as memcpy).
+    Small copies are a memcpy. Copies of several MB, e.g. whole frames, are split across up to 4 worker threads and written
+    with non-temporal (streaming) stores, so they neither occupy a single core nor evict the working set of other threads from the caches.
+    The destination is not left in the cache, prefer memcpy if it is read again straight away.
+  */
+  void FastCopy(void* destination, const void* source, size_t size);
+}
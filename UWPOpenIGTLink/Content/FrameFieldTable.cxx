@@ -0,0 +1,572 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+// Local includes
+#include "pch.h"
+#include "FrameFieldTable.h"
+
+// STL includes
+#include <cstring>
+
+namespace
+{
+  static const char TRACKED_FRAME_TAG[] = "TrackedFrame";
+  static const char CUSTOM_FRAME_FIELD_TAG[] = "CustomFrameField";
+  static const char TRANSFORM_POSTFIX[] = "Transform";
+  static const char TRANSFORM_STATUS_POSTFIX[] = "TransformStatus";
+
+  //----------------------------------------------------------------------------
+  inline bool IsXmlSpace(char c)
+  {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+  }
+
+  //----------------------------------------------------------------------------
+  inline bool IsNameChar(char c)
+  {
+    return !IsXmlSpace(c) && c != '=' && c != '>' && c != '/' && c != '<';
+  }
+
+  //----------------------------------------------------------------------------
+  bool EndsWith(const char* str, size_t length, const char* postfix)
+  {
+    size_t postfixLength = strlen(postfix);
+    return length > postfixLength && memcmp(str + length - postfixLength, postfix, postfixLength) == 0;
+  }
+
+  //----------------------------------------------------------------------------
+  inline bool StartsWith(const char* data, size_t position, size_t size, const char* prefix)
+  {
+    size_t prefixLength = strlen(prefix);
+    return position + prefixLength <= size && memcmp(data + position, prefix, prefixLength) == 0;
+  }
+
+  //----------------------------------------------------------------------------
+  /// Returns the position after the first occurrence of terminator at or after position, or npos
+  size_t SkipPast(const char* data, size_t position, size_t size, const char* terminator)
+  {
+    size_t terminatorLength = strlen(terminator);
+    while (position + terminatorLength <= size)
+    {
+      const char* candidate = static_cast<const char*>(memchr(data + position, terminator[0], size - position));
+      if (candidate == nullptr)
+      {
+        break;
+      }
+      position = candidate - data;
+      if (StartsWith(data, position, size, terminator))
+      {
+        return position + terminatorLength;
+      }
+      ++position;
+    }
+    return std::string::npos;
+  }
+
+  //----------------------------------------------------------------------------
+  /// Skip a comment, processing instruction, CDATA section or declaration starting at position
+  /// Returns position unchanged if there is none, npos if it is not terminated
+  size_t SkipMarkup(const char* data, size_t position, size_t size)
+  {
+    if (StartsWith(data, position, size, "<!--"))
+    {
+      return SkipPast(data, position + 4, size, "-->");
+    }
+    if (StartsWith(data, position, size, "<![CDATA["))
+    {
+      return SkipPast(data, position + 9, size, "]]>");
+    }
+    if (StartsWith(data, position, size, "<?"))
+    {
+      return SkipPast(data, position + 2, size, "?>");
+    }
+    if (StartsWith(data, position, size, "<!"))
+    {
+      return SkipPast(data, position + 2, size, ">");
+    }
+    return position;
+  }
+
+  //----------------------------------------------------------------------------
+  void AppendCodePoint(std::string& out, uint32 codePoint)
+  {
+    if (codePoint < 0x80)
+    {
+      out.push_back(static_cast<char>(codePoint));
+    }
+    else if (codePoint < 0x800)
+    {
+      out.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+      out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+    else if (codePoint < 0x10000)
+    {
+      out.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+      out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+    else
+    {
+      out.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+      out.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  void AppendCodePoint(std::wstring& out, uint32 codePoint)
+  {
+    if (codePoint < 0x10000)
+    {
+      out.push_back(static_cast<wchar_t>(codePoint));
+    }
+    else
+    {
+      codePoint -= 0x10000;
+      out.push_back(static_cast<wchar_t>(0xD800 | (codePoint >> 10)));
+      out.push_back(static_cast<wchar_t>(0xDC00 | (codePoint & 0x3FF)));
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  /// Unescape the predefined entities and character references of an attribute value
+  /// Plain bytes are copied one per character, character references are encoded in the output's own encoding
+  template<typename StringType>
+  StringType DecodeEntities(const char* data, uint32 length)
+  {
+    typedef typename StringType::value_type CharType;
+    StringType result;
+    result.reserve(length);
+
+    for (uint32 i = 0; i < length; ++i)
+    {
+      if (data[i] != '&')
+      {
+        result.push_back(static_cast<CharType>(static_cast<unsigned char>(data[i])));
+        continue;
+      }
+
+      const char* end = static_cast<const char*>(memchr(data + i, ';', length - i));
+      if (end == nullptr)
+      {
+        for (; i < length; ++i)
+        {
+          result.push_back(static_cast<CharType>(static_cast<unsigned char>(data[i])));
+        }
+        break;
+      }
+
+      std::string entity(data + i + 1, end);
+      if (entity == "amp")
+      {
+        result.push_back('&');
+      }
+      else if (entity == "lt")
+      {
+        result.push_back('<');
+      }
+      else if (entity == "gt")
+      {
+        result.push_back('>');
+      }
+      else if (entity == "quot")
+      {
+        result.push_back('"');
+      }
+      else if (entity == "apos")
+      {
+        result.push_back('\'');
+      }
+      else if (entity.size() > 1 && entity[0] == '#')
+      {
+        bool hex = entity[1] == 'x' || entity[1] == 'X';
+        uint32 codePoint = static_cast<uint32>(strtoul(entity.c_str() + (hex ? 2 : 1), nullptr, hex ? 16 : 10));
+        if (codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+        {
+          codePoint = 0xFFFD;
+        }
+        AppendCodePoint(result, codePoint);
+      }
+      else
+      {
+        for (const char* c = data + i; c <= end; ++c)
+        {
+          result.push_back(static_cast<CharType>(static_cast<unsigned char>(*c)));
+        }
+      }
+      i = static_cast<uint32>(end - data);
+    }
+
+    return result;
+  }
+}
+
+namespace UWPOpenIGTLink
+{
+  //----------------------------------------------------------------------------
+  FrameFieldTable::FrameFieldTable()
+  {
+  }
+
+  //----------------------------------------------------------------------------
+  bool FrameFieldTable::Parse(std::shared_ptr<const char> xml, size_t size)
+  {
+    m_xml = xml;
+    m_size = size;
+    m_rootAttributes.clear();
+    m_fields.clear();
+
+    const char* data = m_xml.get();
+    const size_t tagLength = sizeof(TRACKED_FRAME_TAG) - 1;
+    const size_t fieldTagLength = sizeof(CUSTOM_FRAME_FIELD_TAG) - 1;
+
+    // Skip anything (declaration, whitespace, comments) before the root element
+    size_t position = 0;
+    while (true)
+    {
+      while (position < m_size && data[position] != '<')
+      {
+        ++position;
+      }
+      size_t markupEnd = SkipMarkup(data, position, m_size);
+      if (markupEnd == std::string::npos)
+      {
+        return false;
+      }
+      if (markupEnd != position)
+      {
+        position = markupEnd;
+        continue;
+      }
+      // The tag must be followed by at least one more character
+      if (position + 1 + tagLength >= m_size)
+      {
+        return false;
+      }
+      if (memcmp(data + position + 1, TRACKED_FRAME_TAG, tagLength) == 0 && !IsNameChar(data[position + 1 + tagLength]))
+      {
+        break;
+      }
+      ++position;
+    }
+
+    bool selfClosing(false);
+    position = ParseAttributes(position + 1 + tagLength, m_rootAttributes, selfClosing);
+    if (position == std::string::npos)
+    {
+      return false;
+    }
+    if (selfClosing)
+    {
+      return true;
+    }
+
+    // Only direct children of the root are fields, deeper elements are skipped
+    std::vector<Entry> attributes;
+    size_t depth = 1;
+    while (position < m_size)
+    {
+      if (data[position] != '<')
+      {
+        ++position;
+        continue;
+      }
+
+      size_t markupEnd = SkipMarkup(data, position, m_size);
+      if (markupEnd == std::string::npos)
+      {
+        return false;
+      }
+      if (markupEnd != position)
+      {
+        position = markupEnd;
+        continue;
+      }
+
+      if (position + 1 < m_size && data[position + 1] == '/')
+      {
+        position = SkipPast(data, position + 2, m_size, ">");
+        if (position == std::string::npos)
+        {
+          return false;
+        }
+        if (--depth == 0)
+        {
+          // End of the root element
+          return true;
+        }
+        continue;
+      }
+
+      size_t nameStart = position + 1;
+      size_t nameEnd = nameStart;
+      while (nameEnd < m_size && IsNameChar(data[nameEnd]))
+      {
+        ++nameEnd;
+      }
+
+      position = ParseAttributes(nameEnd, attributes, selfClosing);
+      if (position == std::string::npos)
+      {
+        return false;
+      }
+
+      bool isChildOfRoot = depth == 1;
+      if (!selfClosing)
+      {
+        ++depth;
+      }
+
+      if (!isChildOfRoot || nameEnd - nameStart != fieldTagLength || memcmp(data + nameStart, CUSTOM_FRAME_FIELD_TAG, fieldTagLength) != 0)
+      {
+        continue;
+      }
+
+      Entry field = { 0, 0, 0, 0, false };
+      bool hasName(false);
+      for (auto& attribute : attributes)
+      {
+        if (RawEquals(attribute.NameOffset, attribute.NameLength, "Name"))
+        {
+          field.NameOffset = attribute.ValueOffset;
+          field.NameLength = attribute.ValueLength;
+          hasName = true;
+        }
+        else if (RawEquals(attribute.NameOffset, attribute.NameLength, "Value"))
+        {
+          field.ValueOffset = attribute.ValueOffset;
+          field.ValueLength = attribute.ValueLength;
+        }
+      }
+      if (hasName)
+      {
+        field.IsTransform = EndsWith(data + field.NameOffset, field.NameLength, TRANSFORM_POSTFIX) ||
+                            EndsWith(data + field.NameOffset, field.NameLength, TRANSFORM_STATUS_POSTFIX);
+        m_fields.push_back(field);
+      }
+    }
+
+    return false;
+  }
+
+  //----------------------------------------------------------------------------
+  void FrameFieldTable::Rebind(std::shared_ptr<const char> xml)
+  {
+    m_xml = xml;
+  }
+
+  //----------------------------------------------------------------------------
+  const char* FrameFieldTable::GetData() const
+  {
+    return m_xml.get();
+  }
+
+  //----------------------------------------------------------------------------
+  size_t FrameFieldTable::ParseAttributes(size_t position, std::vector<Entry>& attributes, bool& selfClosing) const
+  {
+    const char* data = m_xml.get();
+    attributes.clear();
+    selfClosing = false;
+
+    while (position < m_size)
+    {
+      while (position < m_size && IsXmlSpace(data[position]))
+      {
+        ++position;
+      }
+      if (position >= m_size)
+      {
+        break;
+      }
+      if (data[position] == '>')
+      {
+        return position + 1;
+      }
+      if (data[position] == '/' || data[position] == '?')
+      {
+        if (position + 1 < m_size && data[position + 1] == '>')
+        {
+          selfClosing = true;
+          return position + 2;
+        }
+        return std::string::npos;
+      }
+
+      Entry attribute = { static_cast<uint32>(position), 0, 0, 0, false };
+      while (position < m_size && IsNameChar(data[position]))
+      {
+        ++position;
+      }
+      attribute.NameLength = static_cast<uint32>(position - attribute.NameOffset);
+
+      while (position < m_size && IsXmlSpace(data[position]))
+      {
+        ++position;
+      }
+      if (attribute.NameLength == 0 || position >= m_size || data[position] != '=')
+      {
+        return std::string::npos;
+      }
+      ++position;
+      while (position < m_size && IsXmlSpace(data[position]))
+      {
+        ++position;
+      }
+      if (position >= m_size || (data[position] != '"' && data[position] != '\''))
+      {
+        return std::string::npos;
+      }
+
+      char quote = data[position++];
+      attribute.ValueOffset = static_cast<uint32>(position);
+      const char* valueEnd = static_cast<const char*>(memchr(data + position, quote, m_size - position));
+      if (valueEnd == nullptr)
+      {
+        return std::string::npos;
+      }
+      position = valueEnd - data;
+      attribute.ValueLength = static_cast<uint32>(position - attribute.ValueOffset);
+      ++position;
+
+      attributes.push_back(attribute);
+    }
+
+    return std::string::npos;
+  }
+
+  //----------------------------------------------------------------------------
+  bool FrameFieldTable::GetRootAttribute(const std::string& name, std::string& value) const
+  {
+    for (auto& attribute : m_rootAttributes)
+    {
+      if (RawEquals(attribute.NameOffset, attribute.NameLength, name))
+      {
+        value = Decode(attribute.ValueOffset, attribute.ValueLength);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  //----------------------------------------------------------------------------
+  size_t FrameFieldTable::GetFieldCount() const
+  {
+    return m_fields.size();
+  }
+
+  //----------------------------------------------------------------------------
+  std::string FrameFieldTable::GetFieldName(size_t index) const
+  {
+    return Decode(m_fields[index].NameOffset, m_fields[index].NameLength);
+  }
+
+  //----------------------------------------------------------------------------
+  std::string FrameFieldTable::GetFieldValue(size_t index) const
+  {
+    return Decode(m_fields[index].ValueOffset, m_fields[index].ValueLength);
+  }
+
+  //----------------------------------------------------------------------------
+  size_t FrameFieldTable::FindField(const std::string& name) const
+  {
+    for (size_t i = 0; i < m_fields.size(); ++i)
+    {
+      const Entry& field = m_fields[i];
+      if (memchr(m_xml.get() + field.NameOffset, '&', field.NameLength) == nullptr)
+      {
+        if (RawEquals(field.NameOffset, field.NameLength, name))
+        {
+          return i;
+        }
+      }
+      else if (Decode(field.NameOffset, field.NameLength) == name)
+      {
+        return i;
+      }
+    }
+    return m_fields.size();
+  }
+
+  //----------------------------------------------------------------------------
+  std::wstring FrameFieldTable::GetWideFieldName(size_t index) const
+  {
+    return DecodeWide(m_fields[index].NameOffset, m_fields[index].NameLength);
+  }
+
+  //----------------------------------------------------------------------------
+  std::wstring FrameFieldTable::GetWideFieldValue(size_t index) const
+  {
+    return DecodeWide(m_fields[index].ValueOffset, m_fields[index].ValueLength);
+  }
+
+  //----------------------------------------------------------------------------
+  size_t FrameFieldTable::FindField(const std::wstring& name) const
+  {
+    for (size_t i = 0; i < m_fields.size(); ++i)
+    {
+      if (GetWideFieldName(i) == name)
+      {
+        return i;
+      }
+    }
+    return m_fields.size();
+  }
+
+  //----------------------------------------------------------------------------
+  bool FrameFieldTable::IsTransformField(size_t index) const
+  {
+    return m_fields[index].IsTransform;
+  }
+
+  //----------------------------------------------------------------------------
+  void FrameFieldTable::GetFields(FrameFields& fields) const
+  {
+    for (size_t i = 0; i < m_fields.size(); ++i)
+    {
+      if (m_fields[i].IsTransform)
+      {
+        continue;
+      }
+      fields[GetWideFieldName(i)] = GetWideFieldValue(i);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  bool FrameFieldTable::RawEquals(uint32 offset, uint32 length, const std::string& value) const
+  {
+    return length == value.size() && memcmp(m_xml.get() + offset, value.data(), length) == 0;
+  }
+
+  //----------------------------------------------------------------------------
+  std::string FrameFieldTable::Decode(uint32 offset, uint32 length) const
+  {
+    return DecodeEntities<std::string>(m_xml.get() + offset, length);
+  }
+
+  //----------------------------------------------------------------------------
+  std::wstring FrameFieldTable::DecodeWide(uint32 offset, uint32 length) const
+  {
+    return DecodeEntities<std::wstring>(m_xml.get() + offset, length);
+  }
+}
@@ -0,0 +1,93 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+#pragma once
+
+// Local includes
+#include "IGTCommon.h"
+
+// STL includes
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace UWPOpenIGTLink
+{
+  /// Offset table over the raw xml description of a TRACKEDFRAME message
+  /// Building the table only records where each attribute and CustomFrameField lives in the xml, names and values are
+  /// unescaped and widened when they are accessed. The table shares ownership of the xml bytes.
+  class FrameFieldTable
+  {
+  public:
+    FrameFieldTable();
+
+    /// Scan the <TrackedFrame> element, returns false if the xml is not a tracked frame description
+    /// Comments, processing instructions and elements nested below the CustomFrameField children are skipped
+    bool Parse(std::shared_ptr<const char> xml, size_t size);
+
+    /// Point the table at another owner of the same xml bytes
+    void Rebind(std::shared_ptr<const char> xml);
+    const char* GetData() const;
+
+    /// Attributes of the <TrackedFrame> element
+    bool GetRootAttribute(const std::string& name, std::string& value) const;
+
+    /// CustomFrameField elements, in document order
+    size_t GetFieldCount() const;
+    std::string GetFieldName(size_t index) const;
+    std::string GetFieldValue(size_t index) const;
+    /// Wide variants, character references are converted to UTF-16 rather than UTF-8
+    std::wstring GetWideFieldName(size_t index) const;
+    std::wstring GetWideFieldValue(size_t index) const;
+    /// Returns the index of the field named name, or GetFieldCount() if there is none
+    size_t FindField(const std::string& name) const;
+    size_t FindField(const std::wstring& name) const;
+
+    /// Returns true if the field holds a transform or transform status, these are converted to frame transforms rather than exposed as fields
+    bool IsTransformField(size_t index) const;
+
+    /// Decode every field that is not a transform field
+    void GetFields(FrameFields& fields) const;
+
+  protected:
+    struct Entry
+    {
+      uint32  NameOffset;
+      uint32  NameLength;
+      uint32  ValueOffset;
+      uint32  ValueLength;
+      bool    IsTransform;
+    };
+
+    /// Parse the attributes of the element whose name ends at position, returns the position after the element's tag
+    size_t ParseAttributes(size_t position, std::vector<Entry>& attributes, bool& selfClosing) const;
+    std::string Decode(uint32 offset, uint32 length) const;
+    std::wstring DecodeWide(uint32 offset, uint32 length) const;
+    bool RawEquals(uint32 offset, uint32 length, const std::string& value) const;
+
+    std::shared_ptr<const char>   m_xml = nullptr;
+    size_t                        m_size = 0;
+    std::vector<Entry>            m_rootAttributes;
+    std::vector<Entry>            m_fields;
+  };
+}
@@ -0,0 +1,208 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+// Local includes
+#include "pch.h"
+#include "HalfFloat.h"
+#include "PixelConversion.h"
+
+// STL includes
+#include <cstring>
+
+#if defined(_M_IX86) || defined(_M_X64)
+  #define HALF_FLOAT_X86
+  #include <intrin.h>
+  #include <immintrin.h>
+#elif defined(_M_ARM64)
+  #define HALF_FLOAT_NEON
+  #include <arm_neon.h>
+#endif
+
+namespace UWPOpenIGTLink
+{
+  namespace
+  {
+#if defined(HALF_FLOAT_X86)
+    //----------------------------------------------------------------------------
+    // Every CPU with AVX2 has shipped with F16C, the flag is checked anyway and the PixelConversion level lets the scalar code be compared
+    bool IsF16CEnabled()
+    {
+      static const bool supported = []()
+      {
+        int info[4] = { 0 };
+        __cpuid(info, 1);
+        return (info[2] & (1 << 29)) != 0;
+      }();
+      return supported && PixelConversion::GetInstructionSetLevel() >= PIXEL_CONVERSION_ISA_AVX2;
+    }
+
+    //----------------------------------------------------------------------------
+    // Returns the number of leading values converted, the caller converts the rest
+    size_t Float32ToFloat16F16C(const float* source, uint16_t* destination, size_t count)
+    {
+      size_t i = 0;
+      for (; i + 8 <= count; i += 8)
+      {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm256_cvtps_ph(_mm256_loadu_ps(source + i), _MM_FROUND_TO_NEAREST_INT));
+      }
+      return i;
+    }
+
+    //----------------------------------------------------------------------------
+    size_t Float16ToFloat32F16C(const uint16_t* source, float* destination, size_t count)
+    {
+      size_t i = 0;
+      for (; i + 8 <= count; i += 8)
+      {
+        _mm256_storeu_ps(destination + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i))));
+      }
+      return i;
+    }
+#endif
+
+#if defined(HALF_FLOAT_NEON)
+    //----------------------------------------------------------------------------
+    size_t Float32ToFloat16NEON(const float* source, uint16_t* destination, size_t count)
+    {
+      size_t i = 0;
+      for (; i + 4 <= count; i += 4)
+      {
+        vst1_u16(destination + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(source + i))));
+      }
+      return i;
+    }
+
+    //----------------------------------------------------------------------------
+    size_t Float16ToFloat32NEON(const uint16_t* source, float* destination, size_t count)
+    {
+      size_t i = 0;
+      for (; i + 4 <= count; i += 4)
+      {
+        vst1q_f32(destination + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(source + i))));
+      }
+      return i;
+    }
+#endif
+  }
+
+  //----------------------------------------------------------------------------
+  void ConvertFloat32ToFloat16(const float* source, uint16_t* destination, size_t count)
+  {
+    size_t i = 0;
+#if defined(HALF_FLOAT_X86)
+    if (IsF16CEnabled())
+    {
+      i = Float32ToFloat16F16C(source, destination, count);
+    }
+#elif defined(HALF_FLOAT_NEON)
+    i = Float32ToFloat16NEON(source, destination, count);
+#endif
+    for (; i < count; ++i)
+    {
+      destination[i] = Float32ToFloat16(source[i]);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  void ConvertFloat16ToFloat32(const uint16_t* source, float* destination, size_t count)
+  {
+    size_t i = 0;
+#if defined(HALF_FLOAT_X86)
+    if (IsF16CEnabled())
+    {
+      i = Float16ToFloat32F16C(source, destination, count);
+    }
+#elif defined(HALF_FLOAT_NEON)
+    i = Float16ToFloat32NEON(source, destination, count);
+#endif
+    for (; i < count; ++i)
+    {
+      destination[i] = Float16ToFloat32(source[i]);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  uint16_t Float32ToFloat16(float value)
+  {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    bits &= 0x7FFFFFFF;
+
+    if (bits >= 0x7F800000)
+    {
+      // Infinity stays infinity, NaN keeps the top of its payload and becomes quiet
+      return sign | (bits > 0x7F800000 ? static_cast<uint16_t>(0x7E00 | ((bits >> 13) & 0x3FF)) : 0x7C00);
+    }
+    if (bits >= 0x477FF000)
+    {
+      // 65520 and above round to infinity
+      return sign | 0x7C00;
+    }
+    if (bits < 0x38800000)
+    {
+      // Below the smallest normal half, adding 0.5 lets the FPU round the value to a multiple of 2^-24 (ties to even)
+      float shifted;
+      memcpy(&shifted, &bits, sizeof(shifted));
+      shifted += 0.5f;
+      uint32_t shiftedBits;
+      memcpy(&shiftedBits, &shifted, sizeof(shiftedBits));
+      return sign | static_cast<uint16_t>(shiftedBits - 0x3F000000);
+    }
+
+    // Rebias the exponent and round the significand to 10 bits, ties to even. A carry into the exponent is the correct result.
+    const uint32_t odd = (bits >> 13) & 1;
+    bits += 0xC8000FFF + odd;
+    return sign | static_cast<uint16_t>(bits >> 13);
+  }
+
+  //----------------------------------------------------------------------------
+  float Float16ToFloat32(uint16_t value)
+  {
+    const uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+    const uint32_t exponent = (value >> 10) & 0x1F;
+    const uint32_t mantissa = value & 0x3FF;
+
+    uint32_t bits;
+    if (exponent == 0x1F)
+    {
+      // Infinity, or NaN made quiet as the vector instructions do
+      bits = sign | 0x7F800000 | (mantissa << 13) | (mantissa != 0 ? 0x00400000 : 0);
+    }
+    else if (exponent != 0)
+    {
+      bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    else
+    {
+      // Zero or subnormal, mantissa * 2^-24 is exact in float32
+      const float magnitude = static_cast<float>(mantissa) * (1.0f / 16777216.0f);
+      memcpy(&bits, &magnitude, sizeof(bits));
+      bits |= sign;
+    }
+
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+  }
+}
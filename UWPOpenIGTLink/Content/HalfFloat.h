@@ -0,0 +1,57 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+#pragma once
+
+// STL includes
+#include <cstddef>
+#include <cstdint>
+
+namespace UWPOpenIGTLink
+{
+  /*!
+    IEEE 754 half precision (IGTL_SCALARTYPE_FLOAT16) conversion.
+    Half values have an 11 bit significand (relative error at most 2^-11 after rounding) and a range of +-65504.
+    F16C is used on x86 CPUs that support AVX2, NEON on ARM64, bit exact scalar code otherwise.
+  */
+
+  /// Round count float32 values to the nearest half (ties to even), values beyond the half range become infinity
+  void ConvertFloat32ToFloat16(const float* source, uint16_t* destination, size_t count);
+
+  /// Widen count half values to float32, the conversion is exact
+  void ConvertFloat16ToFloat32(const uint16_t* source, float* destination, size_t count);
+
+  /// Scalar conversions of a single value, these match the vector kernels bit for bit
+  uint16_t Float32ToFloat16(float value);
+  float Float16ToFloat32(uint16_t value);
+
+  /// A half value as stored in an image, e.g. ImageView<Float16>. Reads and writes convert through float32.
+  struct Float16
+  {
+    uint16_t Bits;
+
+    Float16() = default;
+    Float16(float value) : Bits(Float32ToFloat16(value)) {}
+    operator float() const { return Float16ToFloat32(Bits); }
+  };
+}
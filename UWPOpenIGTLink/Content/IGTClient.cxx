@@ -26,8 +26,13 @@ OTHER DEALINGS IN THE SOFTWARE.
 
 // Local includes
 #include "pch.h"
+#include "ContentHash.h"
 #include "IGTClient.h"
 #include "IGTCommon.h"
+#include "ImageBufferPool.h"
+#include "ImageCodec.h"
+#include "ImagePyramid.h"
+#include "NativeBuffer.h"
 #include "TrackedFrameMessage.h"
 
 // IGT includes
@@ -38,6 +43,8 @@ OTHER DEALINGS IN THE SOFTWARE.
 #include <igtlOSUtil.h>
 #include <igtlPolyDataMessage.h>
 #include <igtlStatusMessage.h>
+#include <igtlutil/igtl_header.h>
+#include <igtlutil/igtl_util.h>
 
 // STL includes
 #include <chrono>
@@ -66,6 +73,61 @@ namespace UWPOpenIGTLink
   namespace
   {
     static const double NEGLIGIBLE_DIFFERENCE = 0.0001;
+    static const int TRACKEDFRAME_RECEIVE_CHUNK_SIZE = 256 * 1024;
+
+    //----------------------------------------------------------------------------
+    igtl_uint64 GetHeaderBodyCRC(igtl::MessageHeader* headerMsg)
+    {
+      // Unpack has already converted the header to host byte order in place
+      igtl_header header;
+      memcpy(&header, headerMsg->GetBufferPointer(), IGTL_HEADER_SIZE);
+      return header.crc;
+    }
+
+    //----------------------------------------------------------------------------
+    // Size the scalars from the dimensions rather than trusting the message, which computes it in 32 bits
+    bool GetImageMessageSize(igtl::ImageMessage* imgMsg, FrameSize& outFrameSize, uint64& outImageSize)
+    {
+      std::array<int32, 3> frameSize;
+      imgMsg->GetDimensions(frameSize[0], frameSize[1], frameSize[2]);
+      if (frameSize[0] <= 0 || frameSize[1] <= 0 || frameSize[2] <= 0)
+      {
+        return false;
+      }
+      outFrameSize = { static_cast<uint32>(frameSize[0]), static_cast<uint32>(frameSize[1]), static_cast<uint32>(frameSize[2]) };
+      return Image::ComputeImageSizeBytes(outFrameSize, static_cast<uint16>(imgMsg->GetNumComponents()), (IGTL_SCALAR_TYPE)imgMsg->GetScalarType(), outImageSize);
+    }
+
+    //----------------------------------------------------------------------------
+    // Decode the compressed scalars of an IMAGE message into a pooled buffer, nullptr if they are malformed
+    std::shared_ptr<byte> DecompressImageScalars(igtl::ImageMessage* imgMsg, const std::string& compression)
+    {
+      FrameSize frameSize;
+      uint64 imageSize(0);
+      std::string compressedSizeStr;
+      uint32 compressedSize(0);
+      if (!GetImageMessageSize(imgMsg, frameSize, imageSize) || !IsEqualInsensitive(compression, IMAGE_COMPRESSION_LZ4) ||
+          !imgMsg->GetMetaDataElement(COMPRESSED_IMAGE_SIZE_METADATA_KEY, compressedSizeStr) ||
+          ParseNumber(compressedSizeStr.data(), compressedSizeStr.data() + compressedSizeStr.size(), compressedSize) == compressedSizeStr.data())
+      {
+        return nullptr;
+      }
+
+      // The compressed size comes from the peer, it must fit in the body
+      byte* scalars = static_cast<byte*>(imgMsg->GetScalarPointer());
+      byte* bodyEnd = static_cast<byte*>(imgMsg->GetBufferBodyPointer()) + imgMsg->GetBufferBodySize();
+      if (compressedSize > static_cast<size_t>(bodyEnd - scalars))
+      {
+        return nullptr;
+      }
+
+      auto imgData = ImageBufferPool::GetInstance()->Acquire(static_cast<size_t>(imageSize));
+      if (imgData == nullptr || !LZ4Decompress(scalars, compressedSize, imgData.get(), static_cast<size_t>(imageSize)))
+      {
+        return nullptr;
+      }
+      return imgData;
+    }
   }
   const int IGTClient::CLIENT_SOCKET_TIMEOUT_MSEC = 500;
   // TODO tune
@@ -80,6 +142,7 @@ namespace UWPOpenIGTLink
   IGTClient::IGTClient()
   {
     m_igtlMessageFactory->AddMessageType("TRACKEDFRAME", (igtl::MessageFactory::PointerToMessageBaseNew)&igtl::TrackedFrameMessage::New);
+    m_igtlMessageFactory->AddMessageType("TDATA", (igtl::MessageFactory::PointerToMessageBaseNew)&igtl::TrackingDataPoseMessage::New);
 
     m_clientSocket->Control->KeepAlive = true;
     m_clientSocket->Control->NoDelay = false; // true => accumulate data until enough has been queued to occupy a full TCP/IP packet
@@ -136,6 +199,7 @@ namespace UWPOpenIGTLink
             std::lock_guard<std::mutex> guard(m_socketMutex);
             m_sendStream = nullptr;
             m_readStream = nullptr;
+            m_sendDeltaStreams.clear();
             delete m_clientSocket;
 
             // Recreate blank socket
@@ -190,7 +254,8 @@ namespace UWPOpenIGTLink
 
     auto frame = ref new TrackedFrame();
 
-    // Fields
+    // Fields, the frame's own fields are decoded when they are read
+    frame->SetFrameFieldTable(trackedFrameMsg->GetFrameFields());
     for (auto& pair : trackedFrameMsg->GetMetaData())
     {
       std::wstring keyWideStr(pair.first.begin(), pair.first.end());
@@ -199,10 +264,13 @@ namespace UWPOpenIGTLink
     }
 
     // Image
-    std::array<uint16, 3> frameSize = { trackedFrameMsg->GetFrameSize()[0], trackedFrameMsg->GetFrameSize()[1], trackedFrameMsg->GetFrameSize()[2] };
+    FrameSize frameSize = { trackedFrameMsg->GetFrameSize()[0], trackedFrameMsg->GetFrameSize()[1], trackedFrameMsg->GetFrameSize()[2] };
     frame->Frame->SetImageData(trackedFrameMsg->GetImage(), trackedFrameMsg->GetNumberOfComponents(), trackedFrameMsg->GetScalarType(), frameSize);
+    frame->Frame->Image->SetPyramid(trackedFrameMsg->GetImagePyramid());
     frame->Frame->Type = (uint16)trackedFrameMsg->GetImageType();
     frame->Frame->Orientation = (uint16)trackedFrameMsg->GetImageOrientation();
+    frame->ImageContentHash = trackedFrameMsg->GetImageContentHash();
+    frame->IsDuplicate = trackedFrameMsg->IsImageDuplicate();
 
     // Transforms
     frame->SetFrameTransformsInternal(trackedFrameMsg->GetFrameTransforms());
@@ -221,6 +289,7 @@ namespace UWPOpenIGTLink
   UWPOpenIGTLink::VideoFrame^ IGTClient::GetImage(double lastKnownTimestamp)
   {
     igtl::ImageMessage::Pointer imgMsg = nullptr;
+    std::shared_ptr<byte> decodedScalars = nullptr;
     {
       // Retrieve the next available image message
       std::lock_guard<std::mutex> guard(m_receivedMessagesMutex);
@@ -229,6 +298,7 @@ namespace UWPOpenIGTLink
         return nullptr;
       }
       imgMsg = dynamic_cast<igtl::ImageMessage*>(m_receivedImageMessages.rbegin()->GetPointer());
+      decodedScalars = *m_receivedImageScalars.rbegin();
     }
 
     auto ts = igtl::TimeStamp::New();
@@ -242,14 +312,27 @@ namespace UWPOpenIGTLink
     auto frame = ref new VideoFrame();
 
     // Image
-    std::array<int32, 3> frameSize;
-    imgMsg->GetDimensions(frameSize[0], frameSize[1], frameSize[2]);
-    std::array<uint16, 3> frameSizeUint;
-    frameSizeUint[0] = static_cast<uint16>(frameSize[0]); // We are guaranteed that these will fit as the underlying image message stores image size as uint16 (interface shouldn't use int32)
-    frameSizeUint[1] = static_cast<uint16>(frameSize[1]);
-    frameSizeUint[2] = static_cast<uint16>(frameSize[2]);
-    std::shared_ptr<byte> imgData = std::shared_ptr<byte>(new byte[imgMsg->GetImageSize()], [](byte * p) {delete[] p; });
-    memcpy((void*)imgData.get(), imgMsg->GetScalarPointer(), imgMsg->GetImageSize());
+    FrameSize frameSizeUint;
+    uint64 imageSize(0);
+    if (!GetImageMessageSize(imgMsg, frameSizeUint, imageSize))
+    {
+      return nullptr;
+    }
+
+    // Compressed scalars were decoded by the receiver pump
+    std::shared_ptr<byte> imgData = decodedScalars;
+    if (imgData == nullptr)
+    {
+      // Alias the pixels in the message body rather than copying them, the message stays alive while the image is referenced
+      byte* scalars = static_cast<byte*>(imgMsg->GetScalarPointer());
+      byte* bodyEnd = static_cast<byte*>(imgMsg->GetBufferBodyPointer()) + imgMsg->GetBufferBodySize();
+      if (imageSize > static_cast<uint64>(bodyEnd - scalars))
+      {
+        return nullptr;
+      }
+      auto owner = std::make_shared<igtl::ImageMessage::Pointer>(imgMsg);
+      imgData = std::shared_ptr<byte>(owner, static_cast<byte*>(imgMsg->GetScalarPointer()));
+    }
 
     frame->SetImageData(imgData, static_cast<uint16>(imgMsg->GetNumComponents()), (IGTL_SCALAR_TYPE)imgMsg->GetScalarType(), frameSizeUint);
     frame->Type = US_IMG_BRIGHTNESS; // Not perfect, but this data isn't transmitted with an image message, could check metadata?
@@ -334,7 +417,7 @@ namespace UWPOpenIGTLink
   //----------------------------------------------------------------------------
   TransformListABI^ IGTClient::GetTDataFrame(double lastKnownTimestamp)
   {
-    igtl::TrackingDataMessage::Pointer tdataMsg(nullptr);
+    igtl::TrackingDataPoseMessage::Pointer tdataMsg(nullptr);
     {
       // Retrieve the next available TDATA message
       std::lock_guard<std::mutex> guard(m_receivedMessagesMutex);
@@ -342,7 +425,7 @@ namespace UWPOpenIGTLink
       {
         return nullptr;
       }
-      tdataMsg = dynamic_cast<igtl::TrackingDataMessage*>(m_receivedTDataMessages.rbegin()->GetPointer());
+      tdataMsg = dynamic_cast<igtl::TrackingDataPoseMessage*>(m_receivedTDataMessages.rbegin()->GetPointer());
     }
 
     auto ts = igtl::TimeStamp::New();
@@ -355,13 +438,11 @@ namespace UWPOpenIGTLink
 
     auto frame = ref new Vector<Transform^>();
 
-    auto element = igtl::TrackingDataElement::New();
-    igtl::Matrix4x4 mat;
-    for (auto i = 0; i < tdataMsg->GetNumberOfTrackingDataElements(); ++i)
+    // Poses were byte swapped, scaled and laid out as float4x4 when the message was unpacked
+    for (size_t i = 0; i < tdataMsg->GetNumberOfPoses(); ++i)
     {
       auto transform = ref new Transform();
-      tdataMsg->GetTrackingDataElement(i, element);
-      auto name = std::string(element->GetName());
+      auto& name = tdataMsg->GetPoseName(i);
       TransformName^ transformName(nullptr);
       try
       {
@@ -373,9 +454,7 @@ namespace UWPOpenIGTLink
         ErrorMessage(this, L"Transform being sent from IGT server has an invalid name.");
         continue;
       }
-      element->GetMatrix(mat);
-      float4x4 matrix;
-      XMStoreFloat4x4(&matrix, XMLoadFloat4x4(&DirectX::XMFLOAT4X4(&mat[0][0])));
+      const float4x4& matrix = tdataMsg->GetPose(i);
 
       transform->Name = transformName;
       transform->Matrix = matrix;
@@ -676,50 +755,43 @@ namespace UWPOpenIGTLink
       if (IsEqualInsensitive(key, "Ka"))
       {
         float4 amb(0.f, 0.f, 0.f, 1.f);
-        std::istringstream ss(val);
-        ss >> amb.x >> amb.y >> amb.z;
+        ParseFloats(val, &amb.x, 3);
         polydata->Mat->Ambient = amb;
       }
       else if (IsEqualInsensitive(key, "Kd"))
       {
         float4 diffuse(0.f, 0.f, 0.f, 1.f);
-        std::istringstream ss(val);
-        ss >> diffuse.x >> diffuse.y >> diffuse.z;
+        ParseFloats(val, &diffuse.x, 3);
         polydata->Mat->Diffuse = diffuse;
       }
       else if (IsEqualInsensitive(key, "Ks"))
       {
         float4 spec(0.f, 0.f, 0.f, 1.f);
-        std::istringstream ss(val);
-        ss >> spec.x >> spec.y >> spec.z;
+        ParseFloats(val, &spec.x, 3);
         polydata->Mat->Specular = spec;
       }
       else if (IsEqualInsensitive(key, "Ke"))
       {
         float4 emissive(0.f, 0.f, 0.f, 1.f);
-        std::istringstream ss(val);
-        ss >> emissive.x >> emissive.y >> emissive.z;
+        ParseFloats(val, &emissive.x, 3);
         polydata->Mat->Emissive = emissive;
       }
       else if (IsEqualInsensitive(key, "Tr"))
       {
-        float transparency;
-        std::istringstream ss(val);
-        ss >> transparency;
+        float transparency(0.f);
+        ParseFloats(val, &transparency, 1);
         polydata->Mat->Transparency = transparency;
       }
       else if (IsEqualInsensitive(key, "illum"))
       {
-        int32 model;
-        std::istringstream ss(val);
-        ss >> model;
+        int32 model(0);
+        ParseNumber(val.data(), val.data() + val.size(), model);
         polydata->Mat->Model = static_cast<IlluminationModel>(model);
       }
       else if (IsEqualInsensitive(key, "Ns"))
       {
-        float specExp;
-        std::istringstream ss(val);
-        ss >> specExp;
+        float specExp(0.f);
+        ParseFloats(val, &specExp, 1);
         polydata->Mat->SpecularExponent = specExp;
       }
     }
@@ -736,21 +808,128 @@ namespace UWPOpenIGTLink
       return task_from_result(false);
     }
 
+    auto trackedFrameMessage = dynamic_cast<igtl::TrackedFrameMessage*>(packedMessage.GetPointer());
+    if (trackedFrameMessage != nullptr)
+    {
+      return SendTrackedFrameMessageAsyncInternal(trackedFrameMessage);
+    }
+
     std::lock_guard<std::mutex> guard(m_socketMutex);
-    m_sendStream->WriteBytes(Platform::ArrayReference<byte>((byte*)packedMessage->GetBufferPointer(), packedMessage->GetBufferSize()));
-    return create_task(m_sendStream->StoreAsync()).then([size = packedMessage->GetBufferSize()](task<uint32> writeTask)
+    return QueueSend([this, packedMessage]()
+    {
+      m_sendStream->WriteBytes(Platform::ArrayReference<byte>((byte*)packedMessage->GetBufferPointer(), packedMessage->GetBufferSize()));
+      return create_task(m_sendStream->StoreAsync()).then([size = packedMessage->GetBufferSize()](task<uint32> writeTask)
+      {
+        uint32 bytesWritten;
+        try
+        {
+          bytesWritten = writeTask.get();
+          return bytesWritten == size;
+        }
+        catch (Platform::Exception^ exception)
+        {
+          return false;
+        }
+      });
+    });
+  }
+
+  //----------------------------------------------------------------------------
+  task<bool> IGTClient::SendTrackedFrameMessageAsyncInternal(igtl::TrackedFrameMessage* trackedFrameMessage)
+  {
+    if (IsServerCapabilityAdvertised(igtl::TrackedFrameMessage::CAPABILITY_BINARY_TRANSFORMS))
+    {
+      trackedFrameMessage->SetBinaryTransformsEnabled(true);
+    }
+    if (IsServerCapabilityAdvertised(igtl::TrackedFrameMessage::CAPABILITY_LZ4_IMAGE))
+    {
+      trackedFrameMessage->SetImageCompressionEnabled(true);
+    }
+
+    // Packed when its turn to be sent comes, so delta frames are encoded in the order they go out
+    igtl::TrackedFrameMessage::Pointer message = trackedFrameMessage;
+    std::lock_guard<std::mutex> guard(m_socketMutex);
+    return QueueSend([this, message]()
+    {
+      if (IsServerCapabilityAdvertised(igtl::TrackedFrameMessage::CAPABILITY_DELTA_IMAGE))
+      {
+        auto& stream = m_sendDeltaStreams[message->GetDeviceName()];
+        if (stream == nullptr)
+        {
+          stream = std::make_shared<DeltaStreamState>();
+        }
+        stream->KeyFrameInterval = m_deltaKeyFrameInterval;
+        message->SetImageDeltaStream(stream);
+      }
+
+      std::vector<igtl::TrackedFrameMessage::PackedSegment> segments;
+      if (!message->PackSegments(segments))
+      {
+        return task_from_result(false);
+      }
+
+      // An output stream accepts one write at a time, each segment is written once the previous one has completed
+      auto outputStream = m_clientSocket->OutputStream;
+      task<bool> writes = task_from_result(true);
+      for (auto& segment : segments)
+      {
+        auto buffer = CreateNativeBuffer(segment.Data, static_cast<uint32>(segment.Length));
+        if (buffer == nullptr)
+        {
+          return task_from_result(false);
+        }
+        writes = writes.then([outputStream, buffer, length = segment.Length](bool written)
+        {
+          if (!written)
+          {
+            return task_from_result(false);
+          }
+          return create_task(outputStream->WriteAsync(buffer)).then([length](uint32 bytesWritten)
+          {
+            return bytesWritten == length;
+          });
+        });
+      }
+
+      return writes.then([message](task<bool> writeTask)
+      {
+        bool sent(false);
+        try
+        {
+          sent = writeTask.get();
+        }
+        catch (Platform::Exception^ exception)
+        {
+        }
+
+        // Still within the queued send, the next message of the stream is encoded against this one
+        message->CommitImageDelta(sent);
+        return sent;
+      });
+    });
+  }
+
+  //----------------------------------------------------------------------------
+  task<bool> IGTClient::QueueSend(std::function<task<bool>()> send)
+  {
+    auto sendTask = m_sendQueue.then([this, send](task<void>)
+    {
+      std::lock_guard<std::mutex> guard(m_socketMutex);
+      return send();
+    });
+
+    // The next send only waits for this one to complete, its result and exceptions belong to the caller
+    m_sendQueue = sendTask.then([](task<bool> previousTask)
     {
-      uint32 bytesWritten;
       try
       {
-        bytesWritten = writeTask.get();
-        return bytesWritten == size;
+        previousTask.wait();
       }
-      catch (Platform::Exception^ exception)
+      catch (...)
       {
-        return false;
       }
     });
+    return sendTask;
   }
 
   //----------------------------------------------------------------------------
@@ -760,14 +939,18 @@ namespace UWPOpenIGTLink
     packedMessage->SetCommandId(m_nextQueryId);
 
     std::lock_guard<std::mutex> guard(m_socketMutex);
-    m_sendStream->WriteBytes(Platform::ArrayReference<byte>((byte*)packedMessage->GetBufferPointer(), packedMessage->GetBufferSize()));
-    return create_task(m_sendStream->StoreAsync()).then([this, size = packedMessage->GetBufferSize()](task<uint32> writeTask)
+    return QueueSend([this, packedMessage]()
+    {
+      m_sendStream->WriteBytes(Platform::ArrayReference<byte>((byte*)packedMessage->GetBufferPointer(), packedMessage->GetBufferSize()));
+      return create_task(m_sendStream->StoreAsync()).then([size = packedMessage->GetBufferSize()](uint32 bytesWritten)
+      {
+        return bytesWritten == size;
+      });
+    }).then([this](task<bool> sendTask)
     {
-      uint32 bytesWritten;
       try
       {
-        bytesWritten = writeTask.get();
-        bool success = (bytesWritten == size);
+        bool success = sendTask.get();
 
         std::lock_guard<std::mutex> guard(m_queriesMutex);
         m_outstandingQueries.push_back(m_nextQueryId++);
@@ -840,6 +1023,11 @@ namespace UWPOpenIGTLink
       std::string cmdContent(begin(wCmdContent), end(wCmdContent));
       commandMessage->SetCommandContent(cmdContent);
 
+      // Let the server know which optional TRACKEDFRAME encodings we can decode
+      igtl::TrackedFrameMessage::AdvertiseCapability(commandMessage, igtl::TrackedFrameMessage::CAPABILITY_BINARY_TRANSFORMS);
+      igtl::TrackedFrameMessage::AdvertiseCapability(commandMessage, igtl::TrackedFrameMessage::CAPABILITY_LZ4_IMAGE);
+      igtl::TrackedFrameMessage::AdvertiseCapability(commandMessage, igtl::TrackedFrameMessage::CAPABILITY_DELTA_IMAGE);
+
       return SendCommandAsyncInternal(commandMessage);
     });
   }
@@ -858,6 +1046,10 @@ namespace UWPOpenIGTLink
     auto headerMsg = m_igtlMessageFactory->CreateHeaderMessage(IGTL_HEADER_VERSION_1);
     auto token = m_receiverPumpTokenSource.get_token();
 
+    // A new connection starts new delta streams
+    m_receiveDeltaStreams.clear();
+    m_lastImageContentHashes.clear();
+
     while (!token.is_canceled())
     {
       headerMsg->InitBuffer();
@@ -909,16 +1101,111 @@ namespace UWPOpenIGTLink
       // Accept all messages but status messages, they are used as a keep alive mechanism
       if (typeid(*bodyMsg) == typeid(igtl::TrackedFrameMessage))
       {
-        SocketReceive(bodyMsg->GetBufferBodyPointer(), bodyMsg->GetBufferBodySize());
+        igtl::TrackedFrameMessage* trackedFrameMessage = (igtl::TrackedFrameMessage*)bodyMsg.GetPointer();
 
-        c = bodyMsg->Unpack(1);
+        // Decode while the body arrives, between chunks (outside the socket lock) the CRC is accumulated and the frame description
+        // parsed as soon as its bytes are in. The pixels are received straight into the body, which the image aliases.
+        byte* body = static_cast<byte*>(bodyMsg->GetBufferBodyPointer());
+        igtl_uint64 crc = crc64(0, 0, 0LL);
+        int crcBytes(0);
+        bool frameDescriptionUnpacked(false);
+        auto bytesReceived = SocketReceive(body, bodyMsg->GetBufferBodySize(), TRACKEDFRAME_RECEIVE_CHUNK_SIZE, [&](int received)
+        {
+          crc = crc64(body + crcBytes, received - crcBytes, crc);
+          crcBytes = received;
+          if (!frameDescriptionUnpacked)
+          {
+            frameDescriptionUnpacked = trackedFrameMessage->UnpackFrameDescription(received);
+          }
+        });
+        if (bytesReceived != bodyMsg->GetBufferBodySize() || crc != GetHeaderBodyCRC(headerMsg))
+        {
+          ErrorMessage(this, L"Failed to receive reply (invalid body)");
+          continue;
+        }
+
+        // CRC already verified
+        auto decodeStart = std::chrono::high_resolution_clock::now();
+        c = bodyMsg->Unpack(0);
         if (!(c & igtl::MessageHeader::UNPACK_BODY))
         {
           ErrorMessage(this, L"Failed to receive reply (invalid body)");
           continue;
         }
 
-        igtl::TrackedFrameMessage* trackedFrameMessage = (igtl::TrackedFrameMessage*)bodyMsg.GetPointer();
+        // Delta encoded images are rebuilt against the previous frame of their stream
+        if (trackedFrameMessage->IsImageDeltaEncoded())
+        {
+          auto& stream = m_receiveDeltaStreams[trackedFrameMessage->GetDeviceName()];
+          if (stream == nullptr)
+          {
+            stream = std::make_shared<DeltaStreamState>();
+          }
+          if (!trackedFrameMessage->DecodeImageDelta(*stream))
+          {
+            WarningMessage(this, L"Delta encoded image received without its reference frame, image dropped until the next key frame.");
+          }
+        }
+
+        m_trackedFrameDecodeMicroseconds += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - decodeStart).count();
+        m_receivedImageBytes += trackedFrameMessage->GetImageSizeInBytes();
+        m_receivedImagePayloadBytes += trackedFrameMessage->GetImagePayloadSize();
+
+        // Devices that resend an unchanged frame are detected by content, before any further work is spent on the frame
+        if (m_detectDuplicateFrames && trackedFrameMessage->GetImage() != nullptr)
+        {
+          // The frame description seeds the hash, identical bytes with a different layout are a different image
+          const igtl_uint16* size = trackedFrameMessage->GetFrameSize();
+          const uint64 seed = (static_cast<uint64>(size[0]) << 48) ^ (static_cast<uint64>(size[1]) << 32) ^ (static_cast<uint64>(size[2]) << 16) ^
+                              (static_cast<uint64>(trackedFrameMessage->GetScalarType()) << 8) ^ trackedFrameMessage->GetNumberOfComponents();
+          const uint64 hash = HashBytes(trackedFrameMessage->GetImage().get(), trackedFrameMessage->GetImageSizeInBytes(), seed);
+
+          auto lastHash = m_lastImageContentHashes.find(trackedFrameMessage->GetDeviceName());
+          const bool duplicate = lastHash != m_lastImageContentHashes.end() && lastHash->second == hash;
+          m_lastImageContentHashes[trackedFrameMessage->GetDeviceName()] = hash;
+          trackedFrameMessage->SetImageContentHash(hash, duplicate);
+
+          if (duplicate)
+          {
+            ++m_duplicateFrameCount;
+            if (m_dropDuplicateFrames)
+            {
+              // Only the image repeats, the tools may still be moving while the scanner is frozen. The frame keeps its transforms and fields.
+              ++m_droppedDuplicateFrameCount;
+              trackedFrameMessage->DropImage();
+            }
+          }
+        }
+
+        // Filter here rather than on the render thread, the pyramid is then generated from the filtered image
+        if (m_speckleFilterEnabled && trackedFrameMessage->GetImage() != nullptr)
+        {
+          const FrameSize frameSize = { trackedFrameMessage->GetFrameSize()[0], trackedFrameMessage->GetFrameSize()[1], trackedFrameMessage->GetFrameSize()[2] };
+          SpeckleFilter::Parameters parameters;
+          parameters.Radius = m_speckleFilterRadius;
+          parameters.Threshold = m_speckleFilterThreshold;
+          uint64 elapsedMicroseconds(0);
+          auto filtered = m_speckleFilter.Filter(trackedFrameMessage->GetImage().get(), frameSize, trackedFrameMessage->GetNumberOfComponents(), trackedFrameMessage->GetScalarType(),
+                                                 parameters, m_speckleFilterLatencyBudget, elapsedMicroseconds);
+          if (filtered != nullptr)
+          {
+            trackedFrameMessage->ReplaceImage(filtered);
+            ++m_speckleFilteredFrameCount;
+            m_speckleFilterMicroseconds += elapsedMicroseconds;
+          }
+          else if (SpeckleFilter::IsFilterSupported(trackedFrameMessage->GetNumberOfComponents(), trackedFrameMessage->GetScalarType()))
+          {
+            ++m_speckleFilterSkippedFrameCount;
+          }
+        }
+
+        // Downsample here rather than on the thread consuming the frame
+        if (m_imagePyramidLevels > 0 && trackedFrameMessage->GetImage() != nullptr)
+        {
+          const FrameSize frameSize = { trackedFrameMessage->GetFrameSize()[0], trackedFrameMessage->GetFrameSize()[1], trackedFrameMessage->GetFrameSize()[2] };
+          trackedFrameMessage->SetImagePyramid(ImagePyramid::Generate(trackedFrameMessage->GetImage().get(), frameSize, trackedFrameMessage->GetNumberOfComponents(),
+                                               trackedFrameMessage->GetScalarType(), (PYRAMID_FILTER)m_imagePyramidFilter.load(), m_imagePyramidLevels));
+        }
 
         // Post process tracked frame to adjust for unit scale
         trackedFrameMessage->ApplyTransformUnitScaling(m_trackerUnitScale);
@@ -927,7 +1214,7 @@ namespace UWPOpenIGTLink
         std::lock_guard<std::mutex> guard(m_receivedMessagesMutex);
         m_receivedTrackedFrameMessages.push_back(bodyMsg);
       }
-      else if (typeid(*bodyMsg) == typeid(igtl::TrackingDataMessage))
+      else if (typeid(*bodyMsg) == typeid(igtl::TrackingDataPoseMessage))
       {
         if (bodyMsg->GetBufferBodySize() == 0)
         {
@@ -935,6 +1222,10 @@ namespace UWPOpenIGTLink
         }
         SocketReceive(bodyMsg->GetBufferBodyPointer(), bodyMsg->GetBufferBodySize());
 
+        // Unit scaling is applied while the poses are decoded
+        auto tdataMessage = (igtl::TrackingDataPoseMessage*)bodyMsg.GetPointer();
+        tdataMessage->SetTranslationScale(m_trackerUnitScale);
+
         c = bodyMsg->Unpack(1);
         if (!(c & igtl::MessageHeader::UNPACK_BODY))
         {
@@ -942,21 +1233,6 @@ namespace UWPOpenIGTLink
           continue;
         }
 
-        auto tdataMessage = (igtl::TrackingDataMessage*)bodyMsg.GetPointer();
-
-        // Post process TDATA to adjust for unit scale
-        auto element = igtl::TrackingDataElement::New();
-        for (int i = 0; i < tdataMessage->GetNumberOfTrackingDataElements(); ++i)
-        {
-          tdataMessage->GetTrackingDataElement(i, element);
-          igtl::Matrix4x4 mat;
-          element->GetMatrix(mat);
-          mat[0][3] = mat[0][3] * m_trackerUnitScale;
-          mat[1][3] = mat[1][3] * m_trackerUnitScale;
-          mat[2][3] = mat[2][3] * m_trackerUnitScale;
-          element->SetMatrix(mat);
-        }
-
         // Save reply
         std::lock_guard<std::mutex> guard(m_receivedMessagesMutex);
         m_receivedTDataMessages.push_back(bodyMsg);
@@ -1043,9 +1319,23 @@ namespace UWPOpenIGTLink
 
         auto imgMsg = (igtl::ImageMessage*)bodyMsg.GetPointer();
 
+        // Compressed scalars are decoded here rather than on the thread consuming the image
+        std::shared_ptr<byte> decodedScalars = nullptr;
+        std::string compression;
+        if (imgMsg->GetMetaDataElement(IMAGE_COMPRESSION_METADATA_KEY, compression))
+        {
+          decodedScalars = DecompressImageScalars(imgMsg, compression);
+          if (decodedScalars == nullptr)
+          {
+            ErrorMessage(this, L"Failed to receive reply (invalid compressed image)");
+            continue;
+          }
+        }
+
         // Save reply
         std::lock_guard<std::mutex> guard(m_receivedMessagesMutex);
         m_receivedImageMessages.push_back(bodyMsg);
+        m_receivedImageScalars.push_back(decodedScalars);
       }
       else
       {
@@ -1055,12 +1345,33 @@ namespace UWPOpenIGTLink
         SocketReceive(nullptr, bodyMsg->GetBodySizeToRead());
       }
 
+      UpdateServerCapabilities(bodyMsg);
       PruneIGTMessages();
     }
 
     return;
   }
 
+  //----------------------------------------------------------------------------
+  bool IGTClient::IsServerCapabilityAdvertised(const std::string& capability) const
+  {
+    std::lock_guard<std::mutex> guard(m_serverCapabilitiesMutex);
+    return igtl::TrackedFrameMessage::IsCapabilityListed(m_serverCapabilities, capability);
+  }
+
+  //----------------------------------------------------------------------------
+  void IGTClient::UpdateServerCapabilities(igtl::MessageBase::Pointer message)
+  {
+    std::string capabilities;
+    if (!message->GetMetaDataElement(igtl::TrackedFrameMessage::CAPABILITIES_METADATA_KEY, capabilities))
+    {
+      return;
+    }
+
+    std::lock_guard<std::mutex> guard(m_serverCapabilitiesMutex);
+    m_serverCapabilities = capabilities;
+  }
+
   //----------------------------------------------------------------------------
   void IGTClient::PruneIGTMessages()
   {
@@ -1070,6 +1381,7 @@ namespace UWPOpenIGTLink
       // erase the front N results
       MessageList::size_type toErase = m_receivedImageMessages.size() - MESSAGE_LIST_IMAGE_MAX_SIZE;
       m_receivedImageMessages.erase(begin(m_receivedImageMessages), begin(m_receivedImageMessages) + toErase);
+      m_receivedImageScalars.erase(begin(m_receivedImageScalars), begin(m_receivedImageScalars) + toErase);
     }
 
     if (m_receivedTrackedFrameMessages.size() > MESSAGE_LIST_TRACKEDFRAME_MAX_SIZE + 4)
@@ -1317,6 +1629,7 @@ namespace UWPOpenIGTLink
       auto buffer = m_readStream->ReadBuffer(size);
       if (dest != nullptr)
       {
+        // The caller parses the bytes straight away, a cached copy beats FastCopy's streaming stores here
         auto header = GetDataFromIBuffer<byte>(buffer);
         memcpy(dest, header, size);
       }
@@ -1329,6 +1642,44 @@ namespace UWPOpenIGTLink
     return bytesLoaded;
   }
 
+  //----------------------------------------------------------------------------
+  int32 IGTClient::SocketReceive(void* dest, int size, int chunkSize, const std::function<void(int)>& progress)
+  {
+    int bytesReceived(0);
+    try
+    {
+      while (bytesReceived < size)
+      {
+        // The lock is only held for each chunk, sends are not blocked for the whole body and progress runs unlocked
+        {
+          std::lock_guard<std::mutex> guard(m_socketMutex);
+          if (m_readStream == nullptr)
+          {
+            return -1;
+          }
+
+          auto chunk = size - bytesReceived < chunkSize ? size - bytesReceived : chunkSize;
+          auto bytesLoaded = static_cast<int>(create_task(m_readStream->LoadAsync(chunk)).get());
+          if (bytesLoaded == 0)
+          {
+            return bytesReceived;
+          }
+
+          // Read straight into the destination, no intermediate buffer
+          m_readStream->ReadBytes(Platform::ArrayReference<byte>(static_cast<byte*>(dest) + bytesReceived, bytesLoaded));
+          bytesReceived += bytesLoaded;
+        }
+        progress(bytesReceived);
+      }
+    }
+    catch (...)
+    {
+      return -1;
+    }
+
+    return bytesReceived;
+  }
+
   //----------------------------------------------------------------------------
   Platform::String^ IGTClient::ServerPort::get()
   {
@@ -1383,6 +1734,170 @@ namespace UWPOpenIGTLink
     m_trackerUnitScale = arg;
   }
 
+  //----------------------------------------------------------------------------
+  uint32 IGTClient::DeltaKeyFrameInterval::get()
+  {
+    return m_deltaKeyFrameInterval;
+  }
+
+  //----------------------------------------------------------------------------
+  void IGTClient::DeltaKeyFrameInterval::set(uint32 arg)
+  {
+    m_deltaKeyFrameInterval = arg;
+  }
+
+  //----------------------------------------------------------------------------
+  uint16 IGTClient::ImagePyramidLevels::get()
+  {
+    return m_imagePyramidLevels;
+  }
+
+  //----------------------------------------------------------------------------
+  void IGTClient::ImagePyramidLevels::set(uint16 arg)
+  {
+    m_imagePyramidLevels = arg;
+  }
+
+  //----------------------------------------------------------------------------
+  int IGTClient::ImagePyramidFilter::get()
+  {
+    return m_imagePyramidFilter;
+  }
+
+  //----------------------------------------------------------------------------
+  void IGTClient::ImagePyramidFilter::set(int arg)
+  {
+    m_imagePyramidFilter = arg;
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 IGTClient::ReceivedImageBytes::get()
+  {
+    return m_receivedImageBytes;
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 IGTClient::ReceivedImagePayloadBytes::get()
+  {
+    return m_receivedImagePayloadBytes;
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 IGTClient::TrackedFrameDecodeMicroseconds::get()
+  {
+    return m_trackedFrameDecodeMicroseconds;
+  }
+
+  //----------------------------------------------------------------------------
+  bool IGTClient::DetectDuplicateFrames::get()
+  {
+    return m_detectDuplicateFrames;
+  }
+
+  //----------------------------------------------------------------------------
+  void IGTClient::DetectDuplicateFrames::set(bool arg)
+  {
+    m_detectDuplicateFrames = arg;
+  }
+
+  //----------------------------------------------------------------------------
+  bool IGTClient::DropDuplicateFrames::get()
+  {
+    return m_dropDuplicateFrames;
+  }
+
+  //----------------------------------------------------------------------------
+  void IGTClient::DropDuplicateFrames::set(bool arg)
+  {
+    m_dropDuplicateFrames = arg;
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 IGTClient::DuplicateFrameCount::get()
+  {
+    return m_duplicateFrameCount;
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 IGTClient::DroppedDuplicateFrameCount::get()
+  {
+    return m_droppedDuplicateFrameCount;
+  }
+
+  //----------------------------------------------------------------------------
+  bool IGTClient::SpeckleFilterEnabled::get()
+  {
+    return m_speckleFilterEnabled;
+  }
+
+  //----------------------------------------------------------------------------
+  void IGTClient::SpeckleFilterEnabled::set(bool arg)
+  {
+    m_speckleFilterEnabled = arg;
+  }
+
+  //----------------------------------------------------------------------------
+  uint16 IGTClient::SpeckleFilterRadius::get()
+  {
+    return m_speckleFilterRadius;
+  }
+
+  //----------------------------------------------------------------------------
+  void IGTClient::SpeckleFilterRadius::set(uint16 arg)
+  {
+    if (arg > SpeckleFilter::MAXIMUM_RADIUS)
+    {
+      throw ref new Platform::Exception(E_INVALIDARG, L"Speckle filter radius exceeds SpeckleFilter::MAXIMUM_RADIUS.");
+    }
+    m_speckleFilterRadius = arg;
+  }
+
+  //----------------------------------------------------------------------------
+  float IGTClient::SpeckleFilterThreshold::get()
+  {
+    return m_speckleFilterThreshold;
+  }
+
+  //----------------------------------------------------------------------------
+  void IGTClient::SpeckleFilterThreshold::set(float arg)
+  {
+    if (!(arg >= 0.f))
+    {
+      throw ref new Platform::Exception(E_INVALIDARG, L"Speckle filter threshold must not be negative.");
+    }
+    m_speckleFilterThreshold = arg;
+  }
+
+  //----------------------------------------------------------------------------
+  uint32 IGTClient::SpeckleFilterLatencyBudgetMicroseconds::get()
+  {
+    return m_speckleFilterLatencyBudget;
+  }
+
+  //----------------------------------------------------------------------------
+  void IGTClient::SpeckleFilterLatencyBudgetMicroseconds::set(uint32 arg)
+  {
+    m_speckleFilterLatencyBudget = arg;
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 IGTClient::SpeckleFilteredFrameCount::get()
+  {
+    return m_speckleFilteredFrameCount;
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 IGTClient::SpeckleFilterSkippedFrameCount::get()
+  {
+    return m_speckleFilterSkippedFrameCount;
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 IGTClient::SpeckleFilterMicroseconds::get()
+  {
+    return m_speckleFilterMicroseconds;
+  }
+
   //----------------------------------------------------------------------------
   TransformName^ IGTClient::EmbeddedImageTransformName::get()
   {
@@ -30,8 +30,10 @@ OTHER DEALINGS IN THE SOFTWARE.
 #include "Command.h"
 #include "IGTCommon.h"
 #include "Polydata.h"
+#include "SpeckleFilter.h"
 #include "TrackedFrame.h"
 #include "TrackedFrameMessage.h"
+#include "TrackingDataPoseMessage.h"
 
 // IGT includes
 #include <igtlClientSocket.h>
@@ -41,7 +43,9 @@ OTHER DEALINGS IN THE SOFTWARE.
 #include <igtlTransformMessage.h>
 
 // STL includes
+#include <atomic>
 #include <deque>
+#include <functional>
 #include <string>
 
 // Windows includes
@@ -80,6 +84,36 @@ namespace UWPOpenIGTLink
     property bool Connected { bool get(); }
     property float TrackerUnitScale { float get(); void set(float); }
     property TransformName^ EmbeddedImageTransformName { TransformName ^ get(); void set(TransformName^); }
+    property uint32 DeltaKeyFrameInterval { uint32 get(); void set(uint32); }
+    /// Number of downsampled levels generated by the receiver for each TRACKEDFRAME image (see Image::GetPyramidLevel), 0 disables the pyramid
+    property uint16 ImagePyramidLevels { uint16 get(); void set(uint16); }
+    /// PYRAMID_FILTER used to generate the image pyramid
+    property int ImagePyramidFilter { int get(); void set(int); }
+
+    /// Transport statistics of received TRACKEDFRAME images, the decoded size versus the size sent over the network (compressed, delta encoded)
+    property uint64 ReceivedImageBytes { uint64 get(); }
+    property uint64 ReceivedImagePayloadBytes { uint64 get(); }
+    property uint64 TrackedFrameDecodeMicroseconds { uint64 get(); }
+
+    /// Hash each received TRACKEDFRAME image and flag it (TrackedFrame::IsDuplicate) if it is identical to the previous image of its device
+    property bool DetectDuplicateFrames { bool get(); void set(bool); }
+    /// Discard the image of duplicate frames in the receiver instead of storing it flagged, requires DetectDuplicateFrames.
+    /// The frame is still stored with its transforms and fields, flagged and without an image.
+    property bool DropDuplicateFrames { bool get(); void set(bool); }
+    /// Number of duplicate frames detected, and of those the number whose image was dropped
+    property uint64 DuplicateFrameCount { uint64 get(); }
+    property uint64 DroppedDuplicateFrameCount { uint64 get(); }
+
+    /// Reduce the speckle of received TRACKEDFRAME images in the receiver (see SpeckleFilter), greyscale images only
+    property bool SpeckleFilterEnabled { bool get(); void set(bool); }
+    property uint16 SpeckleFilterRadius { uint16 get(); void set(uint16); }
+    property float SpeckleFilterThreshold { float get(); void set(float); }
+    /// Frames predicted to take longer than this to filter are passed through unfiltered, 0 for no limit
+    property uint32 SpeckleFilterLatencyBudgetMicroseconds { uint32 get(); void set(uint32); }
+    /// Number of frames filtered and skipped to stay within the latency budget, and the total time spent filtering
+    property uint64 SpeckleFilteredFrameCount { uint64 get(); }
+    property uint64 SpeckleFilterSkippedFrameCount { uint64 get(); }
+    property uint64 SpeckleFilterMicroseconds { uint64 get(); }
 
   public:
     event ErrorMessageEventHandler^ ErrorMessage;
@@ -126,12 +160,24 @@ namespace UWPOpenIGTLink
     /// Send a packed message to the connected server
     Concurrency::task<bool> SendMessageAsyncInternal(igtl::MessageBase::Pointer packedMessage);
 
+    /// Send a TRACKEDFRAME message segment by segment, the image is written directly from its source buffer (message does not need to be packed)
+    Concurrency::task<bool> SendTrackedFrameMessageAsyncInternal(igtl::TrackedFrameMessage* trackedFrameMessage);
+
     /// Send a packed message to the connected server
     Concurrency::task<CommandData> SendCommandAsyncInternal(igtl::CommandMessage::Pointer packedMessage);
 
+    /*!
+      Start send once every previously queued send has completed, so that writes to the socket never overlap.
+      send is called with m_socketMutex held and returns the task of its writes. Call with m_socketMutex held.
+    */
+    Concurrency::task<bool> QueueSend(std::function<Concurrency::task<bool>()> send);
+
     /// Threaded function to receive data from the connected server
     void DataReceiverPump();
 
+    /// Returns true if the server advertised the given optional feature (see igtl::TrackedFrameMessage::CAPABILITIES_METADATA_KEY)
+    bool IsServerCapabilityAdvertised(const std::string& capability) const;
+
   protected private:
     void PruneIGTMessages();
 
@@ -157,6 +203,12 @@ namespace UWPOpenIGTLink
     template<typename MessageTypePointer> double GetOldestTimestamp() const;
 
     int32 SocketReceive(void* dest, int size);
+    /// Receive size bytes in chunks of at most chunkSize, progress is called with the total number of bytes received after each chunk.
+    /// The socket lock is taken for each chunk and released before progress is called.
+    int32 SocketReceive(void* dest, int size, int chunkSize, const std::function<void(int)>& progress);
+
+    /// Record the optional features advertised in the metadata of a message received from the server
+    void UpdateServerCapabilities(igtl::MessageBase::Pointer message);
 
   protected private:
     /// igtl Factory for message sending
@@ -172,10 +224,13 @@ namespace UWPOpenIGTLink
     Windows::Storage::Streams::DataReader^            m_readStream = nullptr;
     Windows::Networking::HostName^                    m_hostName = nullptr;
     std::atomic_bool                                  m_connected = false;
+    /// Completes when the last queued send has completed, guarded by m_socketMutex
+    Concurrency::task<void>                           m_sendQueue = Concurrency::task_from_result();
 
     /// Lists of messages received through the socket, transformed to igtl messages
     mutable std::mutex                                m_receivedMessagesMutex;
     MessageList                                       m_receivedImageMessages;
+    std::deque<std::shared_ptr<byte>>                 m_receivedImageScalars; // scalars decoded by the receiver for each image message, nullptr if they are read from the body
     MessageList                                       m_receivedTrackedFrameMessages;
     MessageList                                       m_receivedCommandReplyMessages;
     MessageList                                       m_receivedTransformMessages;
@@ -186,6 +241,41 @@ namespace UWPOpenIGTLink
     mutable std::mutex                                m_sendMessagesMutex;
     MessageList                                       m_sendMessages;
 
+    /// Optional features the server advertised it can receive
+    mutable std::mutex                                m_serverCapabilitiesMutex;
+    std::string                                       m_serverCapabilities;
+
+    /// Delta encoded image streams keyed by device name, receive streams are only touched by the receiver pump, send streams are guarded by m_socketMutex
+    std::map<std::string, std::shared_ptr<DeltaStreamState>> m_receiveDeltaStreams;
+    std::map<std::string, std::shared_ptr<DeltaStreamState>> m_sendDeltaStreams;
+    std::atomic<uint32>                               m_deltaKeyFrameInterval = 30;
+
+    /// Image pyramids generated by the receiver pump
+    std::atomic<uint16>                               m_imagePyramidLevels = 0;
+    std::atomic<int>                                  m_imagePyramidFilter = PYRAMID_FILTER_BOX;
+
+    /// Duplicate frame detection, the content hash of the last image received from each device is only touched by the receiver pump
+    std::atomic_bool                                  m_detectDuplicateFrames = true;
+    std::atomic_bool                                  m_dropDuplicateFrames = false;
+    std::map<std::string, uint64>                     m_lastImageContentHashes;
+    std::atomic<uint64>                               m_duplicateFrameCount = 0;
+    std::atomic<uint64>                               m_droppedDuplicateFrameCount = 0;
+
+    /// Speckle filter applied by the receiver pump, the filter's cost estimate is only touched by the pump
+    SpeckleFilter                                     m_speckleFilter;
+    std::atomic_bool                                  m_speckleFilterEnabled = false;
+    std::atomic<uint16>                               m_speckleFilterRadius = SpeckleFilter::Parameters().Radius;
+    std::atomic<float>                                m_speckleFilterThreshold = SpeckleFilter::Parameters().Threshold;
+    std::atomic<uint32>                               m_speckleFilterLatencyBudget = 0;
+    std::atomic<uint64>                               m_speckleFilteredFrameCount = 0;
+    std::atomic<uint64>                               m_speckleFilterSkippedFrameCount = 0;
+    std::atomic<uint64>                               m_speckleFilterMicroseconds = 0;
+
+    /// Transport statistics
+    std::atomic<uint64>                               m_receivedImageBytes = 0;
+    std::atomic<uint64>                               m_receivedImagePayloadBytes = 0;
+    std::atomic<uint64>                               m_trackedFrameDecodeMicroseconds = 0;
+
     // Handle the OpenIGTLink query mechanism
     uint32                                            m_nextQueryId = 1; // No reason not to use 0, reserving it just in case
     std::vector<uint32>                               m_outstandingQueries;
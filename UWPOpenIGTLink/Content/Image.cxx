@@ -26,7 +26,16 @@ OTHER DEALINGS IN THE SOFTWARE.
 
 // Local includes
 #include "pch.h"
+#include "FastCopy.h"
 #include "Image.h"
+#include "HalfFloat.h"
+#include "ImageBufferPool.h"
+#include "ImagePyramid.h"
+#include "NativeBuffer.h"
+#include "VolumeView.h"
+
+// STL includes
+#include <atomic>
 
 // OS includes
 #include <robuffer.h>
@@ -39,6 +48,14 @@ using namespace Windows::Storage::Streams;
 
 namespace UWPOpenIGTLink
 {
+  namespace
+  {
+    std::atomic<uint64> copyOnWriteShareCount = 0;
+    std::atomic<uint64> copyOnWriteDetachCount = 0;
+    std::atomic<uint64> copyOnWriteDetachedBytes = 0;
+    std::atomic<uint64> imageDataReadCount = 0;
+  }
+
   //----------------------------------------------------------------------------
   Image::Image()
   {
@@ -58,12 +75,94 @@ namespace UWPOpenIGTLink
     m_scalarType = otherImage->m_scalarType;
     m_frameSize = otherImage->m_frameSize;
 
-    AllocateScalars(m_frameSize, m_numberOfScalarComponents, m_scalarType);
-    memcpy(m_imageData.get(), otherImage->m_imageData.get(), GetImageSizeBytes());
+    // Share the pixels, GetMutableImageDataInternal copies them before either image is written.
+    // Pixels the other image exposed through MutableImageData or GetMutableImageData may be written at any time, they are copied instead.
+    m_imageData = otherImage->m_imageData;
+    m_imageDataExposed = false;
+    if (m_imageData != nullptr && otherImage->m_imageDataExposed)
+    {
+      const size_t sizeBytes = static_cast<size_t>(GetImageSizeBytes());
+      m_imageData = ImageBufferPool::GetInstance()->Acquire(sizeBytes);
+      FastCopy(m_imageData.get(), otherImage->m_imageData.get(), sizeBytes);
+    }
+    else if (m_imageData != nullptr)
+    {
+      ++copyOnWriteShareCount;
+    }
+
+    // Pyramid levels are never modified, they can be shared
+    m_pyramid = otherImage->m_pyramid;
 
     return true;
   }
 
+  //----------------------------------------------------------------------------
+  Image^ Image::ExtractSlice(int axis, uint32 index)
+  {
+    // Only the pixels of the slice are copied
+    auto image = VolumeView(this).Slice(axis, index).ToImage();
+    if (image != nullptr)
+    {
+      image->Timestamp = m_timestamp;
+    }
+    return image;
+  }
+
+  //----------------------------------------------------------------------------
+  Image^ Image::Crop(const FrameSizeABI^ origin, const FrameSizeABI^ size)
+  {
+    if (origin == nullptr || size == nullptr || origin->Length < 3 || size->Length < 3)
+    {
+      return nullptr;
+    }
+
+    auto image = VolumeView(this).Crop({ origin[0], origin[1], origin[2] }, { size[0], size[1], size[2] }).ToImage();
+    if (image != nullptr)
+    {
+      image->Timestamp = m_timestamp;
+    }
+    return image;
+  }
+
+  //----------------------------------------------------------------------------
+  Image^ Image::ConvertScalarType(int scalarType)
+  {
+    if (m_imageData == nullptr)
+    {
+      return nullptr;
+    }
+
+    auto image = ref new Image();
+    image->Timestamp = m_timestamp;
+    if (scalarType == m_scalarType)
+    {
+      image->DeepCopy(this);
+      return image;
+    }
+
+    const bool toFloat16 = m_scalarType == IGTL_SCALARTYPE_FLOAT32 && scalarType == IGTL_SCALARTYPE_FLOAT16;
+    const bool toFloat32 = m_scalarType == IGTL_SCALARTYPE_FLOAT16 && scalarType == IGTL_SCALARTYPE_FLOAT32;
+    uint64 sizeBytes(0);
+    if (!(toFloat16 || toFloat32) || !ComputeImageSizeBytes(m_frameSize, m_numberOfScalarComponents, (IGTL_SCALAR_TYPE)scalarType, sizeBytes))
+    {
+      return nullptr;
+    }
+
+    const size_t valueCount = static_cast<size_t>(m_frameSize[0]) * m_frameSize[1] * m_frameSize[2] * m_numberOfScalarComponents;
+    auto imageData = ImageBufferPool::GetInstance()->Acquire(static_cast<size_t>(sizeBytes));
+    if (toFloat16)
+    {
+      ConvertFloat32ToFloat16(reinterpret_cast<const float*>(m_imageData.get()), reinterpret_cast<uint16*>(imageData.get()), valueCount);
+    }
+    else
+    {
+      ConvertFloat16ToFloat32(reinterpret_cast<const uint16*>(m_imageData.get()), reinterpret_cast<float*>(imageData.get()), valueCount);
+    }
+
+    image->SetImageData(imageData, m_numberOfScalarComponents, (IGTL_SCALAR_TYPE)scalarType, m_frameSize);
+    return image;
+  }
+
   //----------------------------------------------------------------------------
   bool Image::FillBlank()
   {
@@ -72,11 +171,76 @@ namespace UWPOpenIGTLink
       return false;
     }
 
-    memset(m_imageData.get(), 0, GetImageSizeBytes());
+    // Shared pixels are replaced rather than copied, none of them survive
+    if (IsImageDataShared())
+    {
+      m_imageData = ImageBufferPool::GetInstance()->Acquire(static_cast<size_t>(GetImageSizeBytes()));
+      m_imageDataExposed = false;
+    }
+    memset(m_imageData.get(), 0, static_cast<size_t>(GetImageSizeBytes()));
+    m_pyramid = nullptr;
 
     return true;
   }
 
+  //----------------------------------------------------------------------------
+  bool Image::GeneratePyramid(int filter, uint16 numberOfLevels)
+  {
+    if (m_imageData == nullptr)
+    {
+      return false;
+    }
+
+    m_pyramid = ImagePyramid::Generate(m_imageData.get(), m_frameSize, m_numberOfScalarComponents, m_scalarType, (PYRAMID_FILTER)filter, numberOfLevels);
+    return m_pyramid != nullptr;
+  }
+
+  //----------------------------------------------------------------------------
+  void Image::ClearPyramid()
+  {
+    m_pyramid = nullptr;
+  }
+
+  //----------------------------------------------------------------------------
+  uint16 Image::PyramidLevelCount::get()
+  {
+    return m_pyramid == nullptr ? 0 : static_cast<uint16>(m_pyramid->GetNumberOfLevels());
+  }
+
+  //----------------------------------------------------------------------------
+  Image^ Image::GetPyramidLevel(uint16 level)
+  {
+    if (level == 0)
+    {
+      return this;
+    }
+    if (level > PyramidLevelCount)
+    {
+      return nullptr;
+    }
+
+    const auto& pyramidLevel = m_pyramid->GetLevel(level - 1);
+    auto image = ref new Image();
+    image->SetImageData(pyramidLevel.Data, m_numberOfScalarComponents, m_scalarType, pyramidLevel.Size);
+    image->Timestamp = m_timestamp;
+    return image;
+  }
+
+  //----------------------------------------------------------------------------
+  Image^ Image::GetPyramidLevelForSize(uint32 width, uint32 height)
+  {
+    // Levels shrink monotonically, search from the smallest
+    for (uint16 level = PyramidLevelCount; level > 0; --level)
+    {
+      const auto& size = m_pyramid->GetLevel(level - 1).Size;
+      if (size[0] >= width && size[1] >= height)
+      {
+        return GetPyramidLevel(level);
+      }
+    }
+    return this;
+  }
+
   //----------------------------------------------------------------------------
   uint32 Image::GetNumberOfBytesPerScalar(int pixelType)
   {
@@ -100,11 +264,67 @@ namespace UWPOpenIGTLink
         return sizeof(float);
       case IGTL_SCALARTYPE_FLOAT64:
         return sizeof(double);
+      case IGTL_SCALARTYPE_FLOAT16:
+        return sizeof(uint16);
       default:
         return 0;
     }
   }
 
+  //----------------------------------------------------------------------------
+  uint64 Image::BufferPoolHitCount::get()
+  {
+    return ImageBufferPool::GetInstance()->GetHitCount();
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 Image::BufferPoolMissCount::get()
+  {
+    return ImageBufferPool::GetInstance()->GetMissCount();
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 Image::BufferPoolPooledBytes::get()
+  {
+    return ImageBufferPool::GetInstance()->GetPooledBytes();
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 Image::BufferPoolInUseBytes::get()
+  {
+    return ImageBufferPool::GetInstance()->GetInUseBytes();
+  }
+
+  //----------------------------------------------------------------------------
+  void Image::TrimBufferPool()
+  {
+    ImageBufferPool::GetInstance()->Trim();
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 Image::CopyOnWriteShareCount::get()
+  {
+    return copyOnWriteShareCount;
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 Image::CopyOnWriteDetachCount::get()
+  {
+    return copyOnWriteDetachCount;
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 Image::CopyOnWriteDetachedBytes::get()
+  {
+    return copyOnWriteDetachedBytes;
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 Image::ImageDataReadCount::get()
+  {
+    return imageDataReadCount;
+  }
+
   //----------------------------------------------------------------------------
   void Image::SetImageData(std::shared_ptr<byte> imageData, uint16 numberOfScalarComponents, IGTL_SCALAR_TYPE scalarType, const FrameSize& frameSize)
   {
@@ -112,25 +332,67 @@ namespace UWPOpenIGTLink
     m_scalarType = scalarType;
     m_frameSize = frameSize;
     m_imageData = imageData;
+    m_imageDataExposed = false;
+    m_pyramid = nullptr;
   }
 
   //----------------------------------------------------------------------------
-  std::shared_ptr<byte> Image::GetImageDataInternal()
+  UWPOpenIGTLink::SharedBytePtr Image::GetImageData()
   {
+    ++imageDataReadCount;
+    return (SharedBytePtr)&m_imageData;
+  }
+
+  //----------------------------------------------------------------------------
+  UWPOpenIGTLink::SharedBytePtr Image::GetMutableImageData()
+  {
+    GetMutableImageDataInternal();
+    m_imageDataExposed = m_imageData != nullptr;
+    return (SharedBytePtr)&m_imageData;
+  }
+
+  //----------------------------------------------------------------------------
+  std::shared_ptr<const byte> Image::GetImageDataInternal() const
+  {
+    return m_imageData;
+  }
+
+  //----------------------------------------------------------------------------
+  std::shared_ptr<byte> Image::GetMutableImageDataInternal()
+  {
+    if (IsImageDataShared())
+    {
+      const size_t sizeBytes = static_cast<size_t>(GetImageSizeBytes());
+      auto imageData = ImageBufferPool::GetInstance()->Acquire(sizeBytes);
+      FastCopy(imageData.get(), m_imageData.get(), sizeBytes);
+      m_imageData = imageData;
+      m_imageDataExposed = false;
+
+      ++copyOnWriteDetachCount;
+      copyOnWriteDetachedBytes += sizeBytes;
+    }
     return m_imageData;
   }
 
+  //----------------------------------------------------------------------------
+  bool Image::IsImageDataShared() const
+  {
+    return m_imageData != nullptr && m_imageData.use_count() > 1;
+  }
+
   //----------------------------------------------------------------------------
   void Image::AllocateScalars(const FrameSizeABI^ imageSize, uint16 numberOfScalarComponents, int scalarType)
   {
-    std::array<uint16, 3> imgSize = { imageSize[0], imageSize[1], imageSize[2] };
+    FrameSize imgSize = { imageSize[0], imageSize[1], imageSize[2] };
     AllocateScalars(imgSize, numberOfScalarComponents, (IGTL_SCALAR_TYPE)scalarType);
   }
 
   //----------------------------------------------------------------------------
   void Image::AllocateScalars(const FrameSize& imageSize, uint16 numberOfScalarComponents, IGTL_SCALAR_TYPE scalarType)
   {
-    if (numberOfScalarComponents == m_numberOfScalarComponents &&
+    // Shared pixels are replaced, the caller is about to write new ones
+    if (!IsImageDataShared() &&
+        numberOfScalarComponents == m_numberOfScalarComponents &&
         (IGTL_SCALAR_TYPE)scalarType == m_scalarType &&
         imageSize[0] == m_frameSize[0] &&
         imageSize[1] == m_frameSize[1] &&
@@ -139,16 +401,21 @@ namespace UWPOpenIGTLink
       return;
     }
 
+    uint64 sizeBytes(0);
+    if (!ComputeImageSizeBytes(imageSize, numberOfScalarComponents, scalarType, sizeBytes))
+    {
+      throw ref new Platform::Exception(E_INVALIDARG, L"Image size overflows, unable to allocate scalars.");
+    }
+
     m_numberOfScalarComponents = numberOfScalarComponents;
     m_scalarType = (IGTL_SCALAR_TYPE)scalarType;
     m_frameSize[0] = imageSize[0];
     m_frameSize[1] = imageSize[1];
     m_frameSize[2] = imageSize[2];
 
-    m_imageData = std::shared_ptr<byte>(new byte[GetImageSizeBytes()], [](byte * p)
-    {
-      delete[] p;
-    });
+    m_imageData = ImageBufferPool::GetInstance()->Acquire(static_cast<size_t>(sizeBytes));
+    m_imageDataExposed = false;
+    m_pyramid = nullptr;
   }
 
   //----------------------------------------------------------------------------
@@ -158,9 +425,50 @@ namespace UWPOpenIGTLink
   }
 
   //----------------------------------------------------------------------------
-  uint32 Image::GetImageSizeBytes()
+  void Image::SetPyramid(std::shared_ptr<const ImagePyramid> pyramid)
+  {
+    // A pyramid of other pixels would return levels of the wrong size
+    if (pyramid != nullptr && pyramid->GetBaseSize() != m_frameSize)
+    {
+      return;
+    }
+    m_pyramid = pyramid;
+  }
+
+  //----------------------------------------------------------------------------
+  std::shared_ptr<const ImagePyramid> Image::GetPyramid() const
   {
-    return GetNumberOfBytesPerScalar((int)m_scalarType) * m_numberOfScalarComponents * m_frameSize[0] * m_frameSize[1] * m_frameSize[2];
+    return m_pyramid;
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 Image::GetImageSizeBytes()
+  {
+    uint64 sizeBytes(0);
+    return ComputeImageSizeBytes(m_frameSize, m_numberOfScalarComponents, m_scalarType, sizeBytes) ? sizeBytes : 0;
+  }
+
+  //----------------------------------------------------------------------------
+  bool Image::ComputeImageSizeBytes(const FrameSize& frameSize, uint16 numberOfScalarComponents, IGTL_SCALAR_TYPE scalarType, uint64& outSizeBytes)
+  {
+    uint64 sizeBytes = static_cast<uint64>(GetNumberOfBytesPerScalar(scalarType)) * numberOfScalarComponents;
+    for (auto extent : frameSize)
+    {
+      if (extent != 0 && sizeBytes > (std::numeric_limits<uint64>::max)() / extent)
+      {
+        return false;
+      }
+      sizeBytes *= extent;
+    }
+
+    // 32 bit platforms can't address more
+    if (sizeBytes > (std::numeric_limits<size_t>::max)())
+    {
+      return false;
+    }
+
+    outSizeBytes = sizeBytes;
+    return true;
   }
 
   //----------------------------------------------------------------------------
@@ -185,6 +493,8 @@ namespace UWPOpenIGTLink
             return DXGI_FORMAT_R32_UINT;
           case IGTL_SCALARTYPE_FLOAT32:
             return DXGI_FORMAT_R32_FLOAT;
+          case IGTL_SCALARTYPE_FLOAT16:
+            return DXGI_FORMAT_R16_FLOAT;
         }
         break;
       case 2:
@@ -204,6 +514,8 @@ namespace UWPOpenIGTLink
             return DXGI_FORMAT_R32G32_UINT;
           case IGTL_SCALARTYPE_FLOAT32:
             return DXGI_FORMAT_R32G32_FLOAT;
+          case IGTL_SCALARTYPE_FLOAT16:
+            return DXGI_FORMAT_R16G16_FLOAT;
         }
         break;
       case 3:
@@ -223,6 +535,9 @@ namespace UWPOpenIGTLink
             return DXGI_FORMAT_R32G32B32_UINT;
           case IGTL_SCALARTYPE_FLOAT32:
             return DXGI_FORMAT_R32G32B32_FLOAT;
+          case IGTL_SCALARTYPE_FLOAT16:
+            // There is no three channel half format, the pixels would have to be padded to R16G16B16A16
+            return DXGI_FORMAT_UNKNOWN;
         }
       case 4:
         switch (m_scalarType)
@@ -241,6 +556,8 @@ namespace UWPOpenIGTLink
             return DXGI_FORMAT_R32G32B32A32_UINT;
           case IGTL_SCALARTYPE_FLOAT32:
             return DXGI_FORMAT_R32G32B32A32_FLOAT;
+          case IGTL_SCALARTYPE_FLOAT16:
+            return DXGI_FORMAT_R16G16B16A16_FLOAT;
         }
         break;
     }
@@ -304,8 +621,34 @@ namespace UWPOpenIGTLink
   //----------------------------------------------------------------------------
   IBuffer^ Image::ImageData::get()
   {
-    Platform::ArrayReference<byte> arraywrapper(m_imageData.get(), GetImageSizeBytes());
-    return Windows::Security::Cryptography::CryptographicBuffer::CreateFromByteArray(arraywrapper);
+    if (m_imageData == nullptr)
+    {
+      return nullptr;
+    }
+
+    // The buffer references the pixels instead of copying them and keeps them alive for as long as it is referenced
+    const uint64 sizeBytes = GetImageSizeBytes();
+    if (sizeBytes > (std::numeric_limits<uint32>::max)())
+    {
+      return nullptr;
+    }
+    ++imageDataReadCount;
+    return CreateNativeBuffer(m_imageData, static_cast<uint32>(sizeBytes));
+  }
+
+  //----------------------------------------------------------------------------
+  IBuffer^ Image::MutableImageData::get()
+  {
+    const uint64 sizeBytes = GetImageSizeBytes();
+    if (m_imageData == nullptr || sizeBytes > (std::numeric_limits<uint32>::max)())
+    {
+      return nullptr;
+    }
+
+    // Nothing stops a caller writing through the buffer, so the pixels must belong to this image alone
+    GetMutableImageDataInternal();
+    m_imageDataExposed = true;
+    return CreateNativeBuffer(m_imageData, static_cast<uint32>(sizeBytes));
   }
 
   //----------------------------------------------------------------------------
@@ -340,7 +683,9 @@ namespace UWPOpenIGTLink
       return;
     }
 
-    m_imageData = std::shared_ptr<byte>(new byte[bufferLength], std::default_delete<byte[]>());
-    memcpy(m_imageData.get(), pRawData, bufferLength * sizeof(byte));
+    m_imageData = ImageBufferPool::GetInstance()->Acquire(bufferLength);
+    FastCopy(m_imageData.get(), pRawData, bufferLength * sizeof(byte));
+    m_imageDataExposed = false;
+    m_pyramid = nullptr;
   }
 }
\ No newline at end of file
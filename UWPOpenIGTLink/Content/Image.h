@@ -34,6 +34,8 @@ OTHER DEALINGS IN THE SOFTWARE.
 
 namespace UWPOpenIGTLink
 {
+  class ImagePyramid;
+
   public ref class Image sealed
   {
   public:
@@ -41,32 +43,93 @@ namespace UWPOpenIGTLink
     virtual ~Image();
 
     property FrameSizeABI^ Dimensions { FrameSizeABI ^ get(); void set(const FrameSizeABI ^ arg); }
+    /// The returned buffer references the image's pixels (no copy) and is read only: the pixels may be shared with copies of this image,
+    /// a received message or a delta stream reference. Use MutableImageData to write.
+    /// nullptr if the image is larger than an IBuffer can address (4 GB), use GetImageData or a VolumeView instead.
     property Windows::Storage::Streams::IBuffer^ ImageData { Windows::Storage::Streams::IBuffer ^ get(); void set(Windows::Storage::Streams::IBuffer ^ data); }
+    /// As ImageData, but shared pixels are copied first so that writes only modify this image, and later copies of this image do not share them.
+    /// The buffer itself shares the pixels, release it when done writing or the next mutable access copies them again.
+    property Windows::Storage::Streams::IBuffer^ MutableImageData { Windows::Storage::Streams::IBuffer ^ get(); }
     property uint16 NumberOfScalarComponents { uint16 get(); void set(uint16 arg); }
     property int ScalarType { int get(); void set(int arg); }
     property double Timestamp { double get(); void set(double arg); }
 
+    /// Copies share the pixels of otherImage, they are only copied when either image is written through a mutable access
     bool DeepCopy(Image^ otherImage);
+    /// Copy slice index along axis (0 = x, 1 = y, 2 = z) into a new image, the remaining axes keep their order
+    Image^ ExtractSlice(int axis, uint32 index);
+    /// Copy the size sub volume starting at origin into a new image, nullptr if it is not inside this image
+    Image^ Crop(const FrameSizeABI^ origin, const FrameSizeABI^ size);
+    /// Convert float32 pixels to float16 (rounded to nearest, halving their size) or float16 pixels to float32 (exact) into a new image.
+    /// A conversion to the current scalar type returns a copy sharing the pixels, other conversions return nullptr.
+    Image^ ConvertScalarType(int scalarType);
     bool FillBlank();
+
+    /// Downsample the image into at most numberOfLevels levels (PYRAMID_FILTER), each half the width and height of the previous one.
+    /// The pyramid is discarded when the pixels are replaced, writes through MutableImageData or GetMutableImageData are not reflected in it.
+    bool GeneratePyramid(int filter, uint16 numberOfLevels);
+    void ClearPyramid();
+    /// Number of downsampled levels, 0 if no pyramid was generated
+    property uint16 PyramidLevelCount { uint16 get(); }
+    /// Level 0 is this image, level n is downsampled n times. The returned image shares the pixels of the level.
+    Image^ GetPyramidLevel(uint16 level);
+    /// The smallest level at least width x height pixels, this image if no level is large enough
+    Image^ GetPyramidLevelForSize(uint32 width, uint32 height);
+    /// Throws E_INVALIDARG if the size of the image does not fit in memory
     void AllocateScalars(const FrameSizeABI^ imageSize, uint16 numberOfScalarComponents, int scalarType);
-    uint32 GetImageSizeBytes();
+    /// 0 if the size overflows, which AllocateScalars prevents
+    uint64 GetImageSizeBytes();
     uint32 GetPixelFormat(bool normalized);
     static uint32 GetNumberOfBytesPerScalar(int scalarType);
 
-    SharedBytePtr GetImageData() { return (SharedBytePtr)&m_imageData; }
+    /// Image buffers are 64 byte aligned and recycled through a pool, these report its effectiveness
+    static property uint64 BufferPoolHitCount { uint64 get(); }
+    static property uint64 BufferPoolMissCount { uint64 get(); }
+    static property uint64 BufferPoolPooledBytes { uint64 get(); }
+    static property uint64 BufferPoolInUseBytes { uint64 get(); }
+    /// Free the buffers held by the pool
+    static void TrimBufferPool();
+
+    /// Number of DeepCopy calls that shared pixels instead of copying them
+    static property uint64 CopyOnWriteShareCount { uint64 get(); }
+    /// Number of mutable accesses that had to copy shared pixels, and the bytes they copied
+    static property uint64 CopyOnWriteDetachCount { uint64 get(); }
+    static property uint64 CopyOnWriteDetachedBytes { uint64 get(); }
+    /// Number of ImageData and GetImageData reads, none of them copy the pixels
+    static property uint64 ImageDataReadCount { uint64 get(); }
+
+    /// Address of the image's pixel pointer, read only as for ImageData
+    SharedBytePtr GetImageData();
+    /// Address of the image's pixel pointer. Shared pixels are copied first so that writes only modify this image.
+    SharedBytePtr GetMutableImageData();
 
   internal:
     void SetImageData(std::shared_ptr<byte> imageData, uint16 numberOfScalarComponents, IGTL_SCALAR_TYPE scalarType, const FrameSize& imageSize);
-    std::shared_ptr<byte> GetImageDataInternal();
+    /// The pixels may be shared with copies of this image, use GetMutableImageDataInternal to write
+    std::shared_ptr<const byte> GetImageDataInternal() const;
+    /// Copy the pixels first if they are shared, the returned pixels can be written
+    std::shared_ptr<byte> GetMutableImageDataInternal();
+    /// True if anything else (another image, a buffer, a view or a pyramid) references the pixels
+    bool IsImageDataShared() const;
     void AllocateScalars(const FrameSize& imageSize, uint16 numberOfScalarComponents, IGTL_SCALAR_TYPE pixelType);
 
     FrameSize GetFrameSize() const;
 
+    /// Compute the size of an image in bytes, false if it overflows or is not addressable (size_t) on this platform
+    static bool ComputeImageSizeBytes(const FrameSize& frameSize, uint16 numberOfScalarComponents, IGTL_SCALAR_TYPE scalarType, uint64& outSizeBytes);
+
+    /// Attach a pyramid generated from the pixels of this image, e.g. on the thread that decoded them
+    void SetPyramid(std::shared_ptr<const ImagePyramid> pyramid);
+    std::shared_ptr<const ImagePyramid> GetPyramid() const;
+
   protected private:
     FrameSize                                 m_frameSize;
     std::shared_ptr<byte>                     m_imageData;
+    // MutableImageData or GetMutableImageData handed out a writable alias of the pixels, DeepCopy must not share them
+    bool                                      m_imageDataExposed = false;
     uint16                                    m_numberOfScalarComponents;
     IGTL_SCALAR_TYPE                          m_scalarType;
     double                                    m_timestamp = 0.0;
+    std::shared_ptr<const ImagePyramid>       m_pyramid = nullptr;
   };
 }
\ No newline at end of file
@@ -0,0 +1,170 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+// Local includes
+#include "pch.h"
+#include "ImageBufferPool.h"
+
+// STL includes
+#include <malloc.h>
+#include <new>
+
+namespace UWPOpenIGTLink
+{
+  namespace
+  {
+    // Buckets are this granular, frames of one stream always share a bucket without wasting much memory
+    static const size_t BUCKET_GRANULARITY = 4096;
+  }
+
+  //----------------------------------------------------------------------------
+  std::shared_ptr<ImageBufferPool> ImageBufferPool::GetInstance()
+  {
+    static std::shared_ptr<ImageBufferPool> instance = std::make_shared<ImageBufferPool>();
+    return instance;
+  }
+
+  //----------------------------------------------------------------------------
+  ImageBufferPool::~ImageBufferPool()
+  {
+    Trim();
+  }
+
+  //----------------------------------------------------------------------------
+  std::shared_ptr<byte> ImageBufferPool::Acquire(size_t size)
+  {
+    if (size == 0)
+    {
+      return nullptr;
+    }
+
+    const size_t bucketSize = GetBucketSize(size);
+    byte* buffer = nullptr;
+    {
+      std::lock_guard<std::mutex> guard(m_mutex);
+      auto iter = m_buckets.find(bucketSize);
+      if (iter != m_buckets.end() && !iter->second.empty())
+      {
+        buffer = iter->second.back();
+        iter->second.pop_back();
+        m_pooledBytes -= bucketSize;
+      }
+    }
+
+    if (buffer != nullptr)
+    {
+      m_hitCount++;
+    }
+    else
+    {
+      buffer = static_cast<byte*>(_aligned_malloc(bucketSize, ALIGNMENT));
+      if (buffer == nullptr)
+      {
+        throw std::bad_alloc();
+      }
+      m_missCount++;
+    }
+    m_inUseBytes += bucketSize;
+
+    auto pool = shared_from_this();
+    return std::shared_ptr<byte>(buffer, [pool, bucketSize](byte * p)
+    {
+      pool->Release(p, bucketSize);
+    });
+  }
+
+  //----------------------------------------------------------------------------
+  void ImageBufferPool::Release(byte* buffer, size_t bucketSize)
+  {
+    m_inUseBytes -= bucketSize;
+    {
+      std::lock_guard<std::mutex> guard(m_mutex);
+      if (m_pooledBytes + bucketSize <= m_maximumPooledBytes)
+      {
+        m_buckets[bucketSize].push_back(buffer);
+        m_pooledBytes += bucketSize;
+        return;
+      }
+    }
+    _aligned_free(buffer);
+  }
+
+  //----------------------------------------------------------------------------
+  void ImageBufferPool::Trim()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    for (auto& bucket : m_buckets)
+    {
+      for (auto buffer : bucket.second)
+      {
+        _aligned_free(buffer);
+      }
+    }
+    m_buckets.clear();
+    m_pooledBytes = 0;
+  }
+
+  //----------------------------------------------------------------------------
+  void ImageBufferPool::SetMaximumPooledBytes(size_t bytes)
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_maximumPooledBytes = bytes;
+  }
+
+  //----------------------------------------------------------------------------
+  size_t ImageBufferPool::GetMaximumPooledBytes() const
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_maximumPooledBytes;
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 ImageBufferPool::GetHitCount() const
+  {
+    return m_hitCount;
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 ImageBufferPool::GetMissCount() const
+  {
+    return m_missCount;
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 ImageBufferPool::GetPooledBytes() const
+  {
+    return m_pooledBytes;
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 ImageBufferPool::GetInUseBytes() const
+  {
+    return m_inUseBytes;
+  }
+
+  //----------------------------------------------------------------------------
+  size_t ImageBufferPool::GetBucketSize(size_t size)
+  {
+    return (size + BUCKET_GRANULARITY - 1) / BUCKET_GRANULARITY * BUCKET_GRANULARITY;
+  }
+}
@@ -0,0 +1,86 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+#pragma once
+
+// Local includes
+#include "IGTCommon.h"
+
+// STL includes
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace UWPOpenIGTLink
+{
+  /*!
+    A pool of aligned image buffers, bucketed by size. A buffer returns to its bucket when the last reference to it
+    is released and is handed out again by the next request of the same bucket, so a stream of equally sized frames
+    stops allocating once the pool is warm. Buffers start on an ALIGNMENT byte boundary.
+  */
+  class ImageBufferPool : public std::enable_shared_from_this<ImageBufferPool>
+  {
+  public:
+    static const size_t ALIGNMENT = 64;
+
+    /// The process wide pool, buffers keep the pool alive until they are released
+    static std::shared_ptr<ImageBufferPool> GetInstance();
+
+    /// Get a buffer of at least size bytes, the contents are undefined. Returns nullptr if size is 0, throws std::bad_alloc like new[] if the allocation fails.
+    std::shared_ptr<byte> Acquire(size_t size);
+
+    /// Free every buffer held by the pool, buffers in use are unaffected
+    void Trim();
+
+    /// Buffers held by the pool above this many bytes are freed instead of kept
+    void SetMaximumPooledBytes(size_t bytes);
+    size_t GetMaximumPooledBytes() const;
+
+    /// Requests served from the pool
+    uint64 GetHitCount() const;
+    /// Requests that had to allocate
+    uint64 GetMissCount() const;
+    /// Bytes held by the pool, ready to be handed out
+    uint64 GetPooledBytes() const;
+    /// Bytes of the buffers currently in use
+    uint64 GetInUseBytes() const;
+
+    ImageBufferPool() = default;
+    ~ImageBufferPool();
+
+  protected:
+    static size_t GetBucketSize(size_t size);
+    void Release(byte* buffer, size_t bucketSize);
+
+    mutable std::mutex                        m_mutex;
+    std::map<size_t, std::vector<byte*>>      m_buckets;
+    size_t                                    m_maximumPooledBytes = 256 * 1024 * 1024;
+
+    std::atomic<uint64>                       m_hitCount = 0;
+    std::atomic<uint64>                       m_missCount = 0;
+    std::atomic<uint64>                       m_pooledBytes = 0;
+    std::atomic<uint64>                       m_inUseBytes = 0;
+  };
+}
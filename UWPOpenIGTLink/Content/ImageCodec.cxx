@@ -0,0 +1,435 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+// Local includes
+#include "pch.h"
+#include "ImageCodec.h"
+
+// STL includes
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+  // Constants of the LZ4 block format
+  static const size_t MIN_MATCH = 4;
+  static const size_t LAST_LITERALS = 5;    // the last 5 bytes of a block are always literals
+  static const size_t MF_LIMIT = 12;        // the last match must start at least 12 bytes before the end of the block
+  static const size_t MAX_OFFSET = 65535;
+  static const unsigned int HASH_LOG = 12;
+  static const unsigned int SKIP_TRIGGER = 6; // incompressible runs are skipped over increasingly quickly
+
+  // Short runs of unchanged bytes are cheaper to send as zero residuals than as a new run
+  static const size_t MIN_UNCHANGED_RUN = 4;
+
+  //----------------------------------------------------------------------------
+  inline uint32_t Read32(const unsigned char* ptr)
+  {
+    uint32_t value;
+    memcpy(&value, ptr, sizeof(value));
+    return value;
+  }
+
+  //----------------------------------------------------------------------------
+  inline uint32_t Hash(uint32_t sequence)
+  {
+    return (sequence * 2654435761U) >> (32 - HASH_LOG);
+  }
+
+  //----------------------------------------------------------------------------
+  inline unsigned char* WriteLength(unsigned char* op, size_t length)
+  {
+    while (length >= 255)
+    {
+      *op++ = 255;
+      length -= 255;
+    }
+    *op++ = static_cast<unsigned char>(length);
+    return op;
+  }
+
+  //----------------------------------------------------------------------------
+  inline void WriteVarInt(std::vector<unsigned char>& out, size_t value)
+  {
+    while (value >= 0x80)
+    {
+      out.push_back(static_cast<unsigned char>(value | 0x80));
+      value >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(value));
+  }
+
+  //----------------------------------------------------------------------------
+  inline bool ReadVarInt(const unsigned char*& ip, const unsigned char* iend, size_t& value)
+  {
+    value = 0;
+    for (unsigned int shift = 0; shift < sizeof(size_t) * 8; shift += 7)
+    {
+      if (ip >= iend)
+      {
+        return false;
+      }
+      unsigned char b = *ip++;
+      value |= static_cast<size_t>(b & 0x7F) << shift;
+      if (!(b & 0x80))
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  //----------------------------------------------------------------------------
+  inline size_t CountUnchanged(const unsigned char* frame, const unsigned char* reference, size_t size)
+  {
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+    {
+      uint64_t a, b;
+      memcpy(&a, frame + i, sizeof(a));
+      memcpy(&b, reference + i, sizeof(b));
+      if (a != b)
+      {
+        break;
+      }
+    }
+    while (i < size && frame[i] == reference[i])
+    {
+      ++i;
+    }
+    return i;
+  }
+
+  //----------------------------------------------------------------------------
+  inline void XorBytes(const unsigned char* a, const unsigned char* b, unsigned char* dst, size_t size)
+  {
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+    {
+      uint64_t x, y;
+      memcpy(&x, a + i, sizeof(x));
+      memcpy(&y, b + i, sizeof(y));
+      x ^= y;
+      memcpy(dst + i, &x, sizeof(x));
+    }
+    for (; i < size; ++i)
+    {
+      dst[i] = a[i] ^ b[i];
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  inline bool ReadLength(const unsigned char*& ip, const unsigned char* iend, size_t& length)
+  {
+    unsigned char s;
+    do
+    {
+      if (ip >= iend)
+      {
+        return false;
+      }
+      s = *ip++;
+      length += s;
+    }
+    while (s == 255);
+    return true;
+  }
+}
+
+namespace UWPOpenIGTLink
+{
+  const char* IMAGE_COMPRESSION_LZ4 = "LZ4";
+  const char* IMAGE_COMPRESSION_METADATA_KEY = "ImageCompression";
+  const char* COMPRESSED_IMAGE_SIZE_METADATA_KEY = "CompressedImageSize";
+
+  //----------------------------------------------------------------------------
+  size_t LZ4CompressBound(size_t srcSize)
+  {
+    return srcSize + srcSize / 255 + 16;
+  }
+
+  //----------------------------------------------------------------------------
+  size_t LZ4Compress(const unsigned char* src, size_t srcSize, unsigned char* dst, size_t dstCapacity)
+  {
+    const unsigned char* ip = src;
+    const unsigned char* anchor = src;
+    const unsigned char* const iend = src + srcSize;
+    unsigned char* op = dst;
+    unsigned char* const oend = dst + dstCapacity;
+
+    if (srcSize > MF_LIMIT)
+    {
+      std::vector<uint32_t> hashTable(size_t(1) << HASH_LOG, 0);
+      const unsigned char* const mflimit = iend - MF_LIMIT;
+      const unsigned char* const matchlimit = iend - LAST_LITERALS;
+      unsigned int searchCount = 1 << SKIP_TRIGGER;
+
+      while (ip <= mflimit)
+      {
+        uint32_t sequence = Read32(ip);
+        uint32_t h = Hash(sequence);
+        const unsigned char* ref = src + hashTable[h];
+        hashTable[h] = static_cast<uint32_t>(ip - src);
+
+        if (ref >= ip || static_cast<size_t>(ip - ref) > MAX_OFFSET || Read32(ref) != sequence)
+        {
+          ip += searchCount++ >> SKIP_TRIGGER;
+          continue;
+        }
+        searchCount = 1 << SKIP_TRIGGER;
+
+        // Extend the match backwards over pending literals, then forwards
+        while (ip > anchor && ref > src && ip[-1] == ref[-1])
+        {
+          --ip;
+          --ref;
+        }
+        const unsigned char* matchEnd = ip + MIN_MATCH;
+        const unsigned char* refEnd = ref + MIN_MATCH;
+        while (matchEnd < matchlimit && *matchEnd == *refEnd)
+        {
+          ++matchEnd;
+          ++refEnd;
+        }
+
+        size_t literalLength = static_cast<size_t>(ip - anchor);
+        size_t matchLength = static_cast<size_t>(matchEnd - ip) - MIN_MATCH;
+        if (static_cast<size_t>(oend - op) < 1 + literalLength / 255 + 1 + literalLength + 2 + matchLength / 255 + 1)
+        {
+          return 0;
+        }
+
+        // Sequence: token, literal length, literals, offset, match length
+        unsigned char* token = op++;
+        if (literalLength >= 15)
+        {
+          *token = 15 << 4;
+          op = WriteLength(op, literalLength - 15);
+        }
+        else
+        {
+          *token = static_cast<unsigned char>(literalLength << 4);
+        }
+        memcpy(op, anchor, literalLength);
+        op += literalLength;
+
+        size_t offset = static_cast<size_t>(ip - ref);
+        *op++ = static_cast<unsigned char>(offset & 0xFF);
+        *op++ = static_cast<unsigned char>(offset >> 8);
+
+        if (matchLength >= 15)
+        {
+          *token |= 15;
+          op = WriteLength(op, matchLength - 15);
+        }
+        else
+        {
+          *token |= static_cast<unsigned char>(matchLength);
+        }
+
+        ip = matchEnd;
+        anchor = ip;
+        if (ip <= mflimit)
+        {
+          hashTable[Hash(Read32(ip - 2))] = static_cast<uint32_t>(ip - 2 - src);
+        }
+      }
+    }
+
+    // Last sequence, literals only
+    size_t literalLength = static_cast<size_t>(iend - anchor);
+    if (static_cast<size_t>(oend - op) < 1 + literalLength / 255 + 1 + literalLength)
+    {
+      return 0;
+    }
+    if (literalLength >= 15)
+    {
+      *op++ = 15 << 4;
+      op = WriteLength(op, literalLength - 15);
+    }
+    else
+    {
+      *op++ = static_cast<unsigned char>(literalLength << 4);
+    }
+    memcpy(op, anchor, literalLength);
+    op += literalLength;
+
+    return static_cast<size_t>(op - dst);
+  }
+
+  //----------------------------------------------------------------------------
+  bool LZ4Decompress(const unsigned char* src, size_t srcSize, unsigned char* dst, size_t dstSize)
+  {
+    const unsigned char* ip = src;
+    const unsigned char* const iend = src + srcSize;
+    unsigned char* op = dst;
+    unsigned char* const oend = dst + dstSize;
+
+    while (ip < iend)
+    {
+      unsigned char token = *ip++;
+
+      size_t literalLength = token >> 4;
+      if (literalLength == 15 && !ReadLength(ip, iend, literalLength))
+      {
+        return false;
+      }
+      if (literalLength > static_cast<size_t>(iend - ip) || literalLength > static_cast<size_t>(oend - op))
+      {
+        return false;
+      }
+      memcpy(op, ip, literalLength);
+      op += literalLength;
+      ip += literalLength;
+
+      if (ip == iend)
+      {
+        // The last sequence has no match
+        break;
+      }
+
+      if (iend - ip < 2)
+      {
+        return false;
+      }
+      size_t offset = static_cast<size_t>(ip[0]) | (static_cast<size_t>(ip[1]) << 8);
+      ip += 2;
+      if (offset == 0 || offset > static_cast<size_t>(op - dst))
+      {
+        return false;
+      }
+
+      size_t matchLength = token & 15;
+      if (matchLength == 15 && !ReadLength(ip, iend, matchLength))
+      {
+        return false;
+      }
+      matchLength += MIN_MATCH;
+      if (matchLength > static_cast<size_t>(oend - op))
+      {
+        return false;
+      }
+
+      const unsigned char* match = op - offset;
+      if (offset >= matchLength)
+      {
+        memcpy(op, match, matchLength);
+        op += matchLength;
+      }
+      else
+      {
+        // Overlapping copy repeats the last offset bytes, every copied span doubles the bytes that can be copied at once
+        while (matchLength > 0)
+        {
+          const size_t span = (static_cast<size_t>(op - match) < matchLength) ? static_cast<size_t>(op - match) : matchLength;
+          memcpy(op, match, span);
+          op += span;
+          matchLength -= span;
+        }
+      }
+    }
+
+    return op == oend;
+  }
+
+  //----------------------------------------------------------------------------
+  void DeltaEncode(const unsigned char* frame, const unsigned char* reference, size_t size, std::vector<unsigned char>& encoded)
+  {
+    // Sequence of [unchanged count][changed count][changed count XOR residual bytes]
+    encoded.clear();
+    encoded.reserve(size / 16);
+
+    size_t i = 0;
+    while (i < size)
+    {
+      size_t unchanged = CountUnchanged(frame + i, reference + i, size - i);
+      i += unchanged;
+
+      // A changed run ends at the first run of MIN_UNCHANGED_RUN unchanged bytes
+      size_t changedStart = i;
+      size_t changedEnd = i;
+      for (size_t j = i; j < size; ++j)
+      {
+        if (frame[j] != reference[j])
+        {
+          changedEnd = j + 1;
+        }
+        else if (j + 1 - changedEnd >= MIN_UNCHANGED_RUN)
+        {
+          break;
+        }
+      }
+
+      WriteVarInt(encoded, unchanged);
+      WriteVarInt(encoded, changedEnd - changedStart);
+      const size_t residualStart = encoded.size();
+      encoded.resize(residualStart + changedEnd - changedStart);
+      XorBytes(frame + changedStart, reference + changedStart, encoded.data() + residualStart, changedEnd - changedStart);
+      i = changedEnd;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  size_t DeltaEncodeBound(size_t size)
+  {
+    // Every run but the first and the last has MIN_UNCHANGED_RUN unchanged bytes and at least one changed byte,
+    // the two counts of a run are varints and a varint of value v takes at most 1 + v / 127 bytes
+    const size_t runs = size / (MIN_UNCHANGED_RUN + 1) + 2;
+    return size + 2 * runs + size / 127;
+  }
+
+  //----------------------------------------------------------------------------
+  bool DeltaDecode(const unsigned char* encoded, size_t encodedSize, const unsigned char* reference, unsigned char* dst, size_t size)
+  {
+    const unsigned char* ip = encoded;
+    const unsigned char* const iend = encoded + encodedSize;
+    size_t pos = 0;
+
+    while (ip < iend)
+    {
+      size_t unchanged(0);
+      size_t changed(0);
+      if (!ReadVarInt(ip, iend, unchanged) || !ReadVarInt(ip, iend, changed))
+      {
+        return false;
+      }
+      if (unchanged > size - pos)
+      {
+        return false;
+      }
+      memcpy(dst + pos, reference + pos, unchanged);
+      pos += unchanged;
+
+      if (changed > size - pos || changed > static_cast<size_t>(iend - ip))
+      {
+        return false;
+      }
+      XorBytes(reference + pos, ip, dst + pos, changed);
+      pos += changed;
+      ip += changed;
+    }
+
+    return pos == size;
+  }
+}
@@ -0,0 +1,68 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+#pragma once
+
+// STL includes
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace UWPOpenIGTLink
+{
+  /// Name of the LZ4 block encoding as it appears in messages
+  extern const char* IMAGE_COMPRESSION_LZ4;
+  /// IMAGE message metadata naming the encoding of the scalars, absent if they are raw
+  extern const char* IMAGE_COMPRESSION_METADATA_KEY;
+  /// IMAGE message metadata holding the number of bytes of encoded scalars
+  extern const char* COMPRESSED_IMAGE_SIZE_METADATA_KEY;
+
+  /// Worst case size of the LZ4 block encoding of srcSize bytes
+  size_t LZ4CompressBound(size_t srcSize);
+
+  /// Compress src into dst using the LZ4 block format, returns the compressed size or 0 if dst is too small
+  size_t LZ4Compress(const unsigned char* src, size_t srcSize, unsigned char* dst, size_t dstCapacity);
+
+  /// Decompress an LZ4 block into dst, returns false if the block is malformed or does not decode to exactly dstSize bytes
+  bool LZ4Decompress(const unsigned char* src, size_t srcSize, unsigned char* dst, size_t dstSize);
+
+  /// Encode frame as its XOR residual against reference, runs of unchanged bytes are run-length packed
+  void DeltaEncode(const unsigned char* frame, const unsigned char* reference, size_t size, std::vector<unsigned char>& encoded);
+
+  /// Worst case size of the DeltaEncode residual of size bytes
+  size_t DeltaEncodeBound(size_t size);
+
+  /// Rebuild a frame from its reference and a DeltaEncode residual, returns false if the residual is malformed or does not cover exactly size bytes
+  bool DeltaDecode(const unsigned char* encoded, size_t encodedSize, const unsigned char* reference, unsigned char* dst, size_t size);
+
+  /// State of one stream of delta encoded frames, kept by the sender and receiver of the stream
+  struct DeltaStreamState
+  {
+    std::shared_ptr<unsigned char>  Reference = nullptr;  // the last frame of the stream, residuals are relative to it
+    size_t                          ReferenceSize = 0;
+    uint32_t                        FrameNumber = 0;      // number of the reference frame
+    bool                            Valid = false;        // false until a key frame has been sent/received
+    uint32_t                        KeyFrameInterval = 30;
+  };
+}
@@ -0,0 +1,448 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+// Local includes
+#include "pch.h"
+#include "HalfFloat.h"
+#include "Image.h"
+#include "ImageBufferPool.h"
+#include "ImagePyramid.h"
+#include "PixelConversion.h"
+
+// STL includes
+#include <type_traits>
+
+#if defined(_M_IX86) || defined(_M_X64)
+  #define IMAGE_PYRAMID_X86
+  #include <emmintrin.h>
+#endif
+
+namespace UWPOpenIGTLink
+{
+  namespace
+  {
+    // Sums are accumulated in a type wide enough for the 16x weight of the gaussian kernel
+    template<typename ScalarType> struct PyramidAccumulator { typedef int32 Type; };
+    template<> struct PyramidAccumulator<int32> { typedef int64 Type; };
+    template<> struct PyramidAccumulator<uint32> { typedef int64 Type; };
+    template<> struct PyramidAccumulator<float> { typedef float Type; };
+    template<> struct PyramidAccumulator<double> { typedef double Type; };
+
+    //----------------------------------------------------------------------------
+    // Divide a sum of weight 4 (shift 2) or 16 (shift 4), rounding half up
+    template<typename ScalarType, typename AccumulatorType>
+    inline typename std::enable_if<std::is_integral<AccumulatorType>::value, ScalarType>::type Normalize(AccumulatorType sum, int shift)
+    {
+      return static_cast<ScalarType>((sum + (AccumulatorType(1) << (shift - 1))) >> shift);
+    }
+
+    //----------------------------------------------------------------------------
+    template<typename ScalarType, typename AccumulatorType>
+    inline typename std::enable_if<std::is_floating_point<AccumulatorType>::value, ScalarType>::type Normalize(AccumulatorType sum, int shift)
+    {
+      return static_cast<ScalarType>(sum * (AccumulatorType(1) / AccumulatorType(1 << shift)));
+    }
+
+#if defined(IMAGE_PYRAMID_X86)
+    //----------------------------------------------------------------------------
+    inline void Widen8(__m128i value, bool isSigned, __m128i out[4])
+    {
+      __m128i low, high;
+      if (isSigned)
+      {
+        low = _mm_srai_epi16(_mm_unpacklo_epi8(value, value), 8);
+        high = _mm_srai_epi16(_mm_unpackhi_epi8(value, value), 8);
+        out[0] = _mm_srai_epi32(_mm_unpacklo_epi16(low, low), 16);
+        out[1] = _mm_srai_epi32(_mm_unpackhi_epi16(low, low), 16);
+        out[2] = _mm_srai_epi32(_mm_unpacklo_epi16(high, high), 16);
+        out[3] = _mm_srai_epi32(_mm_unpackhi_epi16(high, high), 16);
+      }
+      else
+      {
+        const __m128i zero = _mm_setzero_si128();
+        low = _mm_unpacklo_epi8(value, zero);
+        high = _mm_unpackhi_epi8(value, zero);
+        out[0] = _mm_unpacklo_epi16(low, zero);
+        out[1] = _mm_unpackhi_epi16(low, zero);
+        out[2] = _mm_unpacklo_epi16(high, zero);
+        out[3] = _mm_unpackhi_epi16(high, zero);
+      }
+    }
+
+    //----------------------------------------------------------------------------
+    inline void Widen16(__m128i value, bool isSigned, __m128i out[2])
+    {
+      if (isSigned)
+      {
+        out[0] = _mm_srai_epi32(_mm_unpacklo_epi16(value, value), 16);
+        out[1] = _mm_srai_epi32(_mm_unpackhi_epi16(value, value), 16);
+      }
+      else
+      {
+        const __m128i zero = _mm_setzero_si128();
+        out[0] = _mm_unpacklo_epi16(value, zero);
+        out[1] = _mm_unpackhi_epi16(value, zero);
+      }
+    }
+
+    //----------------------------------------------------------------------------
+    // Vertical pass of 8 or 16 bit integers widened to int32, returns the number of values processed
+    template<int BytesPerScalar>
+    size_t AccumulateIntegerRowsSSE2(const byte* previous, const byte* current, const byte* next, size_t count, bool isSigned, int32* accumulator)
+    {
+      const size_t valuesPerVector = 16 / BytesPerScalar;
+      const size_t widenedVectors = 4 / BytesPerScalar;
+      size_t i = 0;
+      for (; i + valuesPerVector <= count; i += valuesPerVector)
+      {
+        __m128i a[4], b[4], c[4];
+        const __m128i* rows[3] = { reinterpret_cast<const __m128i*>(current + i * BytesPerScalar), reinterpret_cast<const __m128i*>(next + i * BytesPerScalar),
+                                   previous == nullptr ? nullptr : reinterpret_cast<const __m128i*>(previous + i * BytesPerScalar)
+                                 };
+        if (BytesPerScalar == 1)
+        {
+          Widen8(_mm_loadu_si128(rows[0]), isSigned, a);
+          Widen8(_mm_loadu_si128(rows[1]), isSigned, b);
+        }
+        else
+        {
+          Widen16(_mm_loadu_si128(rows[0]), isSigned, a);
+          Widen16(_mm_loadu_si128(rows[1]), isSigned, b);
+        }
+        if (previous != nullptr)
+        {
+          // [1 2 1]
+          if (BytesPerScalar == 1)
+          {
+            Widen8(_mm_loadu_si128(rows[2]), isSigned, c);
+          }
+          else
+          {
+            Widen16(_mm_loadu_si128(rows[2]), isSigned, c);
+          }
+          for (size_t j = 0; j < widenedVectors; ++j)
+          {
+            a[j] = _mm_add_epi32(_mm_add_epi32(a[j], a[j]), _mm_add_epi32(b[j], c[j]));
+          }
+        }
+        else
+        {
+          for (size_t j = 0; j < widenedVectors; ++j)
+          {
+            a[j] = _mm_add_epi32(a[j], b[j]);
+          }
+        }
+        for (size_t j = 0; j < widenedVectors; ++j)
+        {
+          _mm_storeu_si128(reinterpret_cast<__m128i*>(accumulator + i + j * 4), a[j]);
+        }
+      }
+      return i;
+    }
+
+    //----------------------------------------------------------------------------
+    template<typename ScalarType, typename AccumulatorType>
+    size_t AccumulateRowsSSE2(const ScalarType*, const ScalarType*, const ScalarType*, size_t, AccumulatorType*)
+    {
+      return 0;
+    }
+
+    //----------------------------------------------------------------------------
+    template<> size_t AccumulateRowsSSE2(const uint8* previous, const uint8* current, const uint8* next, size_t count, int32* accumulator)
+    {
+      return AccumulateIntegerRowsSSE2<1>(previous, current, next, count, false, accumulator);
+    }
+
+    //----------------------------------------------------------------------------
+    template<> size_t AccumulateRowsSSE2(const int8* previous, const int8* current, const int8* next, size_t count, int32* accumulator)
+    {
+      return AccumulateIntegerRowsSSE2<1>(reinterpret_cast<const byte*>(previous), reinterpret_cast<const byte*>(current), reinterpret_cast<const byte*>(next), count, true, accumulator);
+    }
+
+    //----------------------------------------------------------------------------
+    template<> size_t AccumulateRowsSSE2(const uint16* previous, const uint16* current, const uint16* next, size_t count, int32* accumulator)
+    {
+      return AccumulateIntegerRowsSSE2<2>(reinterpret_cast<const byte*>(previous), reinterpret_cast<const byte*>(current), reinterpret_cast<const byte*>(next), count, false, accumulator);
+    }
+
+    //----------------------------------------------------------------------------
+    template<> size_t AccumulateRowsSSE2(const int16* previous, const int16* current, const int16* next, size_t count, int32* accumulator)
+    {
+      return AccumulateIntegerRowsSSE2<2>(reinterpret_cast<const byte*>(previous), reinterpret_cast<const byte*>(current), reinterpret_cast<const byte*>(next), count, true, accumulator);
+    }
+
+    //----------------------------------------------------------------------------
+    template<> size_t AccumulateRowsSSE2(const float* previous, const float* current, const float* next, size_t count, float* accumulator)
+    {
+      size_t i = 0;
+      for (; i + 4 <= count; i += 4)
+      {
+        __m128 sum = _mm_add_ps(_mm_loadu_ps(current + i), _mm_loadu_ps(next + i));
+        if (previous != nullptr)
+        {
+          sum = _mm_add_ps(sum, _mm_add_ps(_mm_loadu_ps(previous + i), _mm_loadu_ps(current + i)));
+        }
+        _mm_storeu_ps(accumulator + i, sum);
+      }
+      return i;
+    }
+
+    //----------------------------------------------------------------------------
+    template<> size_t AccumulateRowsSSE2(const double* previous, const double* current, const double* next, size_t count, double* accumulator)
+    {
+      size_t i = 0;
+      for (; i + 2 <= count; i += 2)
+      {
+        __m128d sum = _mm_add_pd(_mm_loadu_pd(current + i), _mm_loadu_pd(next + i));
+        if (previous != nullptr)
+        {
+          sum = _mm_add_pd(sum, _mm_add_pd(_mm_loadu_pd(previous + i), _mm_loadu_pd(current + i)));
+        }
+        _mm_storeu_pd(accumulator + i, sum);
+      }
+      return i;
+    }
+#endif
+
+    //----------------------------------------------------------------------------
+    // Vertical pass, current + next for the box filter, previous + 2 current + next for the gaussian (previous is nullptr for the box filter)
+    template<typename ScalarType, typename AccumulatorType>
+    void AccumulateRows(const ScalarType* previous, const ScalarType* current, const ScalarType* next, size_t count, AccumulatorType* accumulator, bool useSSE2)
+    {
+      size_t i = 0;
+#if defined(IMAGE_PYRAMID_X86)
+      if (useSSE2)
+      {
+        i = AccumulateRowsSSE2(previous, current, next, count, accumulator);
+      }
+#endif
+      if (previous != nullptr)
+      {
+        for (; i < count; ++i)
+        {
+          // Same order of additions as the vector path so floating point results match
+          accumulator[i] = (AccumulatorType(current[i]) + AccumulatorType(next[i])) + (AccumulatorType(previous[i]) + AccumulatorType(current[i]));
+        }
+      }
+      else
+      {
+        for (; i < count; ++i)
+        {
+          accumulator[i] = AccumulatorType(current[i]) + AccumulatorType(next[i]);
+        }
+      }
+    }
+
+    //----------------------------------------------------------------------------
+    // Horizontal pass of the accumulated rows into one row of the level
+    template<typename ScalarType, typename AccumulatorType>
+    void ReduceRow(const AccumulatorType* accumulator, size_t width, size_t levelWidth, uint16 numberOfScalarComponents, bool gaussian, ScalarType* destination)
+    {
+      const size_t components = numberOfScalarComponents;
+      for (size_t x = 0; x < levelWidth; ++x)
+      {
+        const AccumulatorType* current = accumulator + 2 * x * components;
+        const AccumulatorType* next = 2 * x + 1 < width ? current + components : current;
+        ScalarType* pixel = destination + x * components;
+        if (gaussian)
+        {
+          const AccumulatorType* previous = x > 0 ? current - components : current;
+          for (size_t c = 0; c < components; ++c)
+          {
+            pixel[c] = Normalize<ScalarType>(previous[c] + current[c] * 2 + next[c], 4);
+          }
+        }
+        else
+        {
+          for (size_t c = 0; c < components; ++c)
+          {
+            pixel[c] = Normalize<ScalarType>(current[c] + next[c], 2);
+          }
+        }
+      }
+    }
+
+    //----------------------------------------------------------------------------
+    template<typename ScalarType>
+    void Downsample(const byte* source, const FrameSize& size, uint16 numberOfScalarComponents, PYRAMID_FILTER filter, const FrameSize& levelSize, byte* destination)
+    {
+      typedef typename PyramidAccumulator<ScalarType>::Type AccumulatorType;
+
+      const bool useSSE2 = PixelConversion::GetInstructionSetLevel() >= PIXEL_CONVERSION_ISA_SSE2;
+      const bool gaussian = filter == PYRAMID_FILTER_GAUSSIAN;
+      const size_t rowValues = size_t(size[0]) * numberOfScalarComponents;
+      const size_t levelRowValues = size_t(levelSize[0]) * numberOfScalarComponents;
+      std::vector<AccumulatorType> accumulator(rowValues);
+
+      for (size_t z = 0; z < size[2]; ++z)
+      {
+        const ScalarType* slice = reinterpret_cast<const ScalarType*>(source) + z * size[1] * rowValues;
+        ScalarType* levelSlice = reinterpret_cast<ScalarType*>(destination) + z * levelSize[1] * levelRowValues;
+        for (size_t y = 0; y < levelSize[1]; ++y)
+        {
+          // Rows past the edges are clamped
+          const ScalarType* current = slice + 2 * y * rowValues;
+          const ScalarType* next = 2 * y + 1 < size[1] ? current + rowValues : current;
+          const ScalarType* previous = gaussian ? (y > 0 ? current - rowValues : current) : nullptr;
+          AccumulateRows(previous, current, next, rowValues, accumulator.data(), useSSE2);
+          ReduceRow(accumulator.data(), size[0], levelSize[0], numberOfScalarComponents, gaussian, levelSlice + y * levelRowValues);
+        }
+      }
+    }
+
+    //----------------------------------------------------------------------------
+    // Half values are widened to float32, filtered with the float32 kernels and rounded back to half
+    void DownsampleFloat16(const byte* source, const FrameSize& size, uint16 numberOfScalarComponents, PYRAMID_FILTER filter, const FrameSize& levelSize, byte* destination)
+    {
+      const size_t sourceCount = size_t(size[0]) * size[1] * size[2] * numberOfScalarComponents;
+      const size_t levelCount = size_t(levelSize[0]) * levelSize[1] * levelSize[2] * numberOfScalarComponents;
+      std::vector<float> sourceValues(sourceCount);
+      std::vector<float> levelValues(levelCount);
+
+      ConvertFloat16ToFloat32(reinterpret_cast<const uint16_t*>(source), sourceValues.data(), sourceCount);
+      Downsample<float>(reinterpret_cast<const byte*>(sourceValues.data()), size, numberOfScalarComponents, filter, levelSize, reinterpret_cast<byte*>(levelValues.data()));
+      ConvertFloat32ToFloat16(levelValues.data(), reinterpret_cast<uint16_t*>(destination), levelCount);
+    }
+
+    //----------------------------------------------------------------------------
+    bool DownsampleLevel(const byte* source, const FrameSize& size, uint16 numberOfScalarComponents, IGTL_SCALAR_TYPE scalarType, PYRAMID_FILTER filter, const FrameSize& levelSize, byte* destination)
+    {
+      switch (scalarType)
+      {
+        case IGTL_SCALARTYPE_INT8:
+          Downsample<int8>(source, size, numberOfScalarComponents, filter, levelSize, destination);
+          return true;
+        case IGTL_SCALARTYPE_UINT8:
+          Downsample<uint8>(source, size, numberOfScalarComponents, filter, levelSize, destination);
+          return true;
+        case IGTL_SCALARTYPE_INT16:
+          Downsample<int16>(source, size, numberOfScalarComponents, filter, levelSize, destination);
+          return true;
+        case IGTL_SCALARTYPE_UINT16:
+          Downsample<uint16>(source, size, numberOfScalarComponents, filter, levelSize, destination);
+          return true;
+        case IGTL_SCALARTYPE_INT32:
+          Downsample<int32>(source, size, numberOfScalarComponents, filter, levelSize, destination);
+          return true;
+        case IGTL_SCALARTYPE_UINT32:
+          Downsample<uint32>(source, size, numberOfScalarComponents, filter, levelSize, destination);
+          return true;
+        case IGTL_SCALARTYPE_FLOAT32:
+          Downsample<float>(source, size, numberOfScalarComponents, filter, levelSize, destination);
+          return true;
+        case IGTL_SCALARTYPE_FLOAT64:
+          Downsample<double>(source, size, numberOfScalarComponents, filter, levelSize, destination);
+          return true;
+        case IGTL_SCALARTYPE_FLOAT16:
+          DownsampleFloat16(source, size, numberOfScalarComponents, filter, levelSize, destination);
+          return true;
+        default:
+          return false;
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  std::shared_ptr<ImagePyramid> ImagePyramid::Generate(const byte* data, const FrameSize& size, uint16 numberOfScalarComponents, IGTL_SCALAR_TYPE scalarType, PYRAMID_FILTER filter, uint16 maximumLevels)
+  {
+    if (data == nullptr || !IsFilterSupported(numberOfScalarComponents, scalarType) || maximumLevels == 0 ||
+        size[0] == 0 || size[1] == 0 || size[2] == 0 || (size[0] == 1 && size[1] == 1))
+    {
+      return nullptr;
+    }
+
+    auto pyramid = std::make_shared<ImagePyramid>();
+    pyramid->m_baseSize = size;
+    pyramid->m_filter = filter;
+
+    const size_t bytesPerPixel = Image::GetNumberOfBytesPerScalar(scalarType) * numberOfScalarComponents;
+    const byte* source = data;
+    FrameSize sourceSize = size;
+    while (pyramid->m_levels.size() < maximumLevels && (sourceSize[0] > 1 || sourceSize[1] > 1))
+    {
+      Level level;
+      level.Size = { (sourceSize[0] + 1) / 2, (sourceSize[1] + 1) / 2, sourceSize[2] };
+      level.Data = ImageBufferPool::GetInstance()->Acquire(bytesPerPixel * level.Size[0] * level.Size[1] * level.Size[2]);
+      if (level.Data == nullptr || !DownsampleLevel(source, sourceSize, numberOfScalarComponents, scalarType, filter, level.Size, level.Data.get()))
+      {
+        // Never publish a level whose pixels were not written
+        return nullptr;
+      }
+
+      pyramid->m_levels.push_back(level);
+      source = pyramid->m_levels.back().Data.get();
+      sourceSize = level.Size;
+    }
+
+    return pyramid;
+  }
+
+  //----------------------------------------------------------------------------
+  bool ImagePyramid::IsFilterSupported(uint16 numberOfScalarComponents, IGTL_SCALAR_TYPE scalarType)
+  {
+    if (numberOfScalarComponents == 0)
+    {
+      return false;
+    }
+
+    switch (scalarType)
+    {
+      case IGTL_SCALARTYPE_INT8:
+      case IGTL_SCALARTYPE_UINT8:
+      case IGTL_SCALARTYPE_INT16:
+      case IGTL_SCALARTYPE_UINT16:
+      case IGTL_SCALARTYPE_INT32:
+      case IGTL_SCALARTYPE_UINT32:
+      case IGTL_SCALARTYPE_FLOAT32:
+      case IGTL_SCALARTYPE_FLOAT64:
+      case IGTL_SCALARTYPE_FLOAT16:
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  const FrameSize& ImagePyramid::GetBaseSize() const
+  {
+    return m_baseSize;
+  }
+
+  //----------------------------------------------------------------------------
+  PYRAMID_FILTER ImagePyramid::GetFilter() const
+  {
+    return m_filter;
+  }
+
+  //----------------------------------------------------------------------------
+  size_t ImagePyramid::GetNumberOfLevels() const
+  {
+    return m_levels.size();
+  }
+
+  //----------------------------------------------------------------------------
+  const ImagePyramid::Level& ImagePyramid::GetLevel(size_t index) const
+  {
+    return m_levels[index];
+  }
+}
@@ -0,0 +1,73 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+#pragma once
+
+// Local includes
+#include "IGTCommon.h"
+
+// STL includes
+#include <memory>
+#include <vector>
+
+namespace UWPOpenIGTLink
+{
+  /// PYRAMID_FILTER - Defines the filters an image pyramid level is downsampled with
+  enum PYRAMID_FILTER
+  {
+    PYRAMID_FILTER_BOX,       /*!< average of each 2x2 block of pixels */
+    PYRAMID_FILTER_GAUSSIAN   /*!< [1 2 1] x [1 2 1] / 16 kernel centred on each even pixel, smoother but slightly slower */
+  };
+
+  /*!
+    The downsampled levels of an image, each half the width and height of the previous one (rounded up), down to 1x1 pixel.
+    Slices of a volume are downsampled independently, the number of slices is unchanged. Level pixels are stored in pooled buffers
+    and are never modified once generated, so a pyramid can be shared by every image referencing the same pixels.
+  */
+  class ImagePyramid
+  {
+  public:
+    struct Level
+    {
+      std::shared_ptr<byte>   Data;
+      FrameSize               Size;
+    };
+
+    /// Generate at most maximumLevels levels from the pixels of an image, nullptr if the scalar type is not supported or the image is already 1x1
+    static std::shared_ptr<ImagePyramid> Generate(const byte* data, const FrameSize& size, uint16 numberOfScalarComponents, IGTL_SCALAR_TYPE scalarType, PYRAMID_FILTER filter, uint16 maximumLevels);
+    static bool IsFilterSupported(uint16 numberOfScalarComponents, IGTL_SCALAR_TYPE scalarType);
+
+    /// Size of the image the pyramid was generated from
+    const FrameSize& GetBaseSize() const;
+    PYRAMID_FILTER GetFilter() const;
+    /// Number of downsampled levels, the image itself is not included
+    size_t GetNumberOfLevels() const;
+    /// Downsampled level index, 0 is half the size of the image
+    const Level& GetLevel(size_t index) const;
+
+  protected:
+    FrameSize               m_baseSize;
+    PYRAMID_FILTER          m_filter = PYRAMID_FILTER_BOX;
+    std::vector<Level>      m_levels;
+  };
+}
@@ -0,0 +1,703 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+// Local includes
+#include "pch.h"
+#include "Image.h"
+#include "ImageStatistics.h"
+#include "PixelConversion.h"
+#include "VolumeView.h"
+
+// STL includes
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+// Windows includes
+#include <ppl.h>
+
+#if defined(_M_IX86) || defined(_M_X64)
+  #define IMAGE_STATISTICS_X86
+  #include <emmintrin.h>
+#endif
+
+namespace UWPOpenIGTLink
+{
+  namespace
+  {
+    // Samples per band when computing in parallel
+    static const size_t PARALLEL_BAND_SIZE = 256 * 1024;
+
+    // Values per call to the SSE2 row kernels, rows may be longer than their 32 bit lanes can sum
+    static const size_t SSE2_ROW_CHUNK = 64 * 1024;
+
+    //----------------------------------------------------------------------------
+    // Moments of a set of values and their per value counts (integer types) or histogram bins (float32)
+    struct StatisticsPartial
+    {
+      uint64                Count = 0;
+      double                Minimum = std::numeric_limits<double>::infinity();
+      double                Maximum = -std::numeric_limits<double>::infinity();
+      double                Mean = 0.0;
+      double                M2 = 0.0; // sum of squared differences from the mean
+      std::vector<uint64>   Counts;
+
+      void Merge(uint64 count, double mean, double m2, double minimum, double maximum)
+      {
+        Minimum = minimum < Minimum ? minimum : Minimum;
+        Maximum = maximum > Maximum ? maximum : Maximum;
+        if (count == 0)
+        {
+          return;
+        }
+        if (Count == 0)
+        {
+          Count = count;
+          Mean = mean;
+          M2 = m2;
+          return;
+        }
+
+        // Chan et al. pairwise update, stable when the means are large compared to the spread
+        const double total = static_cast<double>(Count + count);
+        const double delta = mean - Mean;
+        Mean += delta * count / total;
+        M2 += m2 + delta * delta * (static_cast<double>(Count) * count / total);
+        Count += count;
+      }
+
+      void Merge(const StatisticsPartial& other)
+      {
+        Merge(other.Count, other.Mean, other.M2, other.Minimum, other.Maximum);
+        if (Counts.size() < other.Counts.size())
+        {
+          Counts.resize(other.Counts.size(), 0);
+        }
+        for (size_t i = 0; i < other.Counts.size(); ++i)
+        {
+          Counts[i] += other.Counts[i];
+        }
+      }
+    };
+
+    // Integer rows are summed exactly, float rows in double relative to their first value
+    template<typename ScalarType> struct RowAccumulator { typedef int64 Sum; typedef uint64 SumOfSquares; };
+    template<> struct RowAccumulator<float> { typedef double Sum; typedef double SumOfSquares; };
+
+    //----------------------------------------------------------------------------
+    template<typename ScalarType>
+    struct RowSums
+    {
+      typedef typename RowAccumulator<ScalarType>::Sum          SumType;
+      typedef typename RowAccumulator<ScalarType>::SumOfSquares SumOfSquaresType;
+
+      ScalarType        Minimum;
+      ScalarType        Maximum;
+      SumType           Pivot = 0;
+      SumType           Sum = 0;
+      SumOfSquaresType  SumOfSquares = 0;
+    };
+
+    //----------------------------------------------------------------------------
+    template<typename ScalarType>
+    inline size_t GetValueIndex(ScalarType value)
+    {
+      return static_cast<size_t>(static_cast<int64>(value) - std::numeric_limits<ScalarType>::min());
+    }
+
+#if defined(IMAGE_STATISTICS_X86)
+    //----------------------------------------------------------------------------
+    template<typename ScalarType, typename LaneType, size_t Lanes>
+    void ReduceMinimumMaximum(__m128i minimum, __m128i maximum, RowSums<ScalarType>& sums)
+    {
+      alignas(16) LaneType minimumLanes[Lanes];
+      alignas(16) LaneType maximumLanes[Lanes];
+      _mm_store_si128(reinterpret_cast<__m128i*>(minimumLanes), minimum);
+      _mm_store_si128(reinterpret_cast<__m128i*>(maximumLanes), maximum);
+      for (size_t j = 0; j < Lanes; ++j)
+      {
+        sums.Minimum = static_cast<ScalarType>(minimumLanes[j]) < sums.Minimum ? static_cast<ScalarType>(minimumLanes[j]) : sums.Minimum;
+        sums.Maximum = static_cast<ScalarType>(maximumLanes[j]) > sums.Maximum ? static_cast<ScalarType>(maximumLanes[j]) : sums.Maximum;
+      }
+    }
+
+    //----------------------------------------------------------------------------
+    inline uint64 ReduceEpi64(__m128i value)
+    {
+      alignas(16) uint64 lanes[2];
+      _mm_store_si128(reinterpret_cast<__m128i*>(lanes), value);
+      return lanes[0] + lanes[1];
+    }
+
+    //----------------------------------------------------------------------------
+    // Returns the number of leading values accumulated, the caller accumulates the rest
+    template<typename ScalarType>
+    size_t AccumulateRowSSE2(const ScalarType*, size_t, RowSums<ScalarType>&)
+    {
+      return 0;
+    }
+
+    //----------------------------------------------------------------------------
+    // The 32 bit lanes of the 8 and 16 bit kernels cannot overflow within SSE2_ROW_CHUNK values
+    template<>
+    size_t AccumulateRowSSE2(const uint8* values, size_t count, RowSums<uint8>& sums)
+    {
+      const __m128i zero = _mm_setzero_si128();
+      __m128i minimum = _mm_set1_epi8(-1);
+      __m128i maximum = zero;
+      __m128i sum = zero;
+      __m128i sumOfSquares = zero;
+      size_t i = 0;
+      for (; i + 16 <= count; i += 16)
+      {
+        const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+        minimum = _mm_min_epu8(minimum, value);
+        maximum = _mm_max_epu8(maximum, value);
+        sum = _mm_add_epi64(sum, _mm_sad_epu8(value, zero));
+        const __m128i low = _mm_unpacklo_epi8(value, zero);
+        const __m128i high = _mm_unpackhi_epi8(value, zero);
+        sumOfSquares = _mm_add_epi32(sumOfSquares, _mm_add_epi32(_mm_madd_epi16(low, low), _mm_madd_epi16(high, high)));
+      }
+      if (i == 0)
+      {
+        return 0;
+      }
+
+      ReduceMinimumMaximum<uint8, uint8, 16>(minimum, maximum, sums);
+      sums.Sum += ReduceEpi64(sum);
+      sums.SumOfSquares += ReduceEpi64(_mm_add_epi64(_mm_unpacklo_epi32(sumOfSquares, zero), _mm_unpackhi_epi32(sumOfSquares, zero)));
+      return i;
+    }
+
+    //----------------------------------------------------------------------------
+    template<>
+    size_t AccumulateRowSSE2(const uint16* values, size_t count, RowSums<uint16>& sums)
+    {
+      // SSE2 only compares signed 16 bit values, the sign bit is flipped to order unsigned values the same way
+      const __m128i zero = _mm_setzero_si128();
+      const __m128i bias = _mm_set1_epi16(-32768);
+      __m128i minimum = _mm_set1_epi16(32767);
+      __m128i maximum = _mm_set1_epi16(-32768);
+      __m128i sum = zero;
+      __m128i sumOfSquares = zero;
+      size_t i = 0;
+      for (; i + 8 <= count; i += 8)
+      {
+        const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+        const __m128i biased = _mm_xor_si128(value, bias);
+        minimum = _mm_min_epi16(minimum, biased);
+        maximum = _mm_max_epi16(maximum, biased);
+        const __m128i low = _mm_unpacklo_epi16(value, zero);
+        const __m128i high = _mm_unpackhi_epi16(value, zero);
+        sum = _mm_add_epi32(sum, _mm_add_epi32(low, high));
+        // Squares of the even and odd 32 bit lanes as 64 bit products
+        sumOfSquares = _mm_add_epi64(sumOfSquares, _mm_add_epi64(_mm_mul_epu32(low, low), _mm_mul_epu32(high, high)));
+        const __m128i lowOdd = _mm_srli_epi64(low, 32);
+        const __m128i highOdd = _mm_srli_epi64(high, 32);
+        sumOfSquares = _mm_add_epi64(sumOfSquares, _mm_add_epi64(_mm_mul_epu32(lowOdd, lowOdd), _mm_mul_epu32(highOdd, highOdd)));
+      }
+      if (i == 0)
+      {
+        return 0;
+      }
+
+      ReduceMinimumMaximum<uint16, uint16, 8>(_mm_xor_si128(minimum, bias), _mm_xor_si128(maximum, bias), sums);
+      sums.Sum += ReduceEpi64(_mm_add_epi64(_mm_unpacklo_epi32(sum, zero), _mm_unpackhi_epi32(sum, zero)));
+      sums.SumOfSquares += ReduceEpi64(sumOfSquares);
+      return i;
+    }
+
+    //----------------------------------------------------------------------------
+    template<>
+    size_t AccumulateRowSSE2(const int16* values, size_t count, RowSums<int16>& sums)
+    {
+      const __m128i zero = _mm_setzero_si128();
+      const __m128i ones = _mm_set1_epi16(1);
+      __m128i minimum = _mm_set1_epi16(32767);
+      __m128i maximum = _mm_set1_epi16(-32768);
+      __m128i sum = zero;
+      __m128i sumOfSquares = zero;
+      size_t i = 0;
+      for (; i + 8 <= count; i += 8)
+      {
+        const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+        minimum = _mm_min_epi16(minimum, value);
+        maximum = _mm_max_epi16(maximum, value);
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(value, ones));
+        // A pair of squares is at most 2^31, which fits the 32 bit lanes when read as unsigned
+        const __m128i squares = _mm_madd_epi16(value, value);
+        sumOfSquares = _mm_add_epi64(sumOfSquares, _mm_add_epi64(_mm_unpacklo_epi32(squares, zero), _mm_unpackhi_epi32(squares, zero)));
+      }
+      if (i == 0)
+      {
+        return 0;
+      }
+
+      ReduceMinimumMaximum<int16, int16, 8>(minimum, maximum, sums);
+      alignas(16) int32 sumLanes[4];
+      _mm_store_si128(reinterpret_cast<__m128i*>(sumLanes), sum);
+      sums.Sum += int64(sumLanes[0]) + sumLanes[1] + sumLanes[2] + sumLanes[3];
+      sums.SumOfSquares += ReduceEpi64(sumOfSquares);
+      return i;
+    }
+
+    //----------------------------------------------------------------------------
+    template<>
+    size_t AccumulateRowSSE2(const float* values, size_t count, RowSums<float>& sums)
+    {
+      // min/max return their second operand if either is NaN, which skips NaN values
+      __m128 minimum = _mm_set1_ps(std::numeric_limits<float>::infinity());
+      __m128 maximum = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+      const __m128d pivot = _mm_set1_pd(sums.Pivot);
+      __m128d sum = _mm_setzero_pd();
+      __m128d sumOfSquares = _mm_setzero_pd();
+      size_t i = 0;
+      for (; i + 4 <= count; i += 4)
+      {
+        const __m128 value = _mm_loadu_ps(values + i);
+        minimum = _mm_min_ps(value, minimum);
+        maximum = _mm_max_ps(value, maximum);
+        const __m128d low = _mm_sub_pd(_mm_cvtps_pd(value), pivot);
+        const __m128d high = _mm_sub_pd(_mm_cvtps_pd(_mm_movehl_ps(value, value)), pivot);
+        sum = _mm_add_pd(sum, _mm_add_pd(low, high));
+        sumOfSquares = _mm_add_pd(sumOfSquares, _mm_add_pd(_mm_mul_pd(low, low), _mm_mul_pd(high, high)));
+      }
+      if (i == 0)
+      {
+        return 0;
+      }
+
+      alignas(16) float minimumLanes[4];
+      alignas(16) float maximumLanes[4];
+      alignas(16) double sumLanes[2];
+      alignas(16) double squareLanes[2];
+      _mm_store_ps(minimumLanes, minimum);
+      _mm_store_ps(maximumLanes, maximum);
+      _mm_store_pd(sumLanes, sum);
+      _mm_store_pd(squareLanes, sumOfSquares);
+      for (size_t j = 0; j < 4; ++j)
+      {
+        sums.Minimum = minimumLanes[j] < sums.Minimum ? minimumLanes[j] : sums.Minimum;
+        sums.Maximum = maximumLanes[j] > sums.Maximum ? maximumLanes[j] : sums.Maximum;
+      }
+      sums.Sum += sumLanes[0] + sumLanes[1];
+      sums.SumOfSquares += squareLanes[0] + squareLanes[1];
+      return i;
+    }
+#endif
+
+    //----------------------------------------------------------------------------
+    // Accumulate count values, stride bytes apart, into partial. Integer values are also counted per value if partial.Counts is allocated.
+    template<typename ScalarType>
+    void AccumulateRow(const byte* row, size_t count, ptrdiff_t stride, bool useSSE2, StatisticsPartial& partial)
+    {
+      typedef typename RowSums<ScalarType>::SumType SumType;
+      typedef typename RowSums<ScalarType>::SumOfSquaresType SumOfSquaresType;
+
+      RowSums<ScalarType> sums;
+      sums.Minimum = std::numeric_limits<ScalarType>::has_infinity ? std::numeric_limits<ScalarType>::infinity() : std::numeric_limits<ScalarType>::max();
+      sums.Maximum = std::numeric_limits<ScalarType>::has_infinity ? -std::numeric_limits<ScalarType>::infinity() : std::numeric_limits<ScalarType>::lowest();
+      if (std::is_floating_point<ScalarType>::value)
+      {
+        ScalarType first;
+        memcpy(&first, row, sizeof(ScalarType));
+        sums.Pivot = static_cast<SumType>(first);
+      }
+
+      size_t i = 0;
+#if defined(IMAGE_STATISTICS_X86)
+      if (useSSE2 && stride == sizeof(ScalarType) && reinterpret_cast<uintptr_t>(row) % sizeof(ScalarType) == 0)
+      {
+        while (i < count)
+        {
+          const size_t chunk = count - i < SSE2_ROW_CHUNK ? count - i : SSE2_ROW_CHUNK;
+          const size_t accumulated = AccumulateRowSSE2(reinterpret_cast<const ScalarType*>(row) + i, chunk, sums);
+          i += accumulated;
+          if (accumulated < chunk)
+          {
+            break;
+          }
+        }
+      }
+#endif
+      for (; i < count; ++i)
+      {
+        ScalarType value;
+        memcpy(&value, row + i * stride, sizeof(ScalarType));
+        sums.Minimum = value < sums.Minimum ? value : sums.Minimum;
+        sums.Maximum = value > sums.Maximum ? value : sums.Maximum;
+        const SumType difference = static_cast<SumType>(value) - sums.Pivot;
+        sums.Sum += difference;
+        sums.SumOfSquares += static_cast<SumOfSquaresType>(difference * difference);
+      }
+
+      const double sum = static_cast<double>(sums.Sum);
+      double m2 = static_cast<double>(sums.SumOfSquares) - sum * sum / count;
+      partial.Merge(count, static_cast<double>(sums.Pivot) + sum / count, m2 > 0.0 ? m2 : 0.0, static_cast<double>(sums.Minimum), static_cast<double>(sums.Maximum));
+
+      if (std::is_integral<ScalarType>::value && !partial.Counts.empty())
+      {
+        for (i = 0; i < count; ++i)
+        {
+          ScalarType value;
+          memcpy(&value, row + i * stride, sizeof(ScalarType));
+          ++partial.Counts[GetValueIndex(value)];
+        }
+      }
+    }
+
+    //----------------------------------------------------------------------------
+    void BinRow(const byte* row, size_t count, ptrdiff_t stride, double minimum, double scale, StatisticsPartial& partial)
+    {
+      const double lastBin = static_cast<double>(partial.Counts.size() - 1);
+      for (size_t i = 0; i < count; ++i)
+      {
+        float value;
+        memcpy(&value, row + i * stride, sizeof(float));
+        if (value != value)
+        {
+          continue;
+        }
+        const double bin = (value - minimum) * scale;
+        ++partial.Counts[static_cast<size_t>(bin > 0.0 ? (bin < lastBin ? bin : lastBin) : 0.0)];
+      }
+    }
+
+    //----------------------------------------------------------------------------
+    // Rows of a region sampled every step pixels, enumerated y fastest
+    struct RegionRows
+    {
+      const VolumeView*   View;
+      size_t              Step;
+      size_t              Offset; // of the component in a pixel
+      size_t              RowsPerSlice;
+      size_t              RowCount;
+      size_t              SamplesPerRow;
+
+      const byte* GetRow(size_t row) const
+      {
+        return View->GetPixel(0, (row % RowsPerSlice) * Step, (row / RowsPerSlice) * Step) + Offset;
+      }
+    };
+
+    //----------------------------------------------------------------------------
+    // Apply rowFunction(row pointer, partial) to every row, concurrently over bands of rows if parallel is true, and merge the partials
+    template<typename RowFunction>
+    StatisticsPartial ReduceRows(const RegionRows& rows, size_t countEntries, bool parallel, const RowFunction& rowFunction)
+    {
+      const size_t rowsPerBand = rows.SamplesPerRow >= PARALLEL_BAND_SIZE ? 1 : PARALLEL_BAND_SIZE / rows.SamplesPerRow;
+      const size_t bandCount = (rows.RowCount + rowsPerBand - 1) / rowsPerBand;
+
+      StatisticsPartial result;
+      result.Counts.resize(countEntries, 0);
+      if (!parallel || bandCount < 2)
+      {
+        for (size_t row = 0; row < rows.RowCount; ++row)
+        {
+          rowFunction(rows.GetRow(row), result);
+        }
+        return result;
+      }
+
+      Concurrency::combinable<StatisticsPartial> partials([countEntries]()
+      {
+        StatisticsPartial partial;
+        partial.Counts.resize(countEntries, 0);
+        return partial;
+      });
+      Concurrency::parallel_for(size_t(0), bandCount, [&](size_t band)
+      {
+        StatisticsPartial& partial = partials.local();
+        const size_t lastRow = (band + 1) * rowsPerBand < rows.RowCount ? (band + 1) * rowsPerBand : rows.RowCount;
+        for (size_t row = band * rowsPerBand; row < lastRow; ++row)
+        {
+          rowFunction(rows.GetRow(row), partial);
+        }
+      });
+      partials.combine_each([&result](const StatisticsPartial& partial)
+      {
+        result.Merge(partial);
+      });
+      return result;
+    }
+
+    //----------------------------------------------------------------------------
+    template<typename ScalarType>
+    StatisticsPartial ComputeMoments(const RegionRows& rows, bool countValues, bool parallel)
+    {
+      const bool useSSE2 = PixelConversion::GetInstructionSetLevel() >= PIXEL_CONVERSION_ISA_SSE2;
+      const ptrdiff_t stride = rows.View->GetStrides()[0] * static_cast<ptrdiff_t>(rows.Step);
+      const size_t countEntries = countValues && std::is_integral<ScalarType>::value ? size_t(1) << (8 * sizeof(ScalarType)) : 0;
+      return ReduceRows(rows, countEntries, parallel, [&](const byte * row, StatisticsPartial & partial)
+      {
+        AccumulateRow<ScalarType>(row, rows.SamplesPerRow, stride, useSSE2, partial);
+      });
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  ImageStatistics::ImageStatistics()
+  {
+  }
+
+  //----------------------------------------------------------------------------
+  uint32 ImageStatistics::NumberOfBins::get()
+  {
+    return m_numberOfBins;
+  }
+
+  //----------------------------------------------------------------------------
+  void ImageStatistics::NumberOfBins::set(uint32 arg)
+  {
+    m_numberOfBins = arg;
+  }
+
+  //----------------------------------------------------------------------------
+  bool ImageStatistics::AutomaticHistogramRange::get()
+  {
+    return m_automaticHistogramRange;
+  }
+
+  //----------------------------------------------------------------------------
+  void ImageStatistics::AutomaticHistogramRange::set(bool arg)
+  {
+    m_automaticHistogramRange = arg;
+  }
+
+  //----------------------------------------------------------------------------
+  double ImageStatistics::HistogramMinimum::get()
+  {
+    return m_histogramMinimum;
+  }
+
+  //----------------------------------------------------------------------------
+  void ImageStatistics::HistogramMinimum::set(double arg)
+  {
+    m_histogramMinimum = arg;
+  }
+
+  //----------------------------------------------------------------------------
+  double ImageStatistics::HistogramMaximum::get()
+  {
+    return m_histogramMaximum;
+  }
+
+  //----------------------------------------------------------------------------
+  void ImageStatistics::HistogramMaximum::set(double arg)
+  {
+    m_histogramMaximum = arg;
+  }
+
+  //----------------------------------------------------------------------------
+  uint16 ImageStatistics::Component::get()
+  {
+    return m_component;
+  }
+
+  //----------------------------------------------------------------------------
+  void ImageStatistics::Component::set(uint16 arg)
+  {
+    m_component = arg;
+  }
+
+  //----------------------------------------------------------------------------
+  bool ImageStatistics::Parallel::get()
+  {
+    return m_parallel;
+  }
+
+  //----------------------------------------------------------------------------
+  void ImageStatistics::Parallel::set(bool arg)
+  {
+    m_parallel = arg;
+  }
+
+  //----------------------------------------------------------------------------
+  uint64 ImageStatistics::PixelCount::get()
+  {
+    return m_pixelCount;
+  }
+
+  //----------------------------------------------------------------------------
+  double ImageStatistics::Minimum::get()
+  {
+    return m_minimum;
+  }
+
+  //----------------------------------------------------------------------------
+  double ImageStatistics::Maximum::get()
+  {
+    return m_maximum;
+  }
+
+  //----------------------------------------------------------------------------
+  double ImageStatistics::Mean::get()
+  {
+    return m_mean;
+  }
+
+  //----------------------------------------------------------------------------
+  double ImageStatistics::Variance::get()
+  {
+    return m_variance;
+  }
+
+  //----------------------------------------------------------------------------
+  double ImageStatistics::StandardDeviation::get()
+  {
+    return std::sqrt(m_variance);
+  }
+
+  //----------------------------------------------------------------------------
+  Platform::Array<uint64>^ ImageStatistics::Histogram::get()
+  {
+    return ref new Platform::Array<uint64>(m_histogram.data(), static_cast<unsigned int>(m_histogram.size()));
+  }
+
+  //----------------------------------------------------------------------------
+  bool ImageStatistics::Compute(Image^ image)
+  {
+    if (image == nullptr)
+    {
+      return false;
+    }
+
+    return Compute(VolumeView(image), 1);
+  }
+
+  //----------------------------------------------------------------------------
+  bool ImageStatistics::ComputeRegion(Image^ image, const FrameSizeABI^ origin, const FrameSizeABI^ size, uint16 step)
+  {
+    if (image == nullptr || origin == nullptr || size == nullptr || origin->Length < 3 || size->Length < 3)
+    {
+      return false;
+    }
+
+    return Compute(VolumeView(image).Crop({ origin[0], origin[1], origin[2] }, { size[0], size[1], size[2] }), step);
+  }
+
+  //----------------------------------------------------------------------------
+  bool ImageStatistics::IsComputationSupported(int scalarType)
+  {
+    switch ((IGTL_SCALAR_TYPE)scalarType)
+    {
+      case IGTL_SCALARTYPE_UINT8:
+      case IGTL_SCALARTYPE_UINT16:
+      case IGTL_SCALARTYPE_INT16:
+      case IGTL_SCALARTYPE_FLOAT32:
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  bool ImageStatistics::Compute(const VolumeView& view, size_t step)
+  {
+    const auto& extent = view.GetExtent();
+    if (!view.IsValid() || step == 0 || extent[0] == 0 || extent[1] == 0 || extent[2] == 0 ||
+        !IsComputationSupported(view.GetScalarType()) || m_component >= view.GetNumberOfScalarComponents())
+    {
+      return false;
+    }
+
+    RegionRows rows;
+    rows.View = &view;
+    rows.Step = step;
+    rows.Offset = m_component * Image::GetNumberOfBytesPerScalar(view.GetScalarType());
+    rows.RowsPerSlice = (extent[1] + step - 1) / step;
+    rows.RowCount = rows.RowsPerSlice * ((extent[2] + step - 1) / step);
+    rows.SamplesPerRow = (extent[0] + step - 1) / step;
+
+    // Integer values are counted per value in the same pass and binned once the range is known, float values need a second pass
+    const bool histogram = m_numberOfBins > 0;
+    StatisticsPartial result;
+    switch (view.GetScalarType())
+    {
+      case IGTL_SCALARTYPE_UINT8:
+        result = ComputeMoments<uint8>(rows, histogram, m_parallel);
+        break;
+      case IGTL_SCALARTYPE_UINT16:
+        result = ComputeMoments<uint16>(rows, histogram, m_parallel);
+        break;
+      case IGTL_SCALARTYPE_INT16:
+        result = ComputeMoments<int16>(rows, histogram, m_parallel);
+        break;
+      default:
+        result = ComputeMoments<float>(rows, false, m_parallel);
+        break;
+    }
+
+    m_pixelCount = result.Count;
+    m_minimum = result.Minimum;
+    m_maximum = result.Maximum;
+    m_mean = result.Mean;
+    m_variance = result.Count > 0 ? result.M2 / result.Count : 0.0;
+    m_histogram.assign(m_numberOfBins, 0);
+    if (!histogram)
+    {
+      return true;
+    }
+
+    const double minimum = m_automaticHistogramRange ? m_minimum : m_histogramMinimum;
+    const double maximum = m_automaticHistogramRange ? m_maximum : m_histogramMaximum;
+    if (m_automaticHistogramRange)
+    {
+      m_histogramMinimum = minimum;
+      m_histogramMaximum = maximum;
+    }
+    if (!(maximum >= minimum))
+    {
+      // Only NaN values, or an empty range
+      return true;
+    }
+
+    const double lastBin = m_numberOfBins - 1.0;
+    if (view.GetScalarType() == IGTL_SCALARTYPE_FLOAT32)
+    {
+      const double scale = maximum > minimum ? m_numberOfBins / (maximum - minimum) : 0.0;
+      const ptrdiff_t stride = view.GetStrides()[0] * static_cast<ptrdiff_t>(step);
+      result = ReduceRows(rows, m_numberOfBins, m_parallel, [&](const byte * row, StatisticsPartial & partial)
+      {
+        BinRow(row, rows.SamplesPerRow, stride, minimum, scale, partial);
+      });
+      m_histogram = result.Counts;
+      return true;
+    }
+
+    // Each integer value falls in a single bin, the range includes maximum
+    const double valueOffset = view.GetScalarType() == IGTL_SCALARTYPE_INT16 ? -32768.0 : 0.0;
+    const double scale = m_numberOfBins / (maximum - minimum + 1.0);
+    for (size_t i = 0; i < result.Counts.size(); ++i)
+    {
+      if (result.Counts[i] == 0)
+      {
+        continue;
+      }
+      const double bin = std::floor((i + valueOffset - minimum) * scale);
+      m_histogram[static_cast<size_t>(bin > 0.0 ? (bin < lastBin ? bin : lastBin) : 0.0)] += result.Counts[i];
+    }
+
+    return true;
+  }
+}
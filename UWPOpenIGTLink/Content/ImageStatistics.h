@@ -0,0 +1,93 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+#pragma once
+
+// Local includes
+#include "IGTCommon.h"
+
+// STL includes
+#include <vector>
+
+namespace UWPOpenIGTLink
+{
+  ref class Image;
+  class VolumeView;
+
+  /*!
+    Minimum, maximum, mean, variance and a fixed bin histogram of one scalar component of uint8, uint16, int16 and float32 images,
+    over the whole image or a region of it sampled every n pixels. Contiguous rows are reduced with SSE2 and bands of rows are
+    reduced concurrently. NaN values are ignored by the minimum, maximum and histogram but propagate to the mean and variance.
+  */
+  public ref class ImageStatistics sealed
+  {
+  public:
+    ImageStatistics();
+
+    /// Number of histogram bins, 0 skips the histogram
+    property uint32 NumberOfBins { uint32 get(); void set(uint32 arg); }
+    /// If true the histogram spans [Minimum, Maximum] of the computed values, otherwise [HistogramMinimum, HistogramMaximum]
+    property bool AutomaticHistogramRange { bool get(); void set(bool arg); }
+    /// Values outside of the histogram range are counted in the first or last bin. Integer ranges are inclusive of HistogramMaximum.
+    property double HistogramMinimum { double get(); void set(double arg); }
+    property double HistogramMaximum { double get(); void set(double arg); }
+    /// The scalar component the statistics are computed for
+    property uint16 Component { uint16 get(); void set(uint16 arg); }
+    /// Reduce bands of rows concurrently
+    property bool Parallel { bool get(); void set(bool arg); }
+
+    /// Results of the last computation
+    property uint64 PixelCount { uint64 get(); }
+    property double Minimum { double get(); }
+    property double Maximum { double get(); }
+    property double Mean { double get(); }
+    /// Population variance
+    property double Variance { double get(); }
+    property double StandardDeviation { double get(); }
+    property Platform::Array<uint64>^ Histogram { Platform::Array<uint64>^ get(); }
+
+    bool Compute(Image^ image);
+    /// Compute the statistics of the size pixels starting at origin, sampling every step pixels along each axis
+    bool ComputeRegion(Image^ image, const FrameSizeABI^ origin, const FrameSizeABI^ size, uint16 step);
+
+    static bool IsComputationSupported(int scalarType);
+
+  internal:
+    bool Compute(const VolumeView& view, size_t step);
+
+  protected private:
+    uint32                        m_numberOfBins = 256;
+    bool                          m_automaticHistogramRange = true;
+    double                        m_histogramMinimum = 0.0;
+    double                        m_histogramMaximum = 255.0;
+    uint16                        m_component = 0;
+    bool                          m_parallel = true;
+
+    uint64                        m_pixelCount = 0;
+    double                        m_minimum = 0.0;
+    double                        m_maximum = 0.0;
+    double                        m_mean = 0.0;
+    double                        m_variance = 0.0;
+    std::vector<uint64>           m_histogram;
+  };
+}
@@ -0,0 +1,219 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+#pragma once
+
+// Local includes
+#include "HalfFloat.h"
+#include "IGTCommon.h"
+#include "Image.h"
+#include "VolumeView.h"
+
+// STL includes
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+
+namespace UWPOpenIGTLink
+{
+  /// The IGTL_SCALAR_TYPE stored as ScalarType, IGTL_SCALARTYPE_UNKNOWN for types that are not pixel scalars
+  template<typename ScalarType> struct ScalarTypeTraits { static const IGTL_SCALAR_TYPE Value = IGTL_SCALARTYPE_UNKNOWN; };
+  template<> struct ScalarTypeTraits<int8> { static const IGTL_SCALAR_TYPE Value = IGTL_SCALARTYPE_INT8; };
+  template<> struct ScalarTypeTraits<uint8> { static const IGTL_SCALAR_TYPE Value = IGTL_SCALARTYPE_UINT8; };
+  template<> struct ScalarTypeTraits<int16> { static const IGTL_SCALAR_TYPE Value = IGTL_SCALARTYPE_INT16; };
+  template<> struct ScalarTypeTraits<uint16> { static const IGTL_SCALAR_TYPE Value = IGTL_SCALARTYPE_UINT16; };
+  template<> struct ScalarTypeTraits<int32> { static const IGTL_SCALAR_TYPE Value = IGTL_SCALARTYPE_INT32; };
+  template<> struct ScalarTypeTraits<uint32> { static const IGTL_SCALAR_TYPE Value = IGTL_SCALARTYPE_UINT32; };
+  template<> struct ScalarTypeTraits<float> { static const IGTL_SCALAR_TYPE Value = IGTL_SCALARTYPE_FLOAT32; };
+  template<> struct ScalarTypeTraits<double> { static const IGTL_SCALAR_TYPE Value = IGTL_SCALARTYPE_FLOAT64; };
+  template<> struct ScalarTypeTraits<Float16> { static const IGTL_SCALAR_TYPE Value = IGTL_SCALARTYPE_FLOAT16; };
+
+  /// A contiguous run of values that it does not own, e.g. a row of an ImageView. Follows the std::span interface so it can be used in range based for loops.
+  template<typename ScalarType>
+  class ImageRow
+  {
+  public:
+    typedef ScalarType  element_type;
+    typedef ScalarType* iterator;
+
+    ImageRow(ScalarType* data, size_t size) : m_data(data), m_size(size) {}
+
+    ScalarType* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    ScalarType* begin() const { return m_data; }
+    ScalarType* end() const { return m_data + m_size; }
+
+    /// Bounds are checked in debug builds
+    ScalarType& operator[](size_t index) const
+    {
+      assert(index < m_size);
+      return m_data[index];
+    }
+
+  protected:
+    ScalarType*   m_data;
+    size_t        m_size;
+  };
+
+  /*!
+    A typed, strided view of the pixels of an image volume, ImageView<const T> for read only access.
+    Unlike VolumeView the view does not own the pixels, the image (or VolumeView) they came from must outlive it.
+    Strides are in values rather than bytes, pixel (x, y, z) starts at GetOrigin() + x * strides[0] + y * strides[1] + z * strides[2].
+  */
+  template<typename ScalarType>
+  class ImageView
+  {
+  public:
+    typedef typename std::remove_const<ScalarType>::type  ValueType;
+    typedef VolumeView::Extent                            Extent;
+    typedef VolumeView::Strides                           Strides;
+
+    /// An invalid view
+    ImageView() {}
+
+    /// A view of extent pixels of numberOfScalarComponents values each
+    ImageView(ScalarType* origin, const Extent& extent, uint16 numberOfScalarComponents, const Strides& strides)
+      : m_origin(origin), m_extent(extent), m_strides(strides), m_numberOfScalarComponents(numberOfScalarComponents) {}
+
+    /// A view of the pixels of volume, invalid if they are not stored as ValueType
+    explicit ImageView(const VolumeView& volume)
+    {
+      if (!volume.IsValid() || volume.GetScalarType() != ScalarTypeTraits<ValueType>::Value)
+      {
+        return;
+      }
+
+      // Pixel strides are multiples of the pixel size, so they divide evenly
+      m_origin = reinterpret_cast<ScalarType*>(volume.GetOrigin());
+      m_extent = volume.GetExtent();
+      for (size_t i = 0; i < 3; ++i)
+      {
+        m_strides[i] = volume.GetStrides()[i] / static_cast<ptrdiff_t>(sizeof(ValueType));
+      }
+      m_numberOfScalarComponents = volume.GetNumberOfScalarComponents();
+    }
+
+    /// A writable view converts to a read only one
+    template<typename OtherType, typename = typename std::enable_if<std::is_same<const OtherType, ScalarType>::value>::type>
+    ImageView(const ImageView<OtherType>& other)
+      : m_origin(other.GetOrigin()), m_extent(other.GetExtent()), m_strides(other.GetStrides()), m_numberOfScalarComponents(other.GetNumberOfScalarComponents()) {}
+
+    bool IsValid() const { return m_origin != nullptr; }
+    ScalarType* GetOrigin() const { return m_origin; }
+    const Extent& GetExtent() const { return m_extent; }
+    const Strides& GetStrides() const { return m_strides; }
+    uint16 GetNumberOfScalarComponents() const { return m_numberOfScalarComponents; }
+
+    /// Component of pixel (x, y, z), bounds are checked in debug builds
+    ScalarType& operator()(size_t x, size_t y, size_t z = 0, uint16 component = 0) const
+    {
+      assert(x < m_extent[0] && y < m_extent[1] && z < m_extent[2] && component < m_numberOfScalarComponents);
+      return m_origin[static_cast<ptrdiff_t>(x) * m_strides[0] + static_cast<ptrdiff_t>(y) * m_strides[1] + static_cast<ptrdiff_t>(z) * m_strides[2] + component];
+    }
+
+    /// True if the values of a row are adjacent, which GetRow requires. False for views of a slice along x.
+    bool HasContiguousRows() const
+    {
+      return m_extent[0] <= 1 || m_strides[0] == m_numberOfScalarComponents;
+    }
+
+    /// The width * components values of row (y, z), bounds are checked in debug builds
+    ImageRow<ScalarType> GetRow(size_t y, size_t z = 0) const
+    {
+      assert(HasContiguousRows() && y < m_extent[1] && z < m_extent[2]);
+      return ImageRow<ScalarType>(m_origin + static_cast<ptrdiff_t>(y) * m_strides[1] + static_cast<ptrdiff_t>(z) * m_strides[2], m_extent[0] * m_numberOfScalarComponents);
+    }
+
+  protected:
+    ScalarType*   m_origin = nullptr;
+    Extent        m_extent = { 0, 0, 0 };
+    Strides       m_strides = { 0, 0, 0 };
+    uint16        m_numberOfScalarComponents = 0;
+  };
+
+  /// A read only view of the pixels of image, invalid if they are not stored as ScalarType
+  template<typename ScalarType>
+  ImageView<const ScalarType> GetImageView(Image^ image)
+  {
+    return image == nullptr ? ImageView<const ScalarType>() : ImageView<const ScalarType>(VolumeView(image));
+  }
+
+  /// A writable view of the pixels of image, invalid if they are not stored as ScalarType. Shared pixels are copied first (see Image::DeepCopy).
+  /// The view does not hold a reference: copies of the image made while it is in use see its writes, a later mutable access to the image may leave it writing to the old pixels.
+  template<typename ScalarType>
+  ImageView<ScalarType> GetMutableImageView(Image^ image)
+  {
+    if (image == nullptr || image->GetMutableImageDataInternal() == nullptr)
+    {
+      return ImageView<ScalarType>();
+    }
+    return ImageView<ScalarType>(VolumeView(image));
+  }
+
+  /// Call visitor with an ImageView of volume typed by its scalar type, Writable selects ImageView<T> over ImageView<const T>
+  /// Returns false without calling visitor if the view is invalid or its scalar type has no C++ type (IGTL_SCALARTYPE_COMPLEX)
+  template<bool Writable, typename Visitor>
+  bool VisitImageView(const VolumeView& volume, Visitor&& visitor)
+  {
+    if (!volume.IsValid())
+    {
+      return false;
+    }
+
+    switch (volume.GetScalarType())
+    {
+#define VISIT_SCALAR_TYPE(scalarType, valueType) case scalarType: visitor(ImageView<typename std::conditional<Writable, valueType, const valueType>::type>(volume)); return true
+      VISIT_SCALAR_TYPE(IGTL_SCALARTYPE_INT8, int8);
+      VISIT_SCALAR_TYPE(IGTL_SCALARTYPE_UINT8, uint8);
+      VISIT_SCALAR_TYPE(IGTL_SCALARTYPE_INT16, int16);
+      VISIT_SCALAR_TYPE(IGTL_SCALARTYPE_UINT16, uint16);
+      VISIT_SCALAR_TYPE(IGTL_SCALARTYPE_INT32, int32);
+      VISIT_SCALAR_TYPE(IGTL_SCALARTYPE_UINT32, uint32);
+      VISIT_SCALAR_TYPE(IGTL_SCALARTYPE_FLOAT32, float);
+      VISIT_SCALAR_TYPE(IGTL_SCALARTYPE_FLOAT64, double);
+      VISIT_SCALAR_TYPE(IGTL_SCALARTYPE_FLOAT16, Float16);
+#undef VISIT_SCALAR_TYPE
+      default:
+        return false;
+    }
+  }
+
+  /*!
+    Call visitor, typically a generic lambda, with an ImageView<const T> of the pixels of image typed by its scalar type, e.g.
+      VisitImageView(image, [&](auto view) { for (auto value : view.GetRow(0)) { sum += value; } });
+    Returns false without calling visitor if image has no pixels or its scalar type has no C++ type.
+  */
+  template<typename Visitor>
+  bool VisitImageView(Image^ image, Visitor&& visitor)
+  {
+    return image != nullptr && VisitImageView<false>(VolumeView(image), visitor);
+  }
+
+  /// As VisitImageView, with a writable ImageView<T>. Shared pixels are copied first.
+  template<typename Visitor>
+  bool VisitMutableImageView(Image^ image, Visitor&& visitor)
+  {
+    return image != nullptr && image->GetMutableImageDataInternal() != nullptr && VisitImageView<true>(VolumeView(image), visitor);
+  }
+}
@@ -0,0 +1,103 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+// Local includes
+#include "pch.h"
+#include "NativeBuffer.h"
+
+using namespace Microsoft::WRL;
+
+namespace UWPOpenIGTLink
+{
+  //----------------------------------------------------------------------------
+  HRESULT NativeBuffer::RuntimeClassInitialize(std::shared_ptr<byte> data, uint32 length)
+  {
+    if (data == nullptr && length > 0)
+    {
+      return E_INVALIDARG;
+    }
+
+    m_data = data;
+    m_capacity = length;
+    m_length = length;
+    return S_OK;
+  }
+
+  //----------------------------------------------------------------------------
+  STDMETHODIMP NativeBuffer::get_Capacity(UINT32* value)
+  {
+    if (value == nullptr)
+    {
+      return E_POINTER;
+    }
+    *value = m_capacity;
+    return S_OK;
+  }
+
+  //----------------------------------------------------------------------------
+  STDMETHODIMP NativeBuffer::get_Length(UINT32* value)
+  {
+    if (value == nullptr)
+    {
+      return E_POINTER;
+    }
+    *value = m_length;
+    return S_OK;
+  }
+
+  //----------------------------------------------------------------------------
+  STDMETHODIMP NativeBuffer::put_Length(UINT32 value)
+  {
+    if (value > m_capacity)
+    {
+      return E_INVALIDARG;
+    }
+    m_length = value;
+    return S_OK;
+  }
+
+  //----------------------------------------------------------------------------
+  STDMETHODIMP NativeBuffer::Buffer(byte** value)
+  {
+    if (value == nullptr)
+    {
+      return E_POINTER;
+    }
+    *value = m_data.get();
+    return S_OK;
+  }
+
+  //----------------------------------------------------------------------------
+  Windows::Storage::Streams::IBuffer^ CreateNativeBuffer(std::shared_ptr<byte> data, uint32 length)
+  {
+    ComPtr<NativeBuffer> nativeBuffer;
+    if (FAILED(MakeAndInitialize<NativeBuffer>(&nativeBuffer, data, length)))
+    {
+      return nullptr;
+    }
+
+    ComPtr<ABI::Windows::Storage::Streams::IBuffer> buffer;
+    nativeBuffer.As(&buffer);
+    return reinterpret_cast<Windows::Storage::Streams::IBuffer^>(buffer.Get());
+  }
+}
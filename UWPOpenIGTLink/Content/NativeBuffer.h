@@ -0,0 +1,64 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+#pragma once
+
+// Local includes
+#include "IGTCommon.h"
+
+// WinRT includes
+#include <robuffer.h>
+#include <windows.storage.streams.h>
+#include <wrl\implements.h>
+
+namespace UWPOpenIGTLink
+{
+  /// An IBuffer that references existing reference counted memory instead of copying it
+  /// The memory is kept alive for as long as the buffer (or any IBufferByteAccess obtained from it) is referenced
+  class NativeBuffer : public Microsoft::WRL::RuntimeClass <
+    Microsoft::WRL::RuntimeClassFlags<Microsoft::WRL::RuntimeClassType::WinRtClassicComMix>,
+    ABI::Windows::Storage::Streams::IBuffer,
+    Windows::Storage::Streams::IBufferByteAccess >
+  {
+    InspectableClass(L"UWPOpenIGTLink.NativeBuffer", BaseTrust)
+
+  public:
+    HRESULT RuntimeClassInitialize(std::shared_ptr<byte> data, uint32 length);
+
+    // IBuffer
+    STDMETHODIMP get_Capacity(UINT32* value);
+    STDMETHODIMP get_Length(UINT32* value);
+    STDMETHODIMP put_Length(UINT32 value);
+
+    // IBufferByteAccess
+    STDMETHODIMP Buffer(byte** value);
+
+  protected:
+    std::shared_ptr<byte>   m_data = nullptr;
+    uint32                  m_capacity = 0;
+    uint32                  m_length = 0;
+  };
+
+  /// Wrap length bytes of data in an IBuffer without copying
+  Windows::Storage::Streams::IBuffer^ CreateNativeBuffer(std::shared_ptr<byte> data, uint32 length);
+}
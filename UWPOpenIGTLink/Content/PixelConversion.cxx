@@ -0,0 +1,533 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+// Local includes
+#include "pch.h"
+#include "HalfFloat.h"
+#include "Image.h"
+#include "PixelConversion.h"
+
+// STL includes
+#include <atomic>
+#include <cmath>
+
+#if defined(_M_IX86) || defined(_M_X64)
+  #define PIXEL_CONVERSION_X86
+  #include <intrin.h>
+  #include <immintrin.h>
+#endif
+
+namespace UWPOpenIGTLink
+{
+  namespace
+  {
+    //----------------------------------------------------------------------------
+    PIXEL_CONVERSION_ISA DetectInstructionSet()
+    {
+#if defined(PIXEL_CONVERSION_X86)
+      int info[4] = { 0 };
+      __cpuid(info, 0);
+      const int maxLeaf = info[0];
+
+      __cpuid(info, 1);
+      const bool sse2 = (info[3] & (1 << 26)) != 0;
+      const bool ssse3 = (info[2] & (1 << 9)) != 0;
+      const bool osxsave = (info[2] & (1 << 27)) != 0;
+      const bool avx = (info[2] & (1 << 28)) != 0;
+
+      bool avx2(false);
+      if (maxLeaf >= 7 && osxsave && avx)
+      {
+        __cpuidex(info, 7, 0);
+        // The OS must also save the ymm registers
+        avx2 = (info[1] & (1 << 5)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+      }
+
+      if (avx2 && ssse3)
+      {
+        return PIXEL_CONVERSION_ISA_AVX2;
+      }
+      if (ssse3)
+      {
+        return PIXEL_CONVERSION_ISA_SSSE3;
+      }
+      if (sse2)
+      {
+        return PIXEL_CONVERSION_ISA_SSE2;
+      }
+#endif
+      return PIXEL_CONVERSION_ISA_SCALAR;
+    }
+
+    //----------------------------------------------------------------------------
+    PIXEL_CONVERSION_ISA GetSupportedInstructionSet()
+    {
+      static const PIXEL_CONVERSION_ISA supported = DetectInstructionSet();
+      return supported;
+    }
+
+    std::atomic<int> g_instructionSet(-1);
+
+    //----------------------------------------------------------------------------
+    PIXEL_CONVERSION_ISA GetActiveInstructionSet()
+    {
+      int isa = g_instructionSet;
+      return isa < 0 ? GetSupportedInstructionSet() : static_cast<PIXEL_CONVERSION_ISA>(isa);
+    }
+
+    // Scalar kernels, these also convert the pixels left over by the vector kernels
+    //----------------------------------------------------------------------------
+    inline void StoreGrey(byte* destination, byte grey)
+    {
+      destination[0] = grey;
+      destination[1] = grey;
+      destination[2] = grey;
+      destination[3] = 255U;
+    }
+
+    //----------------------------------------------------------------------------
+    void GreyU8Scalar(const byte* source, byte* destination, size_t pixelCount)
+    {
+      for (size_t i = 0; i < pixelCount; ++i, destination += 4)
+      {
+        StoreGrey(destination, source[i]);
+      }
+    }
+
+    //----------------------------------------------------------------------------
+    void GreyU16Scalar(const byte* source, byte* destination, size_t pixelCount, bool isSigned)
+    {
+      // Signed values are offset by 2^15 so the full range maps to [0, 255]
+      const uint16 offset = isSigned ? 0x8000 : 0;
+      for (size_t i = 0; i < pixelCount; ++i, destination += 4)
+      {
+        uint16 value;
+        memcpy(&value, source + i * sizeof(uint16), sizeof(uint16));
+        StoreGrey(destination, static_cast<byte>((value ^ offset) >> 8));
+      }
+    }
+
+    //----------------------------------------------------------------------------
+    void GreyF32Scalar(const byte* source, byte* destination, size_t pixelCount)
+    {
+      for (size_t i = 0; i < pixelCount; ++i, destination += 4)
+      {
+        float value;
+        memcpy(&value, source + i * sizeof(float), sizeof(float));
+        value *= 255.f;
+        // Written so NaN maps to 0, same as the vector kernels
+        value = value > 0.f ? (value < 255.f ? value : 255.f) : 0.f;
+        StoreGrey(destination, static_cast<byte>(std::lrint(value)));
+      }
+    }
+
+    //----------------------------------------------------------------------------
+    void RGB24Scalar(const byte* source, byte* destination, size_t pixelCount, bool bgra)
+    {
+      const int red = bgra ? 2 : 0;
+      const int blue = bgra ? 0 : 2;
+      for (size_t i = 0; i < pixelCount; ++i, source += 3, destination += 4)
+      {
+        destination[red] = source[0];
+        destination[1] = source[1];
+        destination[blue] = source[2];
+        destination[3] = 255U;
+      }
+    }
+
+    //----------------------------------------------------------------------------
+    void RGBA32Scalar(const byte* source, byte* destination, size_t pixelCount, bool bgra)
+    {
+      if (!bgra)
+      {
+        memcpy(destination, source, pixelCount * 4);
+        return;
+      }
+      for (size_t i = 0; i < pixelCount; ++i, source += 4, destination += 4)
+      {
+        destination[0] = source[2];
+        destination[1] = source[1];
+        destination[2] = source[0];
+        destination[3] = source[3];
+      }
+    }
+
+#if defined(PIXEL_CONVERSION_X86)
+    // SSE2 kernels
+    //----------------------------------------------------------------------------
+    inline void StoreGrey16SSE2(__m128i grey, byte* destination)
+    {
+      const __m128i alpha = _mm_set1_epi8(static_cast<char>(0xFF));
+      const __m128i greyGreyLow = _mm_unpacklo_epi8(grey, grey);
+      const __m128i greyGreyHigh = _mm_unpackhi_epi8(grey, grey);
+      const __m128i greyAlphaLow = _mm_unpacklo_epi8(grey, alpha);
+      const __m128i greyAlphaHigh = _mm_unpackhi_epi8(grey, alpha);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(destination), _mm_unpacklo_epi16(greyGreyLow, greyAlphaLow));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + 16), _mm_unpackhi_epi16(greyGreyLow, greyAlphaLow));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + 32), _mm_unpacklo_epi16(greyGreyHigh, greyAlphaHigh));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + 48), _mm_unpackhi_epi16(greyGreyHigh, greyAlphaHigh));
+    }
+
+    //----------------------------------------------------------------------------
+    void GreyU8SSE2(const byte* source, byte* destination, size_t pixelCount)
+    {
+      size_t i = 0;
+      for (; i + 16 <= pixelCount; i += 16)
+      {
+        StoreGrey16SSE2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i)), destination + i * 4);
+      }
+      GreyU8Scalar(source + i, destination + i * 4, pixelCount - i);
+    }
+
+    //----------------------------------------------------------------------------
+    void GreyU16SSE2(const byte* source, byte* destination, size_t pixelCount, bool isSigned)
+    {
+      const __m128i offset = _mm_set1_epi16(isSigned ? static_cast<short>(0x8000) : 0);
+      size_t i = 0;
+      for (; i + 16 <= pixelCount; i += 16)
+      {
+        __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2));
+        __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2 + 16));
+        low = _mm_srli_epi16(_mm_xor_si128(low, offset), 8);
+        high = _mm_srli_epi16(_mm_xor_si128(high, offset), 8);
+        StoreGrey16SSE2(_mm_packus_epi16(low, high), destination + i * 4);
+      }
+      GreyU16Scalar(source + i * 2, destination + i * 4, pixelCount - i, isSigned);
+    }
+
+    //----------------------------------------------------------------------------
+    void GreyF32SSE2(const byte* source, byte* destination, size_t pixelCount)
+    {
+      const __m128 scale = _mm_set1_ps(255.f);
+      const __m128 zero = _mm_setzero_ps();
+      size_t i = 0;
+      for (; i + 16 <= pixelCount; i += 16)
+      {
+        __m128i values[4];
+        for (int j = 0; j < 4; ++j)
+        {
+          __m128 value = _mm_mul_ps(_mm_loadu_ps(reinterpret_cast<const float*>(source) + i + j * 4), scale);
+          // max returns its second operand for NaN
+          value = _mm_min_ps(_mm_max_ps(value, zero), scale);
+          values[j] = _mm_cvtps_epi32(value);
+        }
+        StoreGrey16SSE2(_mm_packus_epi16(_mm_packs_epi32(values[0], values[1]), _mm_packs_epi32(values[2], values[3])), destination + i * 4);
+      }
+      GreyF32Scalar(source + i * 4, destination + i * 4, pixelCount - i);
+    }
+
+    //----------------------------------------------------------------------------
+    void RGBA32SSE2(const byte* source, byte* destination, size_t pixelCount, bool bgra)
+    {
+      if (!bgra)
+      {
+        RGBA32Scalar(source, destination, pixelCount, bgra);
+        return;
+      }
+
+      // Swap the red and blue bytes of each 32 bit pixel
+      const __m128i greenAlpha = _mm_set1_epi32(static_cast<int>(0xFF00FF00));
+      const __m128i redBlue = _mm_set1_epi32(0x00FF00FF);
+      size_t i = 0;
+      for (; i + 4 <= pixelCount; i += 4)
+      {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 4));
+        const __m128i rb = _mm_and_si128(pixels, redBlue);
+        const __m128i swapped = _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i * 4), _mm_or_si128(_mm_and_si128(pixels, greenAlpha), swapped));
+      }
+      RGBA32Scalar(source + i * 4, destination + i * 4, pixelCount - i, bgra);
+    }
+
+    // SSSE3 kernels
+    //----------------------------------------------------------------------------
+    void RGB24SSSE3(const byte* source, byte* destination, size_t pixelCount, bool bgra)
+    {
+      // Spread 4 packed pixels to 4 byte lanes, the 0x80 entries zero the alpha bytes which are then set
+      const __m128i shuffle = bgra ?
+                              _mm_setr_epi8(2, 1, 0, -128, 5, 4, 3, -128, 8, 7, 6, -128, 11, 10, 9, -128) :
+                              _mm_setr_epi8(0, 1, 2, -128, 3, 4, 5, -128, 6, 7, 8, -128, 9, 10, 11, -128);
+      const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000));
+      size_t i = 0;
+      // Each load reads 16 bytes of which 12 are used, stop while a full load is still inside the source
+      for (; i + 6 <= pixelCount; i += 4)
+      {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 3));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i * 4), _mm_or_si128(_mm_shuffle_epi8(pixels, shuffle), alpha));
+      }
+      RGB24Scalar(source + i * 3, destination + i * 4, pixelCount - i, bgra);
+    }
+
+    // AVX2 kernels
+    //----------------------------------------------------------------------------
+    inline void StoreGrey8AVX2(__m256i grey, byte* destination)
+    {
+      // grey holds one 8 bit value per 32 bit lane
+      const __m256i alpha = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+      const __m256i pixels = _mm256_or_si256(_mm256_or_si256(grey, _mm256_slli_epi32(grey, 8)), _mm256_or_si256(_mm256_slli_epi32(grey, 16), alpha));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination), pixels);
+    }
+
+    //----------------------------------------------------------------------------
+    void GreyU8AVX2(const byte* source, byte* destination, size_t pixelCount)
+    {
+      size_t i = 0;
+      for (; i + 8 <= pixelCount; i += 8)
+      {
+        StoreGrey8AVX2(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(source + i))), destination + i * 4);
+      }
+      GreyU8Scalar(source + i, destination + i * 4, pixelCount - i);
+    }
+
+    //----------------------------------------------------------------------------
+    void GreyU16AVX2(const byte* source, byte* destination, size_t pixelCount, bool isSigned)
+    {
+      const __m256i offset = _mm256_set1_epi32(isSigned ? 0x8000 : 0);
+      size_t i = 0;
+      for (; i + 8 <= pixelCount; i += 8)
+      {
+        __m256i values = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2)));
+        StoreGrey8AVX2(_mm256_srli_epi32(_mm256_xor_si256(values, offset), 8), destination + i * 4);
+      }
+      GreyU16Scalar(source + i * 2, destination + i * 4, pixelCount - i, isSigned);
+    }
+
+    //----------------------------------------------------------------------------
+    void RGBA32AVX2(const byte* source, byte* destination, size_t pixelCount, bool bgra)
+    {
+      if (!bgra)
+      {
+        RGBA32Scalar(source, destination, pixelCount, bgra);
+        return;
+      }
+
+      const __m256i greenAlpha = _mm256_set1_epi32(static_cast<int>(0xFF00FF00));
+      const __m256i redBlue = _mm256_set1_epi32(0x00FF00FF);
+      size_t i = 0;
+      for (; i + 8 <= pixelCount; i += 8)
+      {
+        const __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i * 4));
+        const __m256i rb = _mm256_and_si256(pixels, redBlue);
+        const __m256i swapped = _mm256_or_si256(_mm256_slli_epi32(rb, 16), _mm256_srli_epi32(rb, 16));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i * 4), _mm256_or_si256(_mm256_and_si256(pixels, greenAlpha), swapped));
+      }
+      RGBA32Scalar(source + i * 4, destination + i * 4, pixelCount - i, bgra);
+    }
+#endif
+
+    //----------------------------------------------------------------------------
+    // Half values are widened to float32 a block at a time, small enough to stay in L1, and mapped by the float32 kernels
+    void GreyF16(const byte* source, byte* destination, size_t pixelCount, PIXEL_CONVERSION_ISA isa)
+    {
+      static const size_t BLOCK_SIZE = 1024;
+      alignas(16) float block[BLOCK_SIZE];
+      for (size_t i = 0; i < pixelCount; i += BLOCK_SIZE)
+      {
+        const size_t count = pixelCount - i < BLOCK_SIZE ? pixelCount - i : BLOCK_SIZE;
+        ConvertFloat16ToFloat32(reinterpret_cast<const uint16*>(source) + i, block, count);
+#if defined(PIXEL_CONVERSION_X86)
+        if (isa >= PIXEL_CONVERSION_ISA_SSE2)
+        {
+          GreyF32SSE2(reinterpret_cast<const byte*>(block), destination + i * 4, count);
+          continue;
+        }
+#endif
+        GreyF32Scalar(reinterpret_cast<const byte*>(block), destination + i * 4, count);
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  bool PixelConversion::ConvertToDisplay(Windows::Storage::Streams::IBuffer^ source, Windows::Storage::Streams::IBuffer^ destination, uint32 pixelCount, uint16 numberOfScalarComponents, int scalarType, bool outputBGRA)
+  {
+    if (source == nullptr || destination == nullptr || !IsConversionSupported(numberOfScalarComponents, scalarType))
+    {
+      return false;
+    }
+
+    const size_t sourceSize = static_cast<size_t>(pixelCount) * numberOfScalarComponents * Image::GetNumberOfBytesPerScalar(scalarType);
+    if (source->Length < sourceSize || destination->Length < static_cast<size_t>(pixelCount) * 4)
+    {
+      return false;
+    }
+
+    return Convert(GetDataFromIBuffer<byte>(source), GetDataFromIBuffer<byte>(destination), pixelCount, numberOfScalarComponents,
+                   static_cast<IGTL_SCALAR_TYPE>(scalarType), outputBGRA ? DISPLAY_PIXEL_FORMAT_BGRA8 : DISPLAY_PIXEL_FORMAT_RGBA8);
+  }
+
+  //----------------------------------------------------------------------------
+  bool PixelConversion::ConvertImageToDisplay(Image^ image, Windows::Storage::Streams::IBuffer^ destination, bool outputBGRA)
+  {
+    if (image == nullptr || destination == nullptr || image->GetImageDataInternal() == nullptr)
+    {
+      return false;
+    }
+
+    auto frameSize = image->GetFrameSize();
+    const size_t pixelCount = static_cast<size_t>(frameSize[0]) * frameSize[1] * frameSize[2];
+    if (destination->Length < pixelCount * 4 || !IsConversionSupported(image->NumberOfScalarComponents, image->ScalarType))
+    {
+      return false;
+    }
+
+    return Convert(image->GetImageDataInternal().get(), GetDataFromIBuffer<byte>(destination), pixelCount, image->NumberOfScalarComponents,
+                   static_cast<IGTL_SCALAR_TYPE>(image->ScalarType), outputBGRA ? DISPLAY_PIXEL_FORMAT_BGRA8 : DISPLAY_PIXEL_FORMAT_RGBA8);
+  }
+
+  //----------------------------------------------------------------------------
+  bool PixelConversion::IsConversionSupported(uint16 numberOfScalarComponents, int scalarType)
+  {
+    switch (numberOfScalarComponents)
+    {
+      case 1:
+        return scalarType == IGTL_SCALARTYPE_UINT8 || scalarType == IGTL_SCALARTYPE_UINT16 || scalarType == IGTL_SCALARTYPE_INT16 ||
+               scalarType == IGTL_SCALARTYPE_FLOAT32 || scalarType == IGTL_SCALARTYPE_FLOAT16;
+      case 3:
+      case 4:
+        return scalarType == IGTL_SCALARTYPE_UINT8;
+      default:
+        return false;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  Platform::String^ PixelConversion::InstructionSet::get()
+  {
+    switch (GetActiveInstructionSet())
+    {
+      case PIXEL_CONVERSION_ISA_AVX2:
+        return L"AVX2";
+      case PIXEL_CONVERSION_ISA_SSSE3:
+        return L"SSSE3";
+      case PIXEL_CONVERSION_ISA_SSE2:
+        return L"SSE2";
+      default:
+        return L"Scalar";
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  PIXEL_CONVERSION_ISA PixelConversion::GetInstructionSetLevel()
+  {
+    return GetActiveInstructionSet();
+  }
+
+  //----------------------------------------------------------------------------
+  void PixelConversion::SetInstructionSetLevel(PIXEL_CONVERSION_ISA isa)
+  {
+    g_instructionSet = isa < GetSupportedInstructionSet() ? isa : GetSupportedInstructionSet();
+  }
+
+  //----------------------------------------------------------------------------
+  bool PixelConversion::Convert(const byte* source, byte* destination, size_t pixelCount, uint16 numberOfScalarComponents, IGTL_SCALAR_TYPE scalarType, DISPLAY_PIXEL_FORMAT format)
+  {
+    if (source == nullptr || destination == nullptr || !IsConversionSupported(numberOfScalarComponents, scalarType))
+    {
+      return false;
+    }
+
+    const bool bgra = format == DISPLAY_PIXEL_FORMAT_BGRA8;
+    const PIXEL_CONVERSION_ISA isa = GetActiveInstructionSet();
+
+    if (numberOfScalarComponents == 1)
+    {
+      switch (scalarType)
+      {
+        case IGTL_SCALARTYPE_UINT8:
+#if defined(PIXEL_CONVERSION_X86)
+          if (isa >= PIXEL_CONVERSION_ISA_AVX2)
+          {
+            GreyU8AVX2(source, destination, pixelCount);
+            return true;
+          }
+          if (isa >= PIXEL_CONVERSION_ISA_SSE2)
+          {
+            GreyU8SSE2(source, destination, pixelCount);
+            return true;
+          }
+#endif
+          GreyU8Scalar(source, destination, pixelCount);
+          return true;
+        case IGTL_SCALARTYPE_UINT16:
+        case IGTL_SCALARTYPE_INT16:
+#if defined(PIXEL_CONVERSION_X86)
+          if (isa >= PIXEL_CONVERSION_ISA_AVX2)
+          {
+            GreyU16AVX2(source, destination, pixelCount, scalarType == IGTL_SCALARTYPE_INT16);
+            return true;
+          }
+          if (isa >= PIXEL_CONVERSION_ISA_SSE2)
+          {
+            GreyU16SSE2(source, destination, pixelCount, scalarType == IGTL_SCALARTYPE_INT16);
+            return true;
+          }
+#endif
+          GreyU16Scalar(source, destination, pixelCount, scalarType == IGTL_SCALARTYPE_INT16);
+          return true;
+        case IGTL_SCALARTYPE_FLOAT32:
+#if defined(PIXEL_CONVERSION_X86)
+          if (isa >= PIXEL_CONVERSION_ISA_SSE2)
+          {
+            GreyF32SSE2(source, destination, pixelCount);
+            return true;
+          }
+#endif
+          GreyF32Scalar(source, destination, pixelCount);
+          return true;
+        case IGTL_SCALARTYPE_FLOAT16:
+          GreyF16(source, destination, pixelCount, isa);
+          return true;
+        default:
+          return false;
+      }
+    }
+
+    if (numberOfScalarComponents == 3)
+    {
+#if defined(PIXEL_CONVERSION_X86)
+      if (isa >= PIXEL_CONVERSION_ISA_SSSE3)
+      {
+        RGB24SSSE3(source, destination, pixelCount, bgra);
+        return true;
+      }
+#endif
+      RGB24Scalar(source, destination, pixelCount, bgra);
+      return true;
+    }
+
+#if defined(PIXEL_CONVERSION_X86)
+    if (isa >= PIXEL_CONVERSION_ISA_AVX2)
+    {
+      RGBA32AVX2(source, destination, pixelCount, bgra);
+      return true;
+    }
+    if (isa >= PIXEL_CONVERSION_ISA_SSE2)
+    {
+      RGBA32SSE2(source, destination, pixelCount, bgra);
+      return true;
+    }
+#endif
+    RGBA32Scalar(source, destination, pixelCount, bgra);
+    return true;
+  }
+}
@@ -0,0 +1,73 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+#pragma once
+
+// Local includes
+#include "IGTCommon.h"
+
+namespace UWPOpenIGTLink
+{
+  ref class Image;
+
+  /// DISPLAY_PIXEL_FORMAT - Defines the 8 bit, 4 channel layouts images can be converted to for display
+  enum DISPLAY_PIXEL_FORMAT
+  {
+    DISPLAY_PIXEL_FORMAT_BGRA8, /*!< blue, green, red, alpha - WriteableBitmap, DXGI_FORMAT_B8G8R8A8_UNORM */
+    DISPLAY_PIXEL_FORMAT_RGBA8  /*!< red, green, blue, alpha - DXGI_FORMAT_R8G8B8A8_UNORM */
+  };
+
+  /// PIXEL_CONVERSION_ISA - Defines the instruction sets the conversion kernels are implemented for, in increasing order
+  enum PIXEL_CONVERSION_ISA
+  {
+    PIXEL_CONVERSION_ISA_SCALAR,
+    PIXEL_CONVERSION_ISA_SSE2,
+    PIXEL_CONVERSION_ISA_SSSE3,
+    PIXEL_CONVERSION_ISA_AVX2
+  };
+
+  /*!
+    Converts image pixels to an 8 bit, 4 channel display format.
+    Supported inputs are 1 component uint8, uint16, int16, float32 and float16 (grey) images and 3 (RGB24) or 4 (RGBA) component uint8 images.
+    Grey values are mapped to 8 bits by their full range, [0, 1] for float32 and float16. The best instruction set of the CPU is selected at runtime.
+  */
+  public ref class PixelConversion sealed
+  {
+  public:
+    /// Convert pixelCount pixels from source to destination (pixelCount * 4 bytes), BGRA8 if outputBGRA is true (WriteableBitmap), RGBA8 otherwise
+    static bool ConvertToDisplay(Windows::Storage::Streams::IBuffer^ source, Windows::Storage::Streams::IBuffer^ destination, uint32 pixelCount, uint16 numberOfScalarComponents, int scalarType, bool outputBGRA);
+    /// Convert every pixel of image to destination (width * height * depth * 4 bytes), BGRA8 if outputBGRA is true, RGBA8 otherwise
+    static bool ConvertImageToDisplay(Image^ image, Windows::Storage::Streams::IBuffer^ destination, bool outputBGRA);
+    static bool IsConversionSupported(uint16 numberOfScalarComponents, int scalarType);
+
+    /// Name of the instruction set the kernels run on: "AVX2", "SSSE3", "SSE2" or "Scalar"
+    static property Platform::String^ InstructionSet { Platform::String^ get(); }
+
+  internal:
+    static bool Convert(const byte* source, byte* destination, size_t pixelCount, uint16 numberOfScalarComponents, IGTL_SCALAR_TYPE scalarType, DISPLAY_PIXEL_FORMAT format);
+
+    /// The instruction set in use. Lower it to compare kernels, requests above what the CPU supports are ignored.
+    static PIXEL_CONVERSION_ISA GetInstructionSetLevel();
+    static void SetInstructionSetLevel(PIXEL_CONVERSION_ISA isa);
+  };
+}
@@ -0,0 +1,345 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+// Local includes
+#include "pch.h"
+#include "ImageBufferPool.h"
+#include "Reorientation.h"
+
+// STL includes
+#include <algorithm>
+#include <vector>
+
+using namespace Windows::Foundation::Numerics;
+
+namespace UWPOpenIGTLink
+{
+  namespace
+  {
+    // Transposes work on square blocks of this many pixels a side, so the rows read and written stay in cache
+    static const size_t TRANSPOSE_BLOCK_SIZE = 32;
+
+    /// Direction of an image axis relative to the transducer, lateral (marked side positive), axial (far positive) or elevational (ascending positive)
+    struct ImageAxis
+    {
+      int  Axis;
+      bool Positive;
+    };
+
+    struct OrientationAxes
+    {
+      ImageAxis X;
+      ImageAxis Y;
+      bool      ZPositive;
+    };
+
+    enum TRANSDUCER_AXIS
+    {
+      TRANSDUCER_AXIS_LATERAL,
+      TRANSDUCER_AXIS_AXIAL
+    };
+
+    //----------------------------------------------------------------------------
+    bool GetOrientationAxes(US_IMAGE_ORIENTATION orientation, OrientationAxes& outAxes)
+    {
+      // MFA is the reference orientation, the 2D names alias the 3D name whose z axis keeps the axes right handed
+      bool transposed(false), marked(false), farPositive(false), ascending(false);
+      switch (orientation)
+      {
+        case US_IMG_ORIENT_UF:
+          farPositive = true;
+          break;
+        case US_IMG_ORIENT_UFA:
+          farPositive = ascending = true;
+          break;
+        case US_IMG_ORIENT_UN:
+          ascending = true;
+          break;
+        case US_IMG_ORIENT_UND:
+          break;
+        case US_IMG_ORIENT_MF:
+          marked = farPositive = ascending = true;
+          break;
+        case US_IMG_ORIENT_MFD:
+          marked = farPositive = true;
+          break;
+        case US_IMG_ORIENT_MN:
+          marked = true;
+          break;
+        case US_IMG_ORIENT_MNA:
+          marked = ascending = true;
+          break;
+        case US_IMG_ORIENT_FU:
+          transposed = farPositive = ascending = true;
+          break;
+        case US_IMG_ORIENT_NU:
+          transposed = true;
+          break;
+        case US_IMG_ORIENT_FM:
+          transposed = farPositive = marked = true;
+          break;
+        case US_IMG_ORIENT_NM:
+          transposed = marked = ascending = true;
+          break;
+        default:
+          return false;
+      }
+
+      const ImageAxis lateral = { TRANSDUCER_AXIS_LATERAL, marked };
+      const ImageAxis axial = { TRANSDUCER_AXIS_AXIAL, farPositive };
+      outAxes.X = transposed ? axial : lateral;
+      outAxes.Y = transposed ? lateral : axial;
+      outAxes.ZPositive = ascending;
+      return true;
+    }
+
+    template<size_t Size> struct Pixel
+    {
+      byte Bytes[Size];
+    };
+
+    //----------------------------------------------------------------------------
+    template<typename PixelType>
+    void CopyRow(const PixelType* source, PixelType* destination, size_t width, bool reverse)
+    {
+      if (!reverse)
+      {
+        if (source != destination)
+        {
+          memcpy(destination, source, width * sizeof(PixelType));
+        }
+        return;
+      }
+      if (source == destination)
+      {
+        std::reverse(destination, destination + width);
+        return;
+      }
+      for (size_t i = 0; i < width; ++i)
+      {
+        destination[i] = source[width - 1 - i];
+      }
+    }
+
+    //----------------------------------------------------------------------------
+    template<typename PixelType>
+    void FlipSlice(const PixelType* source, PixelType* destination, size_t width, size_t height, bool flipX, bool flipY, std::vector<PixelType>& row)
+    {
+      if (!flipY)
+      {
+        for (size_t y = 0; y < height; ++y)
+        {
+          CopyRow(source + y * width, destination + y * width, width, flipX);
+        }
+        return;
+      }
+
+      // Rows are exchanged in pairs, the first row of the pair is saved in case the flip is in place
+      row.resize(width);
+      for (size_t y = 0; y < height / 2; ++y)
+      {
+        const size_t opposite = height - 1 - y;
+        memcpy(row.data(), source + y * width, width * sizeof(PixelType));
+        CopyRow(source + opposite * width, destination + y * width, width, flipX);
+        CopyRow(row.data(), destination + opposite * width, width, flipX);
+      }
+      if (height % 2 == 1)
+      {
+        CopyRow(source + (height / 2) * width, destination + (height / 2) * width, width, flipX);
+      }
+    }
+
+    //----------------------------------------------------------------------------
+    template<typename PixelType>
+    void TransposeSlice(const PixelType* source, PixelType* destination, size_t width, size_t height, bool flipX, bool flipY)
+    {
+      // The destination is height pixels wide and width pixels high, destination (x, y) is source (y, x) after the flips
+      const size_t destinationWidth = height;
+      const size_t destinationHeight = width;
+      for (size_t blockY = 0; blockY < destinationHeight; blockY += TRANSPOSE_BLOCK_SIZE)
+      {
+        const size_t blockYEnd = blockY + TRANSPOSE_BLOCK_SIZE < destinationHeight ? blockY + TRANSPOSE_BLOCK_SIZE : destinationHeight;
+        for (size_t blockX = 0; blockX < destinationWidth; blockX += TRANSPOSE_BLOCK_SIZE)
+        {
+          const size_t blockXEnd = blockX + TRANSPOSE_BLOCK_SIZE < destinationWidth ? blockX + TRANSPOSE_BLOCK_SIZE : destinationWidth;
+          for (size_t y = blockY; y < blockYEnd; ++y)
+          {
+            const size_t sourceX = flipY ? destinationHeight - 1 - y : y;
+            PixelType* destinationRow = destination + y * destinationWidth;
+            for (size_t x = blockX; x < blockXEnd; ++x)
+            {
+              const size_t sourceY = flipX ? destinationWidth - 1 - x : x;
+              destinationRow[x] = source[sourceY * width + sourceX];
+            }
+          }
+        }
+      }
+    }
+
+    //----------------------------------------------------------------------------
+    template<typename PixelType>
+    bool Reorient(const byte* source, byte* destination, const FrameSize& sourceSize, const ReorientationAxes& axes)
+    {
+      const size_t width = sourceSize[0];
+      const size_t height = sourceSize[1];
+      const size_t depth = sourceSize[2];
+      const size_t sliceSize = width * height;
+      const PixelType* sourcePixels = reinterpret_cast<const PixelType*>(source);
+      PixelType* destinationPixels = reinterpret_cast<PixelType*>(destination);
+      std::vector<PixelType> row;
+
+      auto reorientSlice = [&](const PixelType* sourceSlice, PixelType* destinationSlice)
+      {
+        if (axes.Transpose)
+        {
+          TransposeSlice(sourceSlice, destinationSlice, width, height, axes.FlipX, axes.FlipY);
+        }
+        else
+        {
+          FlipSlice(sourceSlice, destinationSlice, width, height, axes.FlipX, axes.FlipY, row);
+        }
+      };
+
+      if (!axes.FlipZ)
+      {
+        for (size_t z = 0; z < depth; ++z)
+        {
+          reorientSlice(sourcePixels + z * sliceSize, destinationPixels + z * sliceSize);
+        }
+        return true;
+      }
+
+      // Slices are exchanged in pairs, as rows are in FlipSlice
+      std::shared_ptr<byte> savedSlice = source == destination && depth > 1 ? ImageBufferPool::GetInstance()->Acquire(sliceSize * sizeof(PixelType)) : nullptr;
+      for (size_t z = 0; z < depth / 2; ++z)
+      {
+        const size_t opposite = depth - 1 - z;
+        const PixelType* sourceSlice = sourcePixels + z * sliceSize;
+        if (savedSlice != nullptr)
+        {
+          memcpy(savedSlice.get(), sourceSlice, sliceSize * sizeof(PixelType));
+          sourceSlice = reinterpret_cast<const PixelType*>(savedSlice.get());
+        }
+        reorientSlice(sourcePixels + opposite * sliceSize, destinationPixels + z * sliceSize);
+        reorientSlice(sourceSlice, destinationPixels + opposite * sliceSize);
+      }
+      if (depth % 2 == 1)
+      {
+        reorientSlice(sourcePixels + (depth / 2) * sliceSize, destinationPixels + (depth / 2) * sliceSize);
+      }
+      return true;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  bool GetReorientationAxes(US_IMAGE_ORIENTATION from, US_IMAGE_ORIENTATION to, ReorientationAxes& outAxes)
+  {
+    OrientationAxes source;
+    OrientationAxes target;
+    if (!GetOrientationAxes(from, source) || !GetOrientationAxes(to, target))
+    {
+      return false;
+    }
+
+    outAxes.Transpose = source.X.Axis != target.X.Axis;
+    const ImageAxis& x = outAxes.Transpose ? source.Y : source.X;
+    const ImageAxis& y = outAxes.Transpose ? source.X : source.Y;
+    outAxes.FlipX = x.Positive != target.X.Positive;
+    outAxes.FlipY = y.Positive != target.Y.Positive;
+    outAxes.FlipZ = source.ZPositive != target.ZPositive;
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  FrameSize GetReorientedFrameSize(const FrameSize& sourceSize, const ReorientationAxes& axes)
+  {
+    return axes.Transpose ? FrameSize{ sourceSize[1], sourceSize[0], sourceSize[2] } : sourceSize;
+  }
+
+  //----------------------------------------------------------------------------
+  float4x4 GetReorientationMatrix(const FrameSize& sourceSize, const ReorientationAxes& axes)
+  {
+    const FrameSize size = GetReorientedFrameSize(sourceSize, axes);
+    const float xSign = axes.FlipX ? -1.f : 1.f;
+    const float xOffset = axes.FlipX ? size[0] - 1.f : 0.f;
+    const float ySign = axes.FlipY ? -1.f : 1.f;
+    const float yOffset = axes.FlipY ? size[1] - 1.f : 0.f;
+
+    float4x4 matrix(float4x4::identity());
+    if (axes.Transpose)
+    {
+      // source x = reoriented y, source y = reoriented x
+      matrix.m11 = 0.f;
+      matrix.m12 = ySign;
+      matrix.m14 = yOffset;
+      matrix.m21 = xSign;
+      matrix.m22 = 0.f;
+      matrix.m24 = xOffset;
+    }
+    else
+    {
+      matrix.m11 = xSign;
+      matrix.m14 = xOffset;
+      matrix.m22 = ySign;
+      matrix.m24 = yOffset;
+    }
+    matrix.m33 = axes.FlipZ ? -1.f : 1.f;
+    matrix.m34 = axes.FlipZ ? size[2] - 1.f : 0.f;
+    return matrix;
+  }
+
+  //----------------------------------------------------------------------------
+  bool ReorientPixels(const byte* source, byte* destination, const FrameSize& sourceSize, size_t bytesPerPixel, const ReorientationAxes& axes)
+  {
+    if (source == nullptr || destination == nullptr || (axes.Transpose && source == destination))
+    {
+      return false;
+    }
+
+    switch (bytesPerPixel)
+    {
+      case 1:
+        return Reorient<Pixel<1>>(source, destination, sourceSize, axes);
+      case 2:
+        return Reorient<Pixel<2>>(source, destination, sourceSize, axes);
+      case 3:
+        return Reorient<Pixel<3>>(source, destination, sourceSize, axes);
+      case 4:
+        return Reorient<Pixel<4>>(source, destination, sourceSize, axes);
+      case 6:
+        return Reorient<Pixel<6>>(source, destination, sourceSize, axes);
+      case 8:
+        return Reorient<Pixel<8>>(source, destination, sourceSize, axes);
+      case 12:
+        return Reorient<Pixel<12>>(source, destination, sourceSize, axes);
+      case 16:
+        return Reorient<Pixel<16>>(source, destination, sourceSize, axes);
+      case 24:
+        return Reorient<Pixel<24>>(source, destination, sourceSize, axes);
+      case 32:
+        return Reorient<Pixel<32>>(source, destination, sourceSize, axes);
+      default:
+        return false;
+    }
+  }
+}
@@ -0,0 +1,57 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+#pragma once
+
+// Local includes
+#include "IGTCommon.h"
+
+namespace UWPOpenIGTLink
+{
+  /*!
+    The pixel reordering that converts an image from one US_IMAGE_ORIENTATION to another.
+    The x and y axes are transposed first, then the flips are applied along the axes of the result.
+  */
+  struct ReorientationAxes
+  {
+    bool Transpose = false;
+    bool FlipX = false;
+    bool FlipY = false;
+    bool FlipZ = false;
+  };
+
+  /// Axes to reorder to convert an image in orientation from to orientation to, false if either orientation is undefined
+  bool GetReorientationAxes(US_IMAGE_ORIENTATION from, US_IMAGE_ORIENTATION to, ReorientationAxes& outAxes);
+
+  /// Frame size of a sourceSize image after reordering axes
+  FrameSize GetReorientedFrameSize(const FrameSize& sourceSize, const ReorientationAxes& axes);
+
+  /// Maps the pixel coordinates (column vector) of the reoriented image to the pixel coordinates of the sourceSize source image
+  Windows::Foundation::Numerics::float4x4 GetReorientationMatrix(const FrameSize& sourceSize, const ReorientationAxes& axes);
+
+  /*!
+    Reorder the pixels of source into destination, for pixels of 1, 2, 3, 4, 6, 8, 12, 16, 24 or 32 bytes.
+    Flips may be done in place (destination == source), transposes need a separate destination and are cache blocked.
+  */
+  bool ReorientPixels(const byte* source, byte* destination, const FrameSize& sourceSize, size_t bytesPerPixel, const ReorientationAxes& axes);
+}
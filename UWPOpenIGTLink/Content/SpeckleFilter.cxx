@@ -0,0 +1,328 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+// Local includes
+#include "pch.h"
+#include "Image.h"
+#include "ImageBufferPool.h"
+#include "PixelConversion.h"
+#include "SpeckleFilter.h"
+
+// STL includes
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+// Windows includes
+#include <ppl.h>
+
+#if defined(_M_IX86) || defined(_M_X64)
+  #define SPECKLE_FILTER_X86
+  #include <emmintrin.h>
+#endif
+
+namespace UWPOpenIGTLink
+{
+  namespace
+  {
+    // Rows filtered per task, each band also filters Radius rows on either side to feed its column pass
+    static const size_t ROWS_PER_BAND = 32;
+    // Weight of the latest frame in the running cost estimate, and decay of the estimate on a skipped frame
+    static const double COST_ESTIMATE_WEIGHT = 0.25;
+    static const double COST_ESTIMATE_DECAY = 0.9;
+
+    // Sums and range comparisons are done in a type that holds the differences and Radius * 2 + 1 values
+    template<typename ScalarType> struct SpeckleAccumulator { typedef int32 Type; };
+    template<> struct SpeckleAccumulator<float> { typedef float Type; };
+
+    //----------------------------------------------------------------------------
+    // The mean is rounded half up through float for every type, so the SSE2 path gives the same result
+    template<typename ScalarType>
+    inline ScalarType Mean(typename SpeckleAccumulator<ScalarType>::Type sum, int count)
+    {
+      return static_cast<ScalarType>(std::floor(static_cast<float>(sum) / static_cast<float>(count) + 0.5f));
+    }
+
+    template<>
+    inline float Mean<float>(float sum, int count)
+    {
+      return sum / static_cast<float>(count);
+    }
+
+    //----------------------------------------------------------------------------
+    template<typename ScalarType>
+    inline ScalarType FilterValue(ScalarType center, const ScalarType* const* taps, int tapCount, size_t x, typename SpeckleAccumulator<ScalarType>::Type threshold)
+    {
+      typedef typename SpeckleAccumulator<ScalarType>::Type AccumulatorType;
+      AccumulatorType sum = 0;
+      int count = 0;
+      for (int k = 0; k < tapCount; ++k)
+      {
+        const AccumulatorType value = static_cast<AccumulatorType>(taps[k][x]);
+        const AccumulatorType difference = value - static_cast<AccumulatorType>(center);
+        // Branchless, speckle makes the comparison unpredictable
+        const bool inRange = (difference < 0 ? -difference : difference) <= threshold;
+        sum += inRange ? value : AccumulatorType(0);
+        count += inRange ? 1 : 0;
+      }
+      return Mean<ScalarType>(sum, count);
+    }
+
+    //----------------------------------------------------------------------------
+    // Filter [begin, end) where the value x of tap k is taps[k][x] and the centre tap is taps[tapCount / 2]
+    template<typename ScalarType>
+    void FilterTaps(const ScalarType* const* taps, int tapCount, size_t begin, size_t end, typename SpeckleAccumulator<ScalarType>::Type threshold, ScalarType* destination)
+    {
+      const ScalarType* center = taps[tapCount / 2];
+      for (size_t x = begin; x < end; ++x)
+      {
+        destination[x] = FilterValue(center[x], taps, tapCount, x, threshold);
+      }
+    }
+
+#if defined(SPECKLE_FILTER_X86)
+    //----------------------------------------------------------------------------
+    // 16 values at a time from begin, returns the first value that was not processed
+    size_t FilterTapsSSE2(const uint8* const* taps, int tapCount, size_t begin, size_t end, int32 threshold, uint8* destination)
+    {
+      const __m128i zero = _mm_setzero_si128();
+      const __m128i limit = _mm_set1_epi8(static_cast<char>(threshold));
+      const uint8* centerRow = taps[tapCount / 2];
+
+      size_t x = begin;
+      for (; x + 16 <= end; x += 16)
+      {
+        const __m128i center = _mm_loadu_si128(reinterpret_cast<const __m128i*>(centerRow + x));
+        __m128i sumLow = zero;
+        __m128i sumHigh = zero;
+        __m128i count = zero;
+        for (int k = 0; k < tapCount; ++k)
+        {
+          const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(taps[k] + x));
+          // |value - center| <= threshold, unsigned saturation gives the absolute difference
+          const __m128i difference = _mm_or_si128(_mm_subs_epu8(value, center), _mm_subs_epu8(center, value));
+          const __m128i inRange = _mm_cmpeq_epi8(_mm_subs_epu8(difference, limit), zero);
+          const __m128i selected = _mm_and_si128(value, inRange);
+          sumLow = _mm_add_epi16(sumLow, _mm_unpacklo_epi8(selected, zero));
+          sumHigh = _mm_add_epi16(sumHigh, _mm_unpackhi_epi8(selected, zero));
+          count = _mm_sub_epi8(count, inRange);
+        }
+
+        // Divide in float, 4 values at a time
+        const __m128i countLow = _mm_unpacklo_epi8(count, zero);
+        const __m128i countHigh = _mm_unpackhi_epi8(count, zero);
+        const __m128i sums[4] = { _mm_unpacklo_epi16(sumLow, zero), _mm_unpackhi_epi16(sumLow, zero), _mm_unpacklo_epi16(sumHigh, zero), _mm_unpackhi_epi16(sumHigh, zero) };
+        const __m128i counts[4] = { _mm_unpacklo_epi16(countLow, zero), _mm_unpackhi_epi16(countLow, zero), _mm_unpacklo_epi16(countHigh, zero), _mm_unpackhi_epi16(countHigh, zero) };
+        __m128i means[4];
+        for (int i = 0; i < 4; ++i)
+        {
+          const __m128 mean = _mm_add_ps(_mm_div_ps(_mm_cvtepi32_ps(sums[i]), _mm_cvtepi32_ps(counts[i])), _mm_set1_ps(0.5f));
+          means[i] = _mm_cvttps_epi32(mean);
+        }
+        const __m128i result = _mm_packus_epi16(_mm_packs_epi32(means[0], means[1]), _mm_packs_epi32(means[2], means[3]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + x), result);
+      }
+      return x;
+    }
+#endif
+
+    //----------------------------------------------------------------------------
+    template<typename ScalarType>
+    void FilterRun(const ScalarType* const* taps, int tapCount, size_t begin, size_t end, typename SpeckleAccumulator<ScalarType>::Type threshold, bool, ScalarType* destination)
+    {
+      FilterTaps(taps, tapCount, begin, end, threshold, destination);
+    }
+
+    template<>
+    void FilterRun(const uint8* const* taps, int tapCount, size_t begin, size_t end, int32 threshold, bool useSSE2, uint8* destination)
+    {
+#if defined(SPECKLE_FILTER_X86)
+      if (useSSE2)
+      {
+        begin = FilterTapsSSE2(taps, tapCount, begin, end, threshold, destination);
+      }
+#endif
+      FilterTaps(taps, tapCount, begin, end, threshold, destination);
+    }
+
+    //----------------------------------------------------------------------------
+    // Filter the values [begin, end) of a row whose taps reach past its edges, the columns are clamped
+    template<typename ScalarType>
+    void FilterRowEdge(const ScalarType* source, size_t width, int radius, size_t begin, size_t end, typename SpeckleAccumulator<ScalarType>::Type threshold, ScalarType* destination)
+    {
+      const int tapCount = 2 * radius + 1;
+      ScalarType values[2 * SpeckleFilter::MAXIMUM_RADIUS + 1];
+      const ScalarType* taps[2 * SpeckleFilter::MAXIMUM_RADIUS + 1];
+      for (size_t x = begin; x < end; ++x)
+      {
+        for (int k = 0; k < tapCount; ++k)
+        {
+          const int64 column = int64(x) + k - radius;
+          values[k] = source[column < 0 ? 0 : (column >= int64(width) ? width - 1 : size_t(column))];
+          taps[k] = &values[k];
+        }
+        destination[x] = FilterValue(source[x], taps, tapCount, 0, threshold);
+      }
+    }
+
+    //----------------------------------------------------------------------------
+    // Row pass
+    template<typename ScalarType>
+    void FilterRow(const ScalarType* source, size_t width, int radius, typename SpeckleAccumulator<ScalarType>::Type threshold, bool useSSE2, ScalarType* destination)
+    {
+      if (width <= size_t(2 * radius))
+      {
+        FilterRowEdge(source, width, radius, 0, width, threshold, destination);
+        return;
+      }
+
+      // Interior, tap k of value x is source[x + k - radius], indexed from the first interior value
+      const int tapCount = 2 * radius + 1;
+      const ScalarType* taps[2 * SpeckleFilter::MAXIMUM_RADIUS + 1];
+      for (int k = 0; k < tapCount; ++k)
+      {
+        taps[k] = source + k;
+      }
+      FilterRun(taps, tapCount, 0, width - 2 * radius, threshold, useSSE2, destination + radius);
+      FilterRowEdge(source, width, radius, 0, radius, threshold, destination);
+      FilterRowEdge(source, width, radius, width - radius, width, threshold, destination);
+    }
+
+    //----------------------------------------------------------------------------
+    template<typename ScalarType>
+    void FilterImage(const byte* sourceData, const FrameSize& size, int radius, typename SpeckleAccumulator<ScalarType>::Type threshold, byte* destinationData)
+    {
+      const bool useSSE2 = PixelConversion::GetInstructionSetLevel() >= PIXEL_CONVERSION_ISA_SSE2;
+      const size_t width = size[0];
+      const size_t height = size[1];
+      const size_t bandsPerSlice = (height + ROWS_PER_BAND - 1) / ROWS_PER_BAND;
+      const int tapCount = 2 * radius + 1;
+
+      Concurrency::parallel_for(size_t(0), bandsPerSlice * size[2], [&](size_t band)
+      {
+        const size_t z = band / bandsPerSlice;
+        const size_t firstRow = (band % bandsPerSlice) * ROWS_PER_BAND;
+        const size_t lastRow = firstRow + ROWS_PER_BAND < height ? firstRow + ROWS_PER_BAND : height;
+        const ScalarType* source = reinterpret_cast<const ScalarType*>(sourceData) + z * height * width;
+        ScalarType* destination = reinterpret_cast<ScalarType*>(destinationData) + z * height * width;
+
+        // Row pass of the band and the rows its column pass reaches
+        const size_t firstFiltered = firstRow > size_t(radius) ? firstRow - radius : 0;
+        const size_t lastFiltered = lastRow + radius < height ? lastRow + radius : height;
+        std::vector<ScalarType> rowFiltered((lastFiltered - firstFiltered) * width);
+        for (size_t y = firstFiltered; y < lastFiltered; ++y)
+        {
+          FilterRow(source + y * width, width, radius, threshold, useSSE2, rowFiltered.data() + (y - firstFiltered) * width);
+        }
+
+        // Column pass, rows past the edges are clamped
+        const ScalarType* taps[2 * SpeckleFilter::MAXIMUM_RADIUS + 1];
+        for (size_t y = firstRow; y < lastRow; ++y)
+        {
+          for (int k = 0; k < tapCount; ++k)
+          {
+            const int64 row = int64(y) + k - radius;
+            const size_t clampedRow = row < 0 ? 0 : (row >= int64(height) ? height - 1 : size_t(row));
+            taps[k] = rowFiltered.data() + (clampedRow - firstFiltered) * width;
+          }
+          FilterRun(taps, tapCount, 0, width, threshold, useSSE2, destination + y * width);
+        }
+      });
+    }
+
+    //----------------------------------------------------------------------------
+    // Integer thresholds are rounded and clamped to the range of the type
+    template<typename ScalarType>
+    typename SpeckleAccumulator<ScalarType>::Type ConvertThreshold(float threshold, float maximum)
+    {
+      return static_cast<typename SpeckleAccumulator<ScalarType>::Type>(threshold >= maximum ? maximum : std::floor(threshold + 0.5f));
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  bool SpeckleFilter::Apply(const byte* source, const FrameSize& size, uint16 numberOfScalarComponents, IGTL_SCALAR_TYPE scalarType, const Parameters& parameters, byte* destination)
+  {
+    if (source == nullptr || destination == nullptr || !IsFilterSupported(numberOfScalarComponents, scalarType) ||
+        parameters.Radius > MAXIMUM_RADIUS || !(parameters.Threshold >= 0.f) || size[0] == 0 || size[1] == 0 || size[2] == 0)
+    {
+      return false;
+    }
+
+    const int radius = parameters.Radius;
+    switch (scalarType)
+    {
+      case IGTL_SCALARTYPE_UINT8:
+        FilterImage<uint8>(source, size, radius, ConvertThreshold<uint8>(parameters.Threshold, 255.f), destination);
+        return true;
+      case IGTL_SCALARTYPE_INT16:
+        FilterImage<int16>(source, size, radius, ConvertThreshold<int16>(parameters.Threshold, 65535.f), destination);
+        return true;
+      case IGTL_SCALARTYPE_UINT16:
+        FilterImage<uint16>(source, size, radius, ConvertThreshold<uint16>(parameters.Threshold, 65535.f), destination);
+        return true;
+      case IGTL_SCALARTYPE_FLOAT32:
+        FilterImage<float>(source, size, radius, parameters.Threshold, destination);
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  bool SpeckleFilter::IsFilterSupported(uint16 numberOfScalarComponents, IGTL_SCALAR_TYPE scalarType)
+  {
+    return numberOfScalarComponents == 1 && (scalarType == IGTL_SCALARTYPE_UINT8 || scalarType == IGTL_SCALARTYPE_INT16 ||
+           scalarType == IGTL_SCALARTYPE_UINT16 || scalarType == IGTL_SCALARTYPE_FLOAT32);
+  }
+
+  //----------------------------------------------------------------------------
+  std::shared_ptr<byte> SpeckleFilter::Filter(const byte* source, const FrameSize& size, uint16 numberOfScalarComponents, IGTL_SCALAR_TYPE scalarType, const Parameters& parameters,
+      uint32 latencyBudgetMicroseconds, uint64& elapsedMicroseconds)
+  {
+    elapsedMicroseconds = 0;
+    uint64 imageSize(0);
+    if (!IsFilterSupported(numberOfScalarComponents, scalarType) || !Image::ComputeImageSizeBytes(size, numberOfScalarComponents, scalarType, imageSize) || imageSize == 0)
+    {
+      return nullptr;
+    }
+
+    const double taps = double(size[0]) * size[1] * size[2] * (2 * parameters.Radius + 1);
+    if (latencyBudgetMicroseconds > 0 && m_microsecondsPerTap * taps > latencyBudgetMicroseconds)
+    {
+      m_microsecondsPerTap *= COST_ESTIMATE_DECAY;
+      return nullptr;
+    }
+
+    auto destination = ImageBufferPool::GetInstance()->Acquire(static_cast<size_t>(imageSize));
+    auto start = std::chrono::high_resolution_clock::now();
+    if (destination == nullptr || !Apply(source, size, numberOfScalarComponents, scalarType, parameters, destination.get()))
+    {
+      return nullptr;
+    }
+    elapsedMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+    const double cost = double(elapsedMicroseconds) / taps;
+    m_microsecondsPerTap = m_microsecondsPerTap == 0.0 ? cost : m_microsecondsPerTap + COST_ESTIMATE_WEIGHT * (cost - m_microsecondsPerTap);
+    return destination;
+  }
+}
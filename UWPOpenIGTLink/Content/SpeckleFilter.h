@@ -0,0 +1,69 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+#pragma once
+
+// Local includes
+#include "IGTCommon.h"
+
+// STL includes
+#include <memory>
+
+namespace UWPOpenIGTLink
+{
+  /*!
+    Edge preserving speckle reduction for greyscale (1 component) ultrasound frames.
+    A separable sigma filter, the box range kernel approximation of a bilateral filter: each pixel is replaced by the mean of the
+    pixels within Radius along a row, then along a column, that differ from it by at most Threshold. Speckle is smoothed while
+    tissue boundaries, which differ by more than the threshold, are kept. 8 bit images use SSE2, the image is split in bands of rows
+    filtered in parallel.
+  */
+  class SpeckleFilter
+  {
+  public:
+    struct Parameters
+    {
+      uint16  Radius = 2;         // pixels on each side, at most MAXIMUM_RADIUS
+      float   Threshold = 24.f;   // in scalar units
+    };
+    static const uint16 MAXIMUM_RADIUS = 8;
+
+    /// Filter source into destination (same size, must not overlap), false if the image or parameters are not supported
+    static bool Apply(const byte* source, const FrameSize& size, uint16 numberOfScalarComponents, IGTL_SCALAR_TYPE scalarType, const Parameters& parameters, byte* destination);
+    /// UINT8, UINT16, INT16 and FLOAT32 images of 1 component
+    static bool IsFilterSupported(uint16 numberOfScalarComponents, IGTL_SCALAR_TYPE scalarType);
+
+    /*!
+      Filter a frame into a pooled buffer, within a per frame latency budget (0 for none).
+      The cost of the frame is predicted from the frames filtered so far, a frame predicted to exceed the budget is not filtered and nullptr is
+      returned so the caller keeps the original. The prediction decays on each skipped frame so filtering is retried once the load has gone.
+      elapsedMicroseconds receives the time spent filtering (0 if skipped).
+    */
+    std::shared_ptr<byte> Filter(const byte* source, const FrameSize& size, uint16 numberOfScalarComponents, IGTL_SCALAR_TYPE scalarType, const Parameters& parameters,
+                                 uint32 latencyBudgetMicroseconds, uint64& elapsedMicroseconds);
+
+  protected:
+    /// Average measured cost of one tap of one pixel, 0 until a frame has been filtered
+    double m_microsecondsPerTap = 0.0;
+  };
+}
@@ -26,14 +26,123 @@ OTHER DEALINGS IN THE SOFTWARE.
 
 // Local includes
 #include "pch.h"
+#include "FastCopy.h"
+#include "ImageBufferPool.h"
+#include "ImageCodec.h"
 #include "TrackedFrameMessage.h"
 #include "Transform.h"
 
 // IGT includes
 #include <igtlMessageFactory.h>
+#include <igtlutil/igtl_util.h>
+
+// STL includes
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <sstream>
+
+namespace
+{
+  static const igtl_uint16 TRANSFORM_BLOCK_VERSION = 1;
+  static const size_t TRANSFORM_BLOCK_ELEMENT_SIZE = sizeof(igtl_uint16) * 2 + sizeof(igtl_float32) * 12;
+
+  //----------------------------------------------------------------------------
+  void AppendUInt16(std::vector<byte>& block, igtl_uint16 value)
+  {
+    block.push_back(static_cast<byte>(value >> 8));
+    block.push_back(static_cast<byte>(value & 0xFF));
+  }
+
+  //----------------------------------------------------------------------------
+  void AppendUInt32(std::vector<byte>& block, igtl_uint32 value)
+  {
+    block.push_back(static_cast<byte>(value >> 24));
+    block.push_back(static_cast<byte>((value >> 16) & 0xFF));
+    block.push_back(static_cast<byte>((value >> 8) & 0xFF));
+    block.push_back(static_cast<byte>(value & 0xFF));
+  }
+
+  //----------------------------------------------------------------------------
+  void AppendFloat32(std::vector<byte>& block, float value)
+  {
+    igtl_uint32 bits(0);
+    memcpy(&bits, &value, sizeof(bits));
+    block.push_back(static_cast<byte>(bits >> 24));
+    block.push_back(static_cast<byte>((bits >> 16) & 0xFF));
+    block.push_back(static_cast<byte>((bits >> 8) & 0xFF));
+    block.push_back(static_cast<byte>(bits & 0xFF));
+  }
+
+  //----------------------------------------------------------------------------
+  igtl_uint16 ReadUInt16(const byte* data)
+  {
+    return static_cast<igtl_uint16>((data[0] << 8) | data[1]);
+  }
+
+  //----------------------------------------------------------------------------
+  float ReadFloat32(const byte* data)
+  {
+    igtl_uint32 bits = (static_cast<igtl_uint32>(data[0]) << 24) | (static_cast<igtl_uint32>(data[1]) << 16) | (static_cast<igtl_uint32>(data[2]) << 8) | data[3];
+    float value(0.f);
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  //----------------------------------------------------------------------------
+  // The binary block only carries the top three rows of a matrix
+  bool IsAffine(const Windows::Foundation::Numerics::float4x4& m)
+  {
+    return m.m41 == 0.f && m.m42 == 0.f && m.m43 == 0.f && m.m44 == 1.f;
+  }
+
+  //----------------------------------------------------------------------------
+  bool GetUInt32Attribute(const UWPOpenIGTLink::FrameFieldTable& table, const std::string& name, uint32& value)
+  {
+    std::string valueStr;
+    if (!table.GetRootAttribute(name, valueStr))
+    {
+      return false;
+    }
+    return UWPOpenIGTLink::ParseNumber(valueStr.data(), valueStr.data() + valueStr.size(), value) != valueStr.data();
+  }
+
+  //----------------------------------------------------------------------------
+  std::string EscapeXmlAttribute(const std::string& value)
+  {
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (auto c : value)
+    {
+      switch (c)
+      {
+        case '&':
+          escaped.append("&amp;");
+          break;
+        case '<':
+          escaped.append("&lt;");
+          break;
+        case '>':
+          escaped.append("&gt;");
+          break;
+        case '"':
+          escaped.append("&quot;");
+          break;
+        default:
+          escaped.push_back(c);
+      }
+    }
+    return escaped;
+  }
+}
 
 namespace igtl
 {
+  const char* TrackedFrameMessage::CAPABILITIES_METADATA_KEY = "TrackedFrameCapabilities";
+  const char* TrackedFrameMessage::CAPABILITY_BINARY_TRANSFORMS = "BinaryTransforms";
+  const char* TrackedFrameMessage::CAPABILITY_LZ4_IMAGE = "LZ4Image";
+  const char* TrackedFrameMessage::CAPABILITY_DELTA_IMAGE = "DeltaImage";
+
   //----------------------------------------------------------------------------
   TrackedFrameMessage::TrackedFrameMessage()
     : MessageBase()
@@ -78,7 +187,36 @@ namespace igtl
   //----------------------------------------------------------------------------
   std::shared_ptr<byte> TrackedFrameMessage::GetImage()
   {
-    return this->m_image;
+    if (this->m_image != nullptr || !this->m_imageValid || this->m_imageOffset == 0)
+    {
+      return this->m_image;
+    }
+
+    // Alias the receive buffer, the control block holds a reference to this message so the body outlives every user of the image.
+    // Every caller gets the same control block, so copy-on-write sees all of them (e.g. an image and a delta reference) in use_count.
+    std::lock_guard<std::mutex> guard(this->m_imageAliasMutex);
+    auto image = this->m_imageAlias.lock();
+    if (image == nullptr)
+    {
+      auto owner = std::make_shared<Pointer>(this);
+      image = std::shared_ptr<byte>(owner, reinterpret_cast<byte*>(this->m_Content) + this->m_imageOffset);
+      this->m_imageAlias = image;
+    }
+    return image;
+  }
+
+  //----------------------------------------------------------------------------
+  std::shared_ptr<UWPOpenIGTLink::FrameFieldTable> TrackedFrameMessage::GetFrameFields()
+  {
+    if (this->m_frameFields == nullptr)
+    {
+      return nullptr;
+    }
+
+    auto owner = std::make_shared<Pointer>(this);
+    auto table = std::make_shared<UWPOpenIGTLink::FrameFieldTable>(*this->m_frameFields);
+    table->Rebind(std::shared_ptr<const char>(owner, this->m_frameFields->GetData()));
+    return table;
   }
 
   //----------------------------------------------------------------------------
@@ -105,6 +243,201 @@ namespace igtl
     }
   }
 
+  //----------------------------------------------------------------------------
+  bool TrackedFrameMessage::SetImage(std::shared_ptr<byte> imageData, const UWPOpenIGTLink::FrameSize& frameSize, igtl_uint16 numberOfComponents, UWPOpenIGTLink::IGTL_SCALAR_TYPE scalarType,
+                                     UWPOpenIGTLink::US_IMAGE_TYPE imageType, UWPOpenIGTLink::US_IMAGE_ORIENTATION imageOrientation)
+  {
+    // The message header holds 16 bit extents and a 32 bit byte count
+    uint64 imageSize(0);
+    if (frameSize[0] > 0xFFFF || frameSize[1] > 0xFFFF || frameSize[2] > 0xFFFF ||
+        !UWPOpenIGTLink::Image::ComputeImageSizeBytes(frameSize, numberOfComponents, scalarType, imageSize) ||
+        imageSize > (std::numeric_limits<igtl_uint32>::max)())
+    {
+      OutputDebugStringA("TrackedFrameMessage: Image is too large to be described by a TRACKEDFRAME message.");
+      m_image = nullptr;
+      m_imageOffset = 0;
+      m_imageAlias.reset();
+      m_imageValid = false;
+      m_messageHeader.m_ImageDataSizeInBytes = 0;
+      return false;
+    }
+
+    m_image = imageData;
+    m_imageOffset = 0;
+    m_imageAlias.reset();
+    m_imageValid = (imageData != nullptr);
+
+    m_messageHeader.m_ScalarType = static_cast<igtl_uint16>(scalarType);
+    m_messageHeader.m_NumberOfComponents = numberOfComponents;
+    m_messageHeader.m_ImageType = static_cast<igtl_uint16>(imageType);
+    m_messageHeader.m_FrameSize[0] = static_cast<igtl_uint16>(frameSize[0]);
+    m_messageHeader.m_FrameSize[1] = static_cast<igtl_uint16>(frameSize[1]);
+    m_messageHeader.m_FrameSize[2] = static_cast<igtl_uint16>(frameSize[2]);
+    m_messageHeader.m_ImageOrientation = static_cast<igtl_uint16>(imageOrientation);
+    m_messageHeader.m_ImageDataSizeInBytes = m_imageValid ? static_cast<igtl_uint32>(imageSize) : 0;
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  void TrackedFrameMessage::SetBinaryTransformsEnabled(bool enabled)
+  {
+    m_binaryTransformsEnabled = enabled;
+  }
+
+  //----------------------------------------------------------------------------
+  bool TrackedFrameMessage::GetBinaryTransformsEnabled() const
+  {
+    return m_binaryTransformsEnabled;
+  }
+
+  //----------------------------------------------------------------------------
+  void TrackedFrameMessage::SetImageCompressionEnabled(bool enabled)
+  {
+    m_imageCompressionEnabled = enabled;
+  }
+
+  //----------------------------------------------------------------------------
+  bool TrackedFrameMessage::GetImageCompressionEnabled() const
+  {
+    return m_imageCompressionEnabled;
+  }
+
+  //----------------------------------------------------------------------------
+  void TrackedFrameMessage::SetImageDeltaStream(std::shared_ptr<UWPOpenIGTLink::DeltaStreamState> state)
+  {
+    m_deltaStream = state;
+  }
+
+  //----------------------------------------------------------------------------
+  void TrackedFrameMessage::CommitImageDelta(bool sent)
+  {
+    if (m_deltaStream == nullptr || !m_imageDeltaEncoded)
+    {
+      return;
+    }
+
+    auto& stream = *m_deltaStream;
+    if (!sent)
+    {
+      // The receiver may or may not have the frame, resynchronize with a key frame
+      stream.Valid = false;
+      return;
+    }
+
+    // The caller may reuse its image buffer, so the reference is a copy
+    const size_t imageSize = m_messageHeader.m_ImageDataSizeInBytes;
+    if (stream.Reference == nullptr || stream.ReferenceSize != imageSize)
+    {
+      stream.Reference = UWPOpenIGTLink::ImageBufferPool::GetInstance()->Acquire(imageSize);
+      stream.ReferenceSize = imageSize;
+    }
+    if (stream.Reference == nullptr)
+    {
+      stream.Valid = false;
+      return;
+    }
+    // The reference is compared against the next frame, keep it in cache rather than streaming it past
+    memcpy(stream.Reference.get(), m_image.get(), imageSize);
+    stream.FrameNumber = m_deltaFrameNumber;
+    stream.Valid = true;
+  }
+
+  //----------------------------------------------------------------------------
+  bool TrackedFrameMessage::IsImageDeltaEncoded() const
+  {
+    return m_imageDeltaEncoded;
+  }
+
+  //----------------------------------------------------------------------------
+  bool TrackedFrameMessage::DecodeImageDelta(UWPOpenIGTLink::DeltaStreamState& state)
+  {
+    if (!m_imageDeltaEncoded || !m_imageValid)
+    {
+      return true;
+    }
+
+    const size_t imageSize = m_messageHeader.m_ImageDataSizeInBytes;
+    if (m_deltaKeyFrame)
+    {
+      state.Reference = GetImage();
+      state.ReferenceSize = imageSize;
+      state.FrameNumber = m_deltaFrameNumber;
+      state.Valid = true;
+      return true;
+    }
+
+    // Without the previous frame the residual is useless, wait for the next key frame
+    if (!state.Valid || state.FrameNumber + 1 != m_deltaFrameNumber || state.ReferenceSize != imageSize)
+    {
+      state.Valid = false;
+      m_imageValid = false;
+      return false;
+    }
+
+    const byte* residual = m_deltaResidualOffset != 0 ? reinterpret_cast<byte*>(m_Content) + m_deltaResidualOffset : m_deltaResidual.data();
+    std::shared_ptr<byte> image = UWPOpenIGTLink::ImageBufferPool::GetInstance()->Acquire(imageSize);
+    if (image == nullptr || !UWPOpenIGTLink::DeltaDecode(residual, m_deltaResidualSize, state.Reference.get(), image.get(), imageSize))
+    {
+      state.Valid = false;
+      m_imageValid = false;
+      return false;
+    }
+
+    m_image = image;
+    m_deltaResidual.clear();
+    m_deltaResidual.shrink_to_fit();
+    state.Reference = image;
+    state.FrameNumber = m_deltaFrameNumber;
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  bool TrackedFrameMessage::IsCapabilityAdvertised(igtl::MessageBase* message, const std::string& capability)
+  {
+    std::string capabilities;
+    if (message == nullptr || !message->GetMetaDataElement(CAPABILITIES_METADATA_KEY, capabilities))
+    {
+      return false;
+    }
+    return IsCapabilityListed(capabilities, capability);
+  }
+
+  //----------------------------------------------------------------------------
+  bool TrackedFrameMessage::IsCapabilityListed(const std::string& capabilities, const std::string& capability)
+  {
+    std::istringstream iss(capabilities);
+    std::string entry;
+    while (std::getline(iss, entry, ','))
+    {
+      if (UWPOpenIGTLink::IsEqualInsensitive(entry, capability))
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  //----------------------------------------------------------------------------
+  void TrackedFrameMessage::AdvertiseCapability(igtl::MessageBase* message, const std::string& capability)
+  {
+    if (message == nullptr || message->GetHeaderVersion() < IGTL_HEADER_VERSION_2)
+    {
+      return;
+    }
+
+    std::string capabilities;
+    if (message->GetMetaDataElement(CAPABILITIES_METADATA_KEY, capabilities))
+    {
+      if (IsCapabilityListed(capabilities, capability))
+      {
+        return;
+      }
+      capabilities.append(",");
+    }
+    capabilities.append(capability);
+    message->SetMetaDataElement(CAPABILITIES_METADATA_KEY, IANA_TYPE_US_ASCII, capabilities);
+  }
+
   //----------------------------------------------------------------------------
   UWPOpenIGTLink::US_IMAGE_TYPE TrackedFrameMessage::GetImageType()
   {
@@ -200,9 +533,288 @@ namespace igtl
   //----------------------------------------------------------------------------
   int TrackedFrameMessage::CalculateContentBufferSize()
   {
+    GenerateFrameDescription();
+
     return static_cast<int>(this->m_messageHeader.GetMessageHeaderSize()
-                            + this->m_messageHeader.m_ImageDataSizeInBytes
-                            + this->m_messageHeader.m_XmlDataSizeInBytes);
+                            + this->GetImagePayloadSize()
+                            + this->m_messageHeader.m_XmlDataSizeInBytes
+                            + this->m_transformBlock.size());
+  }
+
+  //----------------------------------------------------------------------------
+  size_t TrackedFrameMessage::GetImagePayloadSize() const
+  {
+    return m_imagePayloadSize;
+  }
+
+  //----------------------------------------------------------------------------
+  void TrackedFrameMessage::SetImagePyramid(std::shared_ptr<const UWPOpenIGTLink::ImagePyramid> pyramid)
+  {
+    m_imagePyramid = pyramid;
+  }
+
+  //----------------------------------------------------------------------------
+  std::shared_ptr<const UWPOpenIGTLink::ImagePyramid> TrackedFrameMessage::GetImagePyramid() const
+  {
+    return m_imagePyramid;
+  }
+
+  //----------------------------------------------------------------------------
+  void TrackedFrameMessage::ReplaceImage(std::shared_ptr<byte> image)
+  {
+    m_image = image;
+  }
+
+  //----------------------------------------------------------------------------
+  void TrackedFrameMessage::DropImage()
+  {
+    m_image = nullptr;
+    m_imageOffset = 0;
+    m_imageAlias.reset();
+    m_imageValid = false;
+    m_imagePyramid = nullptr;
+  }
+
+  //----------------------------------------------------------------------------
+  void TrackedFrameMessage::SetImageContentHash(igtl_uint64 hash, bool duplicate)
+  {
+    m_imageContentHash = hash;
+    m_imageDuplicate = duplicate;
+  }
+
+  //----------------------------------------------------------------------------
+  igtl_uint64 TrackedFrameMessage::GetImageContentHash() const
+  {
+    return m_imageContentHash;
+  }
+
+  //----------------------------------------------------------------------------
+  bool TrackedFrameMessage::IsImageDuplicate() const
+  {
+    return m_imageDuplicate;
+  }
+
+  //----------------------------------------------------------------------------
+  const byte* TrackedFrameMessage::GetImagePayload() const
+  {
+    if (!m_compressedImage.empty())
+    {
+      return m_compressedImage.data();
+    }
+    if (m_imageDeltaEncoded && !m_deltaKeyFrame)
+    {
+      return m_deltaResidual.data();
+    }
+    return m_image.get();
+  }
+
+  //----------------------------------------------------------------------------
+  void TrackedFrameMessage::GenerateFrameDescription()
+  {
+    // A frame with a non affine (e.g. projective) transform is sent as text fields, which carry the whole matrix
+    m_transformBlock.clear();
+    if (m_binaryTransformsEnabled && !m_frameTransforms.empty() &&
+        std::all_of(m_frameTransforms.begin(), m_frameTransforms.end(), [](UWPOpenIGTLink::Transform ^ transform) { return IsAffine(transform->Matrix); }))
+    {
+      EncodeTransformBlock(m_transformBlock);
+    }
+
+    // Delta stream, key frames carry the image and the other frames the residual against the previous frame
+    // The stream is only read here, CommitImageDelta advances it once the message has been sent
+    m_imageDeltaEncoded = false;
+    m_deltaResidual.clear();
+    m_imagePayloadSize = m_messageHeader.m_ImageDataSizeInBytes;
+    if (m_deltaStream != nullptr && m_image != nullptr && m_messageHeader.m_ImageDataSizeInBytes > 0)
+    {
+      const auto& stream = *m_deltaStream;
+      const size_t imageSize = m_messageHeader.m_ImageDataSizeInBytes;
+      m_deltaFrameNumber = stream.Valid ? stream.FrameNumber + 1 : 0;
+      m_deltaKeyFrame = !stream.Valid || stream.ReferenceSize != imageSize || stream.KeyFrameInterval <= 1 || m_deltaFrameNumber % stream.KeyFrameInterval == 0;
+      if (!m_deltaKeyFrame)
+      {
+        UWPOpenIGTLink::DeltaEncode(m_image.get(), stream.Reference.get(), imageSize, m_deltaResidual);
+        m_imagePayloadSize = m_deltaResidual.size();
+      }
+      m_imageDeltaEncoded = true;
+    }
+
+    m_compressedImage.clear();
+    if (m_imageCompressionEnabled && m_image != nullptr && m_imagePayloadSize > 0)
+    {
+      // Only worth sending compressed if it saves something, the bound leaves room for the encoder to finish before giving up
+      m_compressedImage.resize(UWPOpenIGTLink::LZ4CompressBound(m_imagePayloadSize));
+      size_t compressedSize = UWPOpenIGTLink::LZ4Compress(GetImagePayload(), m_imagePayloadSize, m_compressedImage.data(), m_compressedImage.size());
+      if (compressedSize == 0 || compressedSize >= m_imagePayloadSize)
+      {
+        m_compressedImage.clear();
+      }
+      else
+      {
+        m_compressedImage.resize(compressedSize);
+        m_imagePayloadSize = compressedSize;
+      }
+    }
+
+    std::ostringstream xml;
+    xml.precision(std::numeric_limits<float>::max_digits10);
+    xml << "<TrackedFrame ImageDataValid=\"" << (m_image != nullptr ? "true" : "false") << "\"";
+    if (!m_transformBlock.empty())
+    {
+      xml << " TransformBlockSize=\"" << m_transformBlock.size() << "\"";
+    }
+    if (!m_compressedImage.empty())
+    {
+      xml << " ImageCompression=\"" << UWPOpenIGTLink::IMAGE_COMPRESSION_LZ4 << "\" CompressedImageSize=\"" << m_compressedImage.size() << "\"";
+    }
+    if (m_imageDeltaEncoded)
+    {
+      xml << " DeltaFrameNumber=\"" << m_deltaFrameNumber << "\" DeltaKeyFrame=\"" << (m_deltaKeyFrame ? "true" : "false") << "\"";
+      if (!m_deltaKeyFrame)
+      {
+        xml << " DeltaImageSize=\"" << m_deltaResidual.size() << "\"";
+      }
+    }
+    xml << ">";
+
+    for (auto& pair : m_MetaDataMap)
+    {
+      if (pair.first == CAPABILITIES_METADATA_KEY)
+      {
+        continue;
+      }
+      xml << "<CustomFrameField Name=\"" << EscapeXmlAttribute(pair.first) << "\" Value=\"" << EscapeXmlAttribute(pair.second.second) << "\" />";
+    }
+
+    if (m_transformBlock.empty())
+    {
+      for (auto& transform : m_frameTransforms)
+      {
+        std::wstring wideName = transform->Name->GetTransformNameInternal();
+        std::string name = EscapeXmlAttribute(std::string(begin(wideName), end(wideName)));
+        float4x4 m = transform->Matrix;
+        xml << "<CustomFrameField Name=\"" << name << "Transform\" Value=\""
+            << m.m11 << " " << m.m12 << " " << m.m13 << " " << m.m14 << " "
+            << m.m21 << " " << m.m22 << " " << m.m23 << " " << m.m24 << " "
+            << m.m31 << " " << m.m32 << " " << m.m33 << " " << m.m34 << " "
+            << m.m41 << " " << m.m42 << " " << m.m43 << " " << m.m44 << "\" />";
+        xml << "<CustomFrameField Name=\"" << name << "TransformStatus\" Value=\"" << (transform->Valid ? "OK" : "INVALID") << "\" />";
+      }
+    }
+    xml << "</TrackedFrame>";
+
+    m_trackedFrameXmlData = xml.str();
+    m_messageHeader.m_XmlDataSizeInBytes = static_cast<igtl_uint32>(m_trackedFrameXmlData.size());
+  }
+
+  //----------------------------------------------------------------------------
+  void TrackedFrameMessage::EncodeTransformBlock(std::vector<byte>& block) const
+  {
+    // Name table, each distinct transform name is written once and referenced by index
+    std::map<std::string, igtl_uint16> nameIds;
+    std::vector<std::string> names;
+    std::vector<igtl_uint16> elementNameIds;
+    for (auto& transform : m_frameTransforms)
+    {
+      std::wstring wideName = transform->Name->GetTransformNameInternal();
+      std::string name(begin(wideName), end(wideName));
+      auto iter = nameIds.find(name);
+      if (iter == nameIds.end())
+      {
+        iter = nameIds.insert(std::make_pair(name, static_cast<igtl_uint16>(names.size()))).first;
+        names.push_back(name);
+      }
+      elementNameIds.push_back(iter->second);
+    }
+
+    block.clear();
+    block.reserve(sizeof(igtl_uint16) * 3 + names.size() * (sizeof(igtl_uint16) + 32) + m_frameTransforms.size() * TRANSFORM_BLOCK_ELEMENT_SIZE);
+    AppendUInt16(block, TRANSFORM_BLOCK_VERSION);
+    AppendUInt16(block, static_cast<igtl_uint16>(names.size()));
+    for (auto& name : names)
+    {
+      AppendUInt16(block, static_cast<igtl_uint16>(name.size()));
+      block.insert(block.end(), name.begin(), name.end());
+    }
+
+    AppendUInt16(block, static_cast<igtl_uint16>(m_frameTransforms.size()));
+    for (size_t i = 0; i < m_frameTransforms.size(); ++i)
+    {
+      float4x4 m = m_frameTransforms[i]->Matrix;
+      AppendUInt16(block, elementNameIds[i]);
+      AppendUInt16(block, static_cast<igtl_uint16>(m_frameTransforms[i]->Valid ? UWPOpenIGTLink::FIELD_OK : UWPOpenIGTLink::FIELD_INVALID));
+
+      // Only the top three rows are sent, GenerateFrameDescription only uses the block if every last row is 0 0 0 1
+      const float values[12] = { m.m11, m.m12, m.m13, m.m14, m.m21, m.m22, m.m23, m.m24, m.m31, m.m32, m.m33, m.m34 };
+      for (auto value : values)
+      {
+        AppendFloat32(block, value);
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  bool TrackedFrameMessage::DecodeTransformBlock(const byte* block, size_t blockSize)
+  {
+    const byte* end = block + blockSize;
+    if (blockSize < sizeof(igtl_uint16) * 2 || ReadUInt16(block) != TRANSFORM_BLOCK_VERSION)
+    {
+      return false;
+    }
+    igtl_uint16 nameCount = ReadUInt16(block + sizeof(igtl_uint16));
+    block += sizeof(igtl_uint16) * 2;
+
+    std::vector<std::wstring> names;
+    names.reserve(nameCount);
+    for (igtl_uint16 i = 0; i < nameCount; ++i)
+    {
+      if (end - block < static_cast<ptrdiff_t>(sizeof(igtl_uint16)))
+      {
+        return false;
+      }
+      igtl_uint16 length = ReadUInt16(block);
+      block += sizeof(igtl_uint16);
+      if (end - block < length)
+      {
+        return false;
+      }
+      names.push_back(std::wstring(block, block + length));
+      block += length;
+    }
+
+    if (end - block < static_cast<ptrdiff_t>(sizeof(igtl_uint16)))
+    {
+      return false;
+    }
+    igtl_uint16 elementCount = ReadUInt16(block);
+    block += sizeof(igtl_uint16);
+    if (static_cast<size_t>(end - block) < elementCount * TRANSFORM_BLOCK_ELEMENT_SIZE)
+    {
+      return false;
+    }
+
+    for (igtl_uint16 i = 0; i < elementCount; ++i, block += TRANSFORM_BLOCK_ELEMENT_SIZE)
+    {
+      igtl_uint16 nameId = ReadUInt16(block);
+      igtl_uint16 status = ReadUInt16(block + sizeof(igtl_uint16));
+      if (nameId >= names.size())
+      {
+        return false;
+      }
+
+      const byte* values = block + sizeof(igtl_uint16) * 2;
+      float4x4 matrix(ReadFloat32(values + 0), ReadFloat32(values + 4), ReadFloat32(values + 8), ReadFloat32(values + 12),
+                      ReadFloat32(values + 16), ReadFloat32(values + 20), ReadFloat32(values + 24), ReadFloat32(values + 28),
+                      ReadFloat32(values + 32), ReadFloat32(values + 36), ReadFloat32(values + 40), ReadFloat32(values + 44),
+                      0.f, 0.f, 0.f, 1.f);
+
+      auto entry = ref new UWPOpenIGTLink::Transform();
+      entry->Name = ref new UWPOpenIGTLink::TransformName(names[nameId]);
+      entry->Matrix = matrix;
+      entry->Valid = (status == UWPOpenIGTLink::FIELD_OK);
+      m_frameTransforms.push_back(entry);
+    }
+
+    return true;
   }
 
   //----------------------------------------------------------------------------
@@ -225,12 +837,23 @@ namespace igtl
 
     // Copy xml data
     char* xmlData = (char*)(this->m_Content + header->GetMessageHeaderSize());
-    strncpy(xmlData, this->m_trackedFrameXmlData.c_str(), this->m_trackedFrameXmlData.size());
+    memcpy(xmlData, this->m_trackedFrameXmlData.data(), this->m_trackedFrameXmlData.size());
     header->m_XmlDataSizeInBytes = this->m_messageHeader.m_XmlDataSizeInBytes;
 
     // Copy image data
     void* imageData = (void*)(this->m_Content + header->GetMessageHeaderSize() + header->m_XmlDataSizeInBytes);
-    memcpy(imageData, m_image.get(), this->m_messageHeader.m_ImageDataSizeInBytes);
+    if (GetImagePayload() != nullptr)
+    {
+      UWPOpenIGTLink::FastCopy(imageData, GetImagePayload(), GetImagePayloadSize());
+    }
+
+    // Copy binary transform block, if any
+    if (!m_transformBlock.empty())
+    {
+      memcpy((byte*)imageData + GetImagePayloadSize(), m_transformBlock.data(), m_transformBlock.size());
+    }
+    m_compressedImage.clear();
+    m_deltaResidual.clear();
 
     // Set timestamp
     igtl::TimeStamp::Pointer timestamp = igtl::TimeStamp::New();
@@ -244,108 +867,379 @@ namespace igtl
   }
 
   //----------------------------------------------------------------------------
-  int TrackedFrameMessage::UnpackContent()
+  bool TrackedFrameMessage::PackSegments(std::vector<PackedSegment>& outSegments)
   {
-    TrackedFrameHeader* header = (TrackedFrameHeader*)(this->m_Content);
+    outSegments.clear();
 
-    // Convert header endian
-    header->ConvertEndianness();
+    GenerateFrameDescription();
+    std::shared_ptr<byte> image = GetImage();
+    if (image == nullptr && m_messageHeader.m_ImageDataSizeInBytes > 0)
+    {
+      return false;
+    }
 
-    // Copy header
-    this->m_messageHeader.m_ScalarType = header->m_ScalarType;
-    this->m_messageHeader.m_NumberOfComponents = header->m_NumberOfComponents;
-    this->m_messageHeader.m_ImageType = header->m_ImageType;
-    this->m_messageHeader.m_FrameSize[0] = header->m_FrameSize[0];
-    this->m_messageHeader.m_FrameSize[1] = header->m_FrameSize[1];
-    this->m_messageHeader.m_FrameSize[2] = header->m_FrameSize[2];
-    this->m_messageHeader.m_ImageDataSizeInBytes = header->m_ImageDataSizeInBytes;
-    this->m_messageHeader.m_XmlDataSizeInBytes = header->m_XmlDataSizeInBytes;
-    this->m_messageHeader.m_ImageOrientation = header->m_ImageOrientation;
-    memcpy(this->m_messageHeader.m_EmbeddedImageTransform, header->m_EmbeddedImageTransform, sizeof(igtl::Matrix4x4));
+    // Set timestamp
+    igtl::TimeStamp::Pointer timestamp = igtl::TimeStamp::New();
+    timestamp->GetTime();
+    this->SetTimeStamp(timestamp);
 
-    // Copy xml data
-    char* xmlData = (char*)(this->m_Content + header->GetMessageHeaderSize());
-    this->m_trackedFrameXmlData.assign(xmlData, header->m_XmlDataSizeInBytes);
+    // Metadata trailer, same layout as MessageBase::PackMetaData
+    std::vector<byte> metaData;
+    igtl_uint16 metaDataHeaderSize(0);
+    igtl_uint32 metaDataSize(0);
+    if (m_HeaderVersion >= IGTL_HEADER_VERSION_2 && !m_MetaDataMap.empty())
+    {
+      AppendUInt16(metaData, static_cast<igtl_uint16>(m_MetaDataMap.size()));
+      for (auto& pair : m_MetaDataMap)
+      {
+        AppendUInt16(metaData, static_cast<igtl_uint16>(pair.first.size()));
+        AppendUInt16(metaData, static_cast<igtl_uint16>(pair.second.first));
+        AppendUInt32(metaData, static_cast<igtl_uint32>(pair.second.second.size()));
+      }
+      metaDataHeaderSize = static_cast<igtl_uint16>(metaData.size());
+      for (auto& pair : m_MetaDataMap)
+      {
+        metaData.insert(metaData.end(), pair.first.begin(), pair.first.end());
+        metaData.insert(metaData.end(), pair.second.second.begin(), pair.second.second.end());
+      }
+      metaDataSize = static_cast<igtl_uint32>(metaData.size()) - metaDataHeaderSize;
+    }
 
-    Windows::Data::Xml::Dom::XmlDocument document;
-    document.LoadXml(ref new Platform::String(std::wstring(m_trackedFrameXmlData.begin(), m_trackedFrameXmlData.end()).c_str()));
+    const size_t extendedHeaderSize = m_HeaderVersion >= IGTL_HEADER_VERSION_2 ? sizeof(igtl_extended_header) : 0;
+    const size_t frameHeaderSize = m_messageHeader.GetMessageHeaderSize();
+    const size_t stagingSize = IGTL_HEADER_SIZE + extendedHeaderSize + frameHeaderSize + m_trackedFrameXmlData.size();
+    const igtl_uint64 bodySize = extendedHeaderSize + frameHeaderSize + m_trackedFrameXmlData.size() + GetImagePayloadSize() + m_transformBlock.size() + metaData.size();
 
-    auto rootAttributes = document.GetElementsByTagName(L"TrackedFrame")->Item(0)->Attributes;
+    // Small staging segment: igtl header, extended header, frame header and xml
+    std::shared_ptr<byte> staging(new byte[stagingSize], std::default_delete<byte[]>());
 
-    igtl::TimeStamp::Pointer ts = igtl::TimeStamp::New();
-    this->GetTimeStamp(ts);
-    this->m_timestamp = ts->GetTimeStamp();
+    byte* cursor = staging.get() + IGTL_HEADER_SIZE;
+    if (extendedHeaderSize > 0)
+    {
+      igtl_extended_header* extendedHeader = reinterpret_cast<igtl_extended_header*>(cursor);
+      extendedHeader->extended_header_size = static_cast<igtl_uint16>(extendedHeaderSize);
+      extendedHeader->meta_data_header_size = metaDataHeaderSize;
+      extendedHeader->meta_data_size = metaDataSize;
+      extendedHeader->message_id = m_MessageId;
+      igtl_extended_header_convert_byte_order(extendedHeader);
+      cursor += extendedHeaderSize;
+    }
 
-    this->m_imageValid = dynamic_cast<Platform::String^>(rootAttributes->GetNamedItem(L"ImageDataValid")->NodeValue) == L"true";
+    TrackedFrameHeader header(m_messageHeader);
+    header.ConvertEndianness();
+    memcpy(cursor, &header, frameHeaderSize);
+    cursor += frameHeaderSize;
+    memcpy(cursor, m_trackedFrameXmlData.data(), m_trackedFrameXmlData.size());
 
-    if (this->m_imageValid)
+    // Incremental CRC over the body segments, in send order
+    igtl_uint64 crc = crc64(0, 0, 0LL);
+    crc = crc64(staging.get() + IGTL_HEADER_SIZE, stagingSize - IGTL_HEADER_SIZE, crc);
+    if (m_compressedImage.empty() && !m_imageDeltaEncoded)
     {
-      // Make a duplicate of the image that is reference counted, this allows it to persist in memory while it's needed
-      this->m_image = std::shared_ptr<byte>(new byte[header->m_ImageDataSizeInBytes], std::default_delete<byte[]>());
-      memcpy(m_image.get(), this->m_Content + header->GetMessageHeaderSize() + header->m_XmlDataSizeInBytes, header->m_ImageDataSizeInBytes);
+      // Raw image, sent straight from its own buffer
+      if (m_messageHeader.m_ImageDataSizeInBytes > 0)
+      {
+        crc = crc64(image.get(), m_messageHeader.m_ImageDataSizeInBytes, crc);
+      }
+    }
+    else if (GetImagePayloadSize() > 0)
+    {
+      crc = crc64(const_cast<byte*>(GetImagePayload()), GetImagePayloadSize(), crc);
+    }
+    if (!m_transformBlock.empty())
+    {
+      crc = crc64(m_transformBlock.data(), m_transformBlock.size(), crc);
+    }
+    if (!metaData.empty())
+    {
+      crc = crc64(metaData.data(), metaData.size(), crc);
     }
 
-    for (unsigned int i = 0; i < document.GetElementsByTagName(L"TrackedFrame")->Item(0)->ChildNodes->Size; ++i)
+    igtl_header* igtlHeader = reinterpret_cast<igtl_header*>(staging.get());
+    memset(igtlHeader, 0, IGTL_HEADER_SIZE);
+    igtlHeader->header_version = m_HeaderVersion;
+    strncpy(igtlHeader->name, m_SendMessageType.c_str(), IGTL_HEADER_TYPE_SIZE);
+    strncpy(igtlHeader->device_name, m_DeviceName.c_str(), IGTL_HEADER_NAME_SIZE);
+    igtl_uint64 ts = m_TimeStampSec & 0xFFFFFFFF;
+    igtlHeader->timestamp = (ts << 32) | (m_TimeStampSecFraction & 0xFFFFFFFF);
+    igtlHeader->body_size = bodySize;
+    igtlHeader->crc = crc;
+    igtl_header_convert_byte_order(igtlHeader);
+
+    outSegments.push_back(PackedSegment{ staging, stagingSize });
+    if (!m_compressedImage.empty() || (m_imageDeltaEncoded && !m_deltaKeyFrame))
+    {
+      // Encoded payloads are owned by the segment
+      auto encoded = std::make_shared<std::vector<byte>>(!m_compressedImage.empty() ? std::move(m_compressedImage) : std::move(m_deltaResidual));
+      m_compressedImage.clear();
+      m_deltaResidual.clear();
+      outSegments.push_back(PackedSegment{ std::shared_ptr<byte>(encoded, encoded->data()), encoded->size() });
+    }
+    else if (m_messageHeader.m_ImageDataSizeInBytes > 0)
     {
-      auto childNode = document.GetElementsByTagName(L"TrackedFrame")->Item(0)->ChildNodes->Item(i);
+      outSegments.push_back(PackedSegment{ image, m_messageHeader.m_ImageDataSizeInBytes });
+    }
+    if (!m_transformBlock.empty())
+    {
+      auto block = std::make_shared<std::vector<byte>>(m_transformBlock);
+      outSegments.push_back(PackedSegment{ std::shared_ptr<byte>(block, block->data()), block->size() });
+    }
+    if (!metaData.empty())
+    {
+      auto block = std::make_shared<std::vector<byte>>(std::move(metaData));
+      outSegments.push_back(PackedSegment{ std::shared_ptr<byte>(block, block->data()), block->size() });
+    }
+
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  bool TrackedFrameMessage::UnpackFrameDescription(size_t receivedBodySize)
+  {
+    if (this->m_frameDescriptionUnpacked)
+    {
+      return true;
+    }
 
-      if (childNode->NodeName == L"CustomFrameField")
+    // The content follows the extended header, which states its own size
+    size_t contentOffset(0);
+    if (this->m_HeaderVersion >= IGTL_HEADER_VERSION_2)
+    {
+      if (receivedBodySize < sizeof(igtl_extended_header))
       {
-        auto name = dynamic_cast<Platform::String^>(childNode->Attributes->GetNamedItem(L"Name")->NodeValue);
-        auto value = dynamic_cast<Platform::String^>(childNode->Attributes->GetNamedItem(L"Value")->NodeValue);
-        this->SetMetaDataElement(std::string(begin(name), end(name)), IANA_TYPE_US_ASCII, std::string(begin(value), end(value)));
+        return false;
       }
+      contentOffset = ReadUInt16(this->m_Body);
     }
 
-    // Convert custom frame fields storing transforms, to transform entries
-    //    We do this in a second loop so that status' are available as well
-    for (auto iter = m_MetaDataMap.begin(); iter != m_MetaDataMap.end();)
+    TrackedFrameHeader header;
+    if (receivedBodySize < contentOffset + header.GetMessageHeaderSize())
+    {
+      return false;
+    }
+    memcpy(&header, this->m_Body + contentOffset, header.GetMessageHeaderSize());
+    header.ConvertEndianness();
+    // The xml size comes from the peer, compare without adding so that it cannot wrap a 32 bit size_t
+    if (header.m_XmlDataSizeInBytes > receivedBodySize - contentOffset - header.GetMessageHeaderSize())
     {
-      auto name = std::wstring(iter->first.begin(), iter->first.end());
-      auto value = std::wstring(iter->second.second.begin(), iter->second.second.end());
-      if (UWPOpenIGTLink::TrackedFrame::IsTransform(name))
+      return false;
+    }
+
+    this->m_frameDescriptionUnpacked = ParseFrameDescription(this->m_Body + contentOffset, receivedBodySize - contentOffset);
+    return this->m_frameDescriptionUnpacked;
+  }
+
+  //----------------------------------------------------------------------------
+  bool TrackedFrameMessage::ParseFrameDescription(const byte* content, size_t availableSize)
+  {
+    // The header is left in network order in the body, the frame description may be parsed before the body is complete
+    TrackedFrameHeader header;
+    if (availableSize < header.GetMessageHeaderSize())
+    {
+      return false;
+    }
+    memcpy(&header, content, header.GetMessageHeaderSize());
+    header.ConvertEndianness();
+
+    // Copy header
+    this->m_messageHeader.m_ScalarType = header.m_ScalarType;
+    this->m_messageHeader.m_NumberOfComponents = header.m_NumberOfComponents;
+    this->m_messageHeader.m_ImageType = header.m_ImageType;
+    this->m_messageHeader.m_FrameSize[0] = header.m_FrameSize[0];
+    this->m_messageHeader.m_FrameSize[1] = header.m_FrameSize[1];
+    this->m_messageHeader.m_FrameSize[2] = header.m_FrameSize[2];
+    this->m_messageHeader.m_ImageDataSizeInBytes = header.m_ImageDataSizeInBytes;
+    this->m_messageHeader.m_XmlDataSizeInBytes = header.m_XmlDataSizeInBytes;
+    this->m_messageHeader.m_ImageOrientation = header.m_ImageOrientation;
+    memcpy(this->m_messageHeader.m_EmbeddedImageTransform, header.m_EmbeddedImageTransform, sizeof(igtl::Matrix4x4));
+
+    // The declared image size must describe the declared frame exactly, otherwise the frame would be read past its end
+    if (header.m_ImageDataSizeInBytes > 0)
+    {
+      const UWPOpenIGTLink::FrameSize frameSize = { header.m_FrameSize[0], header.m_FrameSize[1], header.m_FrameSize[2] };
+      uint64 expectedSize(0);
+      if (!UWPOpenIGTLink::Image::ComputeImageSizeBytes(frameSize, header.m_NumberOfComponents, static_cast<UWPOpenIGTLink::IGTL_SCALAR_TYPE>(header.m_ScalarType), expectedSize) ||
+          expectedSize != header.m_ImageDataSizeInBytes)
       {
-        auto entry = ref new UWPOpenIGTLink::Transform();
+        return false;
+      }
+    }
+
+    // The xml size comes from the peer, compare without adding so that it cannot wrap a 32 bit size_t
+    const size_t contentOffset = static_cast<size_t>(content - this->m_Body);
+    if (header.m_XmlDataSizeInBytes > availableSize - header.GetMessageHeaderSize() || contentOffset > this->GetBufferBodySize() ||
+        header.GetMessageHeaderSize() + header.m_XmlDataSizeInBytes > this->GetBufferBodySize() - contentOffset)
+    {
+      return false;
+    }
+
+    // Index the xml in place, fields are only decoded when they are read
+    auto xmlData = std::shared_ptr<const char>(std::shared_ptr<void>(), reinterpret_cast<const char*>(content + header.GetMessageHeaderSize()));
+    this->m_frameFields = std::make_shared<UWPOpenIGTLink::FrameFieldTable>();
+    if (!this->m_frameFields->Parse(xmlData, header.m_XmlDataSizeInBytes))
+    {
+      this->m_frameFields = nullptr;
+      return false;
+    }
+    auto& frameDescription = *this->m_frameFields;
+
+    igtl::TimeStamp::Pointer ts = igtl::TimeStamp::New();
+    this->GetTimeStamp(ts);
+    this->m_timestamp = ts->GetTimeStamp();
+
+    std::string imageDataValid;
+    this->m_imageValid = frameDescription.GetRootAttribute("ImageDataValid", imageDataValid) && imageDataValid == "true";
 
-        std::wistringstream wiss(value);
-        float transform[16];
-        for (int i = 0; i < 16; ++i)
+    // Image data may be compressed, the header always holds the uncompressed size
+    // The compressed size comes from the peer, it must fit in the body that follows the xml (the body may still be arriving, its size is known)
+    const size_t bodyImageSpace = this->GetBufferBodySize() - contentOffset - header.GetMessageHeaderSize() - header.m_XmlDataSizeInBytes;
+    size_t imagePayloadSize = header.m_ImageDataSizeInBytes;
+    this->m_imageCompressed = false;
+    std::string compression;
+    if (frameDescription.GetRootAttribute("ImageCompression", compression))
+    {
+      uint32 compressedSize(0);
+      if (!UWPOpenIGTLink::IsEqualInsensitive(compression, UWPOpenIGTLink::IMAGE_COMPRESSION_LZ4) ||
+          !GetUInt32Attribute(frameDescription, "CompressedImageSize", compressedSize) || compressedSize > bodyImageSpace)
+      {
+        return false;
+      }
+      this->m_imageCompressed = true;
+      imagePayloadSize = compressedSize;
+    }
+
+    // Image data may be part of a delta encoded stream, only key frames hold the full image
+    uint32 deltaFrameNumber(0);
+    this->m_imageDeltaEncoded = GetUInt32Attribute(frameDescription, "DeltaFrameNumber", deltaFrameNumber);
+    this->m_deltaFrameNumber = deltaFrameNumber;
+    this->m_deltaKeyFrame = false;
+    this->m_deltaResidualSize = 0;
+    if (this->m_imageDeltaEncoded)
+    {
+      std::string keyFrame;
+      this->m_deltaKeyFrame = frameDescription.GetRootAttribute("DeltaKeyFrame", keyFrame) && keyFrame == "true";
+      if (!this->m_deltaKeyFrame)
+      {
+        // The size comes from the peer, it is bounded before anything is allocated from it
+        uint32 residualSize(0);
+        if (!GetUInt32Attribute(frameDescription, "DeltaImageSize", residualSize) || residualSize > UWPOpenIGTLink::DeltaEncodeBound(header.m_ImageDataSizeInBytes))
         {
-          wiss >> transform[i];
+          return false;
         }
-        DirectX::XMFLOAT4X4 matdx(transform);
-        float4x4 result;
-        XMStoreFloat4x4(&result, XMLoadFloat4x4(&matdx));
-        entry->Matrix = result;
-
-        entry->Name = ref new UWPOpenIGTLink::TransformName(ref new Platform::String(name.c_str()));
+        this->m_deltaResidualSize = residualSize;
+        if (!this->m_imageCompressed)
+        {
+          imagePayloadSize = residualSize;
+        }
+      }
+    }
+    this->m_imagePayloadSize = imagePayloadSize;
 
-        auto statusStr = iter->first;
-        statusStr.append("Status");
-        entry->Valid = UWPOpenIGTLink::IsEqualInsensitive(m_MetaDataMap[statusStr].second, "OK");
+    // Convert custom frame fields storing transforms to transform entries, the other fields stay in the table until they are read
+    this->m_frameTransforms.clear();
+    for (size_t i = 0; i < frameDescription.GetFieldCount(); ++i)
+    {
+      if (!frameDescription.IsTransformField(i))
+      {
+        continue;
+      }
 
-        m_frameTransforms.push_back(entry);
-        iter = m_MetaDataMap.erase(iter);
+      auto fieldName = frameDescription.GetFieldName(i);
+      auto name = std::wstring(fieldName.begin(), fieldName.end());
+      if (!UWPOpenIGTLink::TrackedFrame::IsTransform(name))
+      {
+        continue;
       }
-      else
+
+      auto entry = ref new UWPOpenIGTLink::Transform();
+
+      float4x4 result(float4x4::identity());
+      UWPOpenIGTLink::ParseMatrix(frameDescription.GetFieldValue(i), result);
+      entry->Matrix = result;
+
+      entry->Name = ref new UWPOpenIGTLink::TransformName(ref new Platform::String(name.c_str()));
+
+      auto statusIndex = frameDescription.FindField(fieldName + "Status");
+      entry->Valid = statusIndex < frameDescription.GetFieldCount() && UWPOpenIGTLink::IsEqualInsensitive(frameDescription.GetFieldValue(statusIndex), "OK");
+
+      m_frameTransforms.push_back(entry);
+    }
+
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  int TrackedFrameMessage::UnpackContent()
+  {
+    size_t contentSize = this->GetBufferBodySize() - (this->m_Content - this->m_Body);
+
+    // The frame description may already have been parsed while the body was being received
+    bool descriptionUnpacked = this->m_frameDescriptionUnpacked;
+    this->m_frameDescriptionUnpacked = false;
+    if (!descriptionUnpacked && !ParseFrameDescription(this->m_Content, contentSize))
+    {
+      return 0;
+    }
+
+    const size_t imagePayloadSize = this->m_imagePayloadSize;
+    const size_t imageOffset = this->m_messageHeader.GetMessageHeaderSize() + this->m_messageHeader.m_XmlDataSizeInBytes;
+    if (imageOffset > contentSize)
+    {
+      return 0;
+    }
+
+    // Transforms sent in the binary block follow the image data
+    uint32 blockSize(0);
+    if (GetUInt32Attribute(*this->m_frameFields, "TransformBlockSize", blockSize))
+    {
+      if (imagePayloadSize > contentSize - imageOffset || blockSize > contentSize - imageOffset - imagePayloadSize ||
+          !DecodeTransformBlock(this->m_Content + imageOffset + imagePayloadSize, blockSize))
       {
-        ++iter;
+        return 0;
       }
     }
 
-    // Remove all status fields
-    for (auto iter = m_MetaDataMap.begin(); iter != m_MetaDataMap.end();)
+    this->m_image = nullptr;
+    this->m_imageOffset = 0;
+    this->m_imageAlias.reset();
+    this->m_deltaResidual.clear();
+    this->m_deltaResidualOffset = 0;
+    if (this->m_imageValid && imagePayloadSize > contentSize - imageOffset)
+    {
+      return 0;
+    }
+
+    if (this->m_imageValid && this->m_imageDeltaEncoded && !this->m_deltaKeyFrame)
     {
-      auto name = std::wstring(iter->first.begin(), iter->first.end());
-      if (UWPOpenIGTLink::TrackedFrame::IsTransformStatus(name))
+      // The residual is decoded against the stream's reference frame by DecodeImageDelta
+      if (this->m_imageCompressed)
       {
-        iter = m_MetaDataMap.erase(iter);
+        this->m_deltaResidual.resize(this->m_deltaResidualSize);
+        if (!UWPOpenIGTLink::LZ4Decompress(this->m_Content + imageOffset, imagePayloadSize, this->m_deltaResidual.data(), this->m_deltaResidualSize))
+        {
+          return 0;
+        }
       }
       else
       {
-        ++iter;
+        this->m_deltaResidualOffset = imageOffset;
       }
     }
+    else if (this->m_imageValid && this->m_imageCompressed)
+    {
+      // Compressed images are decoded straight into the image buffer
+      this->m_image = UWPOpenIGTLink::ImageBufferPool::GetInstance()->Acquire(this->m_messageHeader.m_ImageDataSizeInBytes);
+      if (this->m_image == nullptr || !UWPOpenIGTLink::LZ4Decompress(this->m_Content + imageOffset, imagePayloadSize, this->m_image.get(), this->m_messageHeader.m_ImageDataSizeInBytes))
+      {
+        this->m_image = nullptr;
+        return 0;
+      }
+    }
+    else if (this->m_imageValid)
+    {
+      // The image is not copied out of the body, GetImage returns a reference counted view of it
+      this->m_imageOffset = imageOffset;
+    }
 
     return 1;
   }
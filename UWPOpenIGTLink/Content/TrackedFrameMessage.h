@@ -27,14 +27,19 @@ OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 // Local includes
+#include "FrameFieldTable.h"
 #include "IGTCommon.h"
+#include "ImageCodec.h"
+#include "ImagePyramid.h"
 #include "TrackedFrame.h"
 
 // OS includes
 #include <Windows.h>
 
 // STD includes
+#include <mutex>
 #include <string>
+#include <vector>
 
 // IGTL includes
 #include <igtl_types.h>
@@ -73,7 +78,15 @@ namespace igtl
     virtual igtl::MessageBase::Pointer Clone();
 
     /// Accessors to the various parts of the message and message header
+    /*!
+      Returns the image pixels. For a received message the returned pointer aliases the message body,
+      no copy is made and the message is kept alive for as long as the returned pointer is referenced.
+      All pointers returned while one is still referenced share ownership, so Image copy-on-write sees every user of the pixels.
+      Do not re-use (InitBuffer/AllocateBuffer) a message whose image is still referenced.
+    */
     std::shared_ptr<byte> GetImage();
+    /// Custom frame fields of a received message, indexed but not decoded. The table keeps the message alive, same as GetImage.
+    std::shared_ptr<UWPOpenIGTLink::FrameFieldTable> GetFrameFields();
     UWPOpenIGTLink::US_IMAGE_TYPE GetImageType();
     igtl_uint16* GetFrameSize();
     igtl_uint16 GetNumberOfComponents();
@@ -91,6 +104,99 @@ namespace igtl
     void SetFrameTransforms(const UWPOpenIGTLink::TransformListInternal& transforms);
     void ApplyTransformUnitScaling(float scalingFactor);
 
+    /*!
+      Set the image to pack, the pixels are referenced (not copied) until the message is packed.
+      Returns false if an extent exceeds 65535 or the image exceeds 4 GB, which the message header cannot describe. The message then
+      has no image, so a failed call is never packed with the pixels of an earlier one.
+    */
+    bool SetImage(std::shared_ptr<byte> imageData, const UWPOpenIGTLink::FrameSize& frameSize, igtl_uint16 numberOfComponents, UWPOpenIGTLink::IGTL_SCALAR_TYPE scalarType,
+                  UWPOpenIGTLink::US_IMAGE_TYPE imageType, UWPOpenIGTLink::US_IMAGE_ORIENTATION imageOrientation);
+
+    /*!
+      Pack the frame transforms into a binary block appended to the body instead of as XML text fields.
+      The block holds the top three rows of each matrix, a frame with any non affine transform is still sent as text fields.
+      Only enable this if the receiver advertised CAPABILITY_BINARY_TRANSFORMS, otherwise the transforms will be lost.
+      Unpacking handles both forms regardless of this setting.
+    */
+    void SetBinaryTransformsEnabled(bool enabled);
+    bool GetBinaryTransformsEnabled() const;
+
+    /*!
+      Compress the image losslessly (LZ4 block format) when packing. The raw image is sent if it does not compress.
+      Only enable this if the receiver advertised CAPABILITY_LZ4_IMAGE. Unpacking handles both forms regardless of this setting.
+    */
+    void SetImageCompressionEnabled(bool enabled);
+    bool GetImageCompressionEnabled() const;
+
+    /*!
+      Send the image as part of a delta encoded stream, a key frame every state->KeyFrameInterval frames and the XOR residual
+      against the previous frame otherwise. Packing only reads the state, which belongs to the stream and is advanced by CommitImageDelta
+      once the message has been sent, so a message may be sized and packed any number of times. Only enable this if the receiver advertised CAPABILITY_DELTA_IMAGE.
+    */
+    void SetImageDeltaStream(std::shared_ptr<UWPOpenIGTLink::DeltaStreamState> state);
+    /// Advance the delta stream to the image of this packed message once it has been sent, or reset the stream so the next frame is a key frame if the send failed
+    void CommitImageDelta(bool sent);
+    /// True if the received image is part of a delta encoded stream, DecodeImageDelta must be called before GetImage
+    bool IsImageDeltaEncoded() const;
+    /// Rebuild the received image from the stream's reference frame and advance the stream. If the reference is missing the image is invalidated and false is returned.
+    bool DecodeImageDelta(UWPOpenIGTLink::DeltaStreamState& state);
+
+    /// Number of bytes of image data in the body, after compression and delta encoding
+    size_t GetImagePayloadSize() const;
+
+    /// Downsampled levels of the received image, generated by the receiver once the image is decoded
+    void SetImagePyramid(std::shared_ptr<const UWPOpenIGTLink::ImagePyramid> pyramid);
+    std::shared_ptr<const UWPOpenIGTLink::ImagePyramid> GetImagePyramid() const;
+
+    /// Replace the received image by a processed image of the same size and type, e.g. filtered by the receiver. Delta stream references keep the original.
+    void ReplaceImage(std::shared_ptr<byte> image);
+    /// Remove the received image (and its pyramid), e.g. a duplicate dropped by the receiver. Transforms and fields are kept.
+    void DropImage();
+
+    /// Content hash of the received image (see UWPOpenIGTLink::HashBytes) and whether it repeats the previous image of the device, set by the receiver
+    void SetImageContentHash(igtl_uint64 hash, bool duplicate);
+    igtl_uint64 GetImageContentHash() const;
+    bool IsImageDuplicate() const;
+
+    /// Metadata key holding the comma separated list of optional TRACKEDFRAME features the sender of a message can receive
+    static const char* CAPABILITIES_METADATA_KEY;
+    /// Capability token, transforms may be sent in the binary transform block
+    static const char* CAPABILITY_BINARY_TRANSFORMS;
+    /// Capability token, image payloads may be LZ4 compressed
+    static const char* CAPABILITY_LZ4_IMAGE;
+    /// Capability token, images may be sent as a delta encoded stream
+    static const char* CAPABILITY_DELTA_IMAGE;
+
+    /// Returns true if the sender of message listed capability in its capabilities metadata
+    static bool IsCapabilityAdvertised(igtl::MessageBase* message, const std::string& capability);
+    /// Returns true if capability is an entry of the comma separated capabilities list
+    static bool IsCapabilityListed(const std::string& capabilities, const std::string& capability);
+    /// Add capability to the capabilities metadata of message (header version 2+), call before packing
+    static void AdvertiseCapability(igtl::MessageBase* message, const std::string& capability);
+
+    /// A contiguous run of bytes of a packed message, the data is kept alive by the segment
+    struct PackedSegment
+    {
+      std::shared_ptr<byte> Data;
+      size_t                Length;
+    };
+
+    /*!
+      Pack the message as an ordered list of segments instead of a single contiguous buffer.
+      Header, extended header and XML share one small staging segment, the image segment references the
+      pixels set by SetImage without copying them. The CRC is computed incrementally across the segments.
+      Sending the segments in order is equivalent to sending the buffer produced by Pack().
+    */
+    bool PackSegments(std::vector<PackedSegment>& outSegments);
+
+    /*!
+      Parse the frame header and xml of a received body, receivedBodySize bytes of the body buffer are valid (the body may be incomplete).
+      Returns true once the frame description is available. Unpack then only has to locate the image and transform block.
+      The receiver calls it after each chunk of the body, so the xml is parsed while the image is still arriving.
+      Do not call this while holding a socket lock, the xml is parsed and the transforms are allocated here.
+    */
+    bool UnpackFrameDescription(size_t receivedBodySize);
+
   protected:
     class TrackedFrameHeader
     {
@@ -115,12 +221,46 @@ namespace igtl
     virtual int                             PackContent();
     virtual int                             UnpackContent();
 
+    /// Parse the frame header and xml at the start of content, availableSize bytes of which are valid
+    bool ParseFrameDescription(const byte* content, size_t availableSize);
+
+    /// Build the XML (and binary transform block, if enabled) describing the frame, prior to packing
+    void GenerateFrameDescription();
+    /// Encode/decode the binary transform block
+    void EncodeTransformBlock(std::vector<byte>& block) const;
+    bool DecodeTransformBlock(const byte* block, size_t blockSize);
+    /// Image data as it is written to the body
+    const byte* GetImagePayload() const;
+
     TrackedFrameMessage();
     ~TrackedFrameMessage();
 
     FrameTransformList                      m_frameTransforms;
     std::shared_ptr<byte>                   m_image = nullptr;
+    size_t                                  m_imageOffset = 0; // offset of the received pixel data from m_Content
+    std::weak_ptr<byte>                     m_imageAlias; // pointer handed out by GetImage, weak since it owns this message
+    std::mutex                              m_imageAliasMutex;
     std::string                             m_trackedFrameXmlData;
+    std::shared_ptr<UWPOpenIGTLink::FrameFieldTable> m_frameFields = nullptr; // does not own the xml, that would keep this message alive forever
+    std::vector<byte>                       m_transformBlock;
+    bool                                    m_binaryTransformsEnabled = false;
+    std::vector<byte>                       m_compressedImage;
+    bool                                    m_imageCompressionEnabled = false;
+    bool                                    m_imageCompressed = false;
+    size_t                                  m_imagePayloadSize = 0;
+    std::shared_ptr<const UWPOpenIGTLink::ImagePyramid> m_imagePyramid = nullptr;
+    bool                                    m_frameDescriptionUnpacked = false;
+    igtl_uint64                             m_imageContentHash = 0;
+    bool                                    m_imageDuplicate = false;
+
+    // Delta encoded image stream
+    std::shared_ptr<UWPOpenIGTLink::DeltaStreamState> m_deltaStream = nullptr;
+    std::vector<byte>                       m_deltaResidual;
+    size_t                                  m_deltaResidualOffset = 0; // offset of an uncompressed received residual from m_Content
+    size_t                                  m_deltaResidualSize = 0;
+    bool                                    m_imageDeltaEncoded = false;
+    bool                                    m_deltaKeyFrame = false;
+    uint32                                  m_deltaFrameNumber = 0;
     bool                                    m_imageValid = false;
     double                                  m_timestamp = 0.0;
 
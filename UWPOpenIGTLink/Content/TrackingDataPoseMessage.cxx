@@ -0,0 +1,157 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+// Local includes
+#include "pch.h"
+#include "TrackingDataPoseMessage.h"
+
+// IGT includes
+#include <igtlutil/igtl_tdata.h>
+#include <igtlutil/igtl_util.h>
+
+// STL includes
+#include <cstring>
+
+#if defined(_M_IX86) || defined(_M_X64)
+  #include <emmintrin.h>
+#endif
+
+using namespace Windows::Foundation::Numerics;
+
+namespace
+{
+  static const size_t ELEMENT_NAME_SIZE = IGTL_TDATA_LEN_NAME;
+  static const size_t ELEMENT_TRANSFORM_OFFSET = IGTL_TDATA_LEN_NAME + 2; // name, type, reserved
+
+  //----------------------------------------------------------------------------
+  /// Read the 12 big-endian float32 of an element (column-major 3x4) into host order
+  inline void LoadTransform(const unsigned char* source, float values[12])
+  {
+#if defined(_M_IX86) || defined(_M_X64)
+    if (igtl_is_little_endian())
+    {
+      for (int i = 0; i < 3; ++i)
+      {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source) + i);
+        // Swap the bytes of each 16 bit half, then the halves of each 32 bit lane
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(values) + i, v);
+      }
+      return;
+    }
+#endif
+    memcpy(values, source, sizeof(float) * 12);
+    if (igtl_is_little_endian())
+    {
+      igtl_uint32* words = reinterpret_cast<igtl_uint32*>(values);
+      for (int i = 0; i < 12; ++i)
+      {
+        words[i] = BYTE_SWAP_INT32(words[i]);
+      }
+    }
+  }
+}
+
+namespace igtl
+{
+  //----------------------------------------------------------------------------
+  TrackingDataPoseMessage::TrackingDataPoseMessage()
+    : TrackingDataMessage()
+  {
+  }
+
+  //----------------------------------------------------------------------------
+  TrackingDataPoseMessage::~TrackingDataPoseMessage()
+  {
+  }
+
+  //----------------------------------------------------------------------------
+  void TrackingDataPoseMessage::SetTranslationScale(float scale)
+  {
+    m_translationScale = scale;
+  }
+
+  //----------------------------------------------------------------------------
+  float TrackingDataPoseMessage::GetTranslationScale() const
+  {
+    return m_translationScale;
+  }
+
+  //----------------------------------------------------------------------------
+  size_t TrackingDataPoseMessage::GetNumberOfPoses() const
+  {
+    return m_poses.size();
+  }
+
+  //----------------------------------------------------------------------------
+  const std::string& TrackingDataPoseMessage::GetPoseName(size_t index) const
+  {
+    return m_poseNames[index];
+  }
+
+  //----------------------------------------------------------------------------
+  const float4x4& TrackingDataPoseMessage::GetPose(size_t index) const
+  {
+    return m_poses[index];
+  }
+
+  //----------------------------------------------------------------------------
+  int TrackingDataPoseMessage::UnpackContent()
+  {
+    const size_t elementCount = static_cast<size_t>(this->CalculateReceiveContentSize()) / IGTL_TDATA_ELEMENT_SIZE;
+    const unsigned char* element = reinterpret_cast<const unsigned char*>(this->m_Content);
+
+    m_poseNames.resize(elementCount);
+    m_poses.resize(elementCount);
+
+    float values[12];
+    for (size_t i = 0; i < elementCount; ++i, element += IGTL_TDATA_ELEMENT_SIZE)
+    {
+      m_poseNames[i].assign(reinterpret_cast<const char*>(element), strnlen(reinterpret_cast<const char*>(element), ELEMENT_NAME_SIZE));
+
+      // Wire order is R11 R21 R31 R12 R22 R32 R13 R23 R33 TX TY TZ, poses are row-major with the translation in m14, m24, m34
+      LoadTransform(element + ELEMENT_TRANSFORM_OFFSET, values);
+      float4x4& pose = m_poses[i];
+      pose.m11 = values[0];
+      pose.m12 = values[3];
+      pose.m13 = values[6];
+      pose.m14 = values[9] * m_translationScale;
+      pose.m21 = values[1];
+      pose.m22 = values[4];
+      pose.m23 = values[7];
+      pose.m24 = values[10] * m_translationScale;
+      pose.m31 = values[2];
+      pose.m32 = values[5];
+      pose.m33 = values[8];
+      pose.m34 = values[11] * m_translationScale;
+      pose.m41 = 0.f;
+      pose.m42 = 0.f;
+      pose.m43 = 0.f;
+      pose.m44 = 1.f;
+    }
+
+    return 1;
+  }
+}
@@ -0,0 +1,72 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+#pragma once
+
+// IGT includes
+#include <igtlTrackingDataMessage.h>
+
+// STL includes
+#include <string>
+#include <vector>
+
+// Windows includes
+#include <WindowsNumerics.h>
+
+namespace igtl
+{
+  ///  TrackingDataPoseMessage - TDATA message that decodes its elements straight to row-major poses
+  ///  Unpacking byte swaps, scales the translation and lays out each element as a float4x4 in a single pass,
+  ///  the elements of the TrackingDataMessage superclass are not populated on receive.
+  class TrackingDataPoseMessage : public TrackingDataMessage
+  {
+  public:
+    typedef TrackingDataPoseMessage                   Self;
+    typedef TrackingDataMessage                       Superclass;
+    typedef SmartPointer<Self>                        Pointer;
+    typedef SmartPointer<const Self>                  ConstPointer;
+
+    igtlTypeMacro(igtl::TrackingDataPoseMessage, igtl::TrackingDataMessage);
+    igtlNewMacro(igtl::TrackingDataPoseMessage);
+
+  public:
+    /// Scale applied to the translation of every pose when unpacking, set before Unpack
+    void SetTranslationScale(float scale);
+    float GetTranslationScale() const;
+
+    /// Decoded poses, in element order
+    size_t GetNumberOfPoses() const;
+    const std::string& GetPoseName(size_t index) const;
+    const Windows::Foundation::Numerics::float4x4& GetPose(size_t index) const;
+
+  protected:
+    TrackingDataPoseMessage();
+    ~TrackingDataPoseMessage();
+
+    virtual int UnpackContent();
+
+    float                                                   m_translationScale = 1.f;
+    std::vector<std::string>                                m_poseNames;
+    std::vector<Windows::Foundation::Numerics::float4x4>    m_poses;
+  };
+}
@@ -23,6 +23,8 @@ OTHER DEALINGS IN THE SOFTWARE.
 
 // Local includes
 #include "pch.h"
+#include "ImageBufferPool.h"
+#include "Reorientation.h"
 #include "VideoFrame.h"
 
 // DirectX includes
@@ -80,6 +82,50 @@ namespace UWPOpenIGTLink
     return true;
   }
 
+  //----------------------------------------------------------------------------
+  bool VideoFrame::Reorient(int usImageOrientation, bool inPlace)
+  {
+    if (!HasImage() || m_image->GetImageDataInternal() == nullptr)
+    {
+      OutputDebugStringA("Unable to reorient image, image data is NULL.");
+      return false;
+    }
+
+    ReorientationAxes axes;
+    if (!GetReorientationAxes(m_imageOrientation, (US_IMAGE_ORIENTATION)usImageOrientation, axes))
+    {
+      OutputDebugStringA("Unable to reorient image, undefined orientation.");
+      return false;
+    }
+
+    // Shared pixels are reoriented into a new buffer rather than copied first and then reoriented in place
+    const bool outOfPlace = !inPlace || axes.Transpose || m_image->IsImageDataShared();
+    const FrameSize frameSize = GetDimensions();
+    // In place the pixels are not shared, taking the mutable pointer before the source keeps it from copying them
+    std::shared_ptr<byte> destination = outOfPlace ? ImageBufferPool::GetInstance()->Acquire(static_cast<size_t>(m_image->GetImageSizeBytes())) : m_image->GetMutableImageDataInternal();
+    std::shared_ptr<const byte> source = m_image->GetImageDataInternal();
+
+    if (!ReorientPixels(source.get(), destination.get(), frameSize, GetNumberOfBytesPerPixel(), axes))
+    {
+      OutputDebugStringA("Unable to reorient image, unsupported pixel size.");
+      return false;
+    }
+
+    if (outOfPlace)
+    {
+      auto image = ref new UWPOpenIGTLink::Image();
+      image->SetImageData(destination, m_image->NumberOfScalarComponents, (IGTL_SCALAR_TYPE)m_image->ScalarType, GetReorientedFrameSize(frameSize, axes));
+      image->Timestamp = m_image->Timestamp;
+      m_image = image;
+    }
+
+    // The embedded transform maps the pixel coordinates of the new orientation
+    m_embeddedImageTransform = m_embeddedImageTransform * GetReorientationMatrix(frameSize, axes);
+    m_imageOrientation = (US_IMAGE_ORIENTATION)usImageOrientation;
+
+    return true;
+  }
+
   //----------------------------------------------------------------------------
   uint32 VideoFrame::GetPixelFormat(bool normalized)
   {
@@ -124,6 +170,13 @@ namespace UWPOpenIGTLink
       return true;
     }
 
+    uint64 sizeBytes(0);
+    if (!UWPOpenIGTLink::Image::ComputeImageSizeBytes(nonConstFrameSize, numberOfScalarComponents, (IGTL_SCALAR_TYPE)scalarType, sizeBytes))
+    {
+      OutputDebugStringA("Unable to allocate frame, the image size overflows.");
+      return false;
+    }
+
     m_image->AllocateScalars(nonConstFrameSize, numberOfScalarComponents, (IGTL_SCALAR_TYPE)scalarType);
 
     return true;
@@ -430,7 +483,7 @@ namespace UWPOpenIGTLink
   }
 
   //----------------------------------------------------------------------------
-  std::shared_ptr<byte> VideoFrame::GetImageDataInternal()
+  std::shared_ptr<const byte> VideoFrame::GetImageDataInternal()
   {
     if (!HasImage())
     {
@@ -472,6 +525,7 @@ namespace UWPOpenIGTLink
         PIXEL_TO_STRING(IGTL_SCALARTYPE_UINT32);
         PIXEL_TO_STRING(IGTL_SCALARTYPE_FLOAT32);
         PIXEL_TO_STRING(IGTL_SCALARTYPE_FLOAT64);
+        PIXEL_TO_STRING(IGTL_SCALARTYPE_FLOAT16);
         PIXEL_TO_STRING(IGTL_SCALARTYPE_COMPLEX);
       default:
         return L"IGTL_SCALARTYPE_UNKNOWN";
@@ -53,6 +53,13 @@ namespace UWPOpenIGTLink
     bool AllocateFrame(const FrameSizeABI^ imageSize, int scalarType, uint16 numberOfScalarComponents);
     bool FillBlank();
 
+    /*!
+      Reorder the pixels to usImageOrientation and update the embedded image transform to match.
+      Flips are done in place if inPlace is true, which modifies every frame holding this image (e.g. after ShallowCopy).
+      Otherwise, for orientations that transpose the image and for pixels shared with copies of the image, the result is written to a new image.
+    */
+    bool Reorient(int usImageOrientation, bool inPlace);
+
     // Accessors
     int GetScalarPixelType();
 
@@ -87,7 +94,7 @@ namespace UWPOpenIGTLink
     bool AllocateFrame(const FrameSize& imageSize, int scalarType, uint16 numberOfScalarComponents);
     void SetImageData(std::shared_ptr<byte> imageData, uint16 numberOfScalarComponents, IGTL_SCALAR_TYPE scalarType, const FrameSize& imageSize);
 
-    std::shared_ptr<byte> GetImageDataInternal();
+    std::shared_ptr<const byte> GetImageDataInternal();
     bool IsImageValidInternal() const;
     FrameSize GetDimensions() const;
 
@@ -0,0 +1,233 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+// Local includes
+#include "pch.h"
+#include "Image.h"
+#include "ImageBufferPool.h"
+#include "VolumeView.h"
+
+// STL includes
+#include <utility>
+
+namespace UWPOpenIGTLink
+{
+  //----------------------------------------------------------------------------
+  VolumeView::VolumeView()
+  {
+    m_extent.fill(0);
+    m_strides.fill(0);
+  }
+
+  //----------------------------------------------------------------------------
+  VolumeView::VolumeView(Image^ image)
+    : VolumeView()
+  {
+    if (image != nullptr)
+    {
+      // Views are only written by the mutable visitors, which detach the image's pixels before building the view
+      *this = VolumeView(std::const_pointer_cast<byte>(image->GetImageDataInternal()), image->GetFrameSize(), image->NumberOfScalarComponents, (IGTL_SCALAR_TYPE)image->ScalarType);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  VolumeView::VolumeView(std::shared_ptr<byte> data, const FrameSize& size, uint16 numberOfScalarComponents, IGTL_SCALAR_TYPE scalarType)
+    : VolumeView()
+  {
+    m_bytesPerPixel = Image::GetNumberOfBytesPerScalar(scalarType) * numberOfScalarComponents;
+    uint64 sizeBytes(0);
+    if (data == nullptr || m_bytesPerPixel == 0 || !Image::ComputeImageSizeBytes(size, numberOfScalarComponents, scalarType, sizeBytes))
+    {
+      return;
+    }
+
+    m_origin = data;
+    m_numberOfScalarComponents = numberOfScalarComponents;
+    m_scalarType = scalarType;
+    m_extent = { size[0], size[1], size[2] };
+    m_strides[0] = static_cast<ptrdiff_t>(m_bytesPerPixel);
+    m_strides[1] = m_strides[0] * static_cast<ptrdiff_t>(size[0]);
+    m_strides[2] = m_strides[1] * static_cast<ptrdiff_t>(size[1]);
+  }
+
+  //----------------------------------------------------------------------------
+  bool VolumeView::IsValid() const
+  {
+    return m_origin != nullptr;
+  }
+
+  //----------------------------------------------------------------------------
+  bool VolumeView::IsContiguous() const
+  {
+    return IsValid() &&
+           m_strides[0] == static_cast<ptrdiff_t>(m_bytesPerPixel) &&
+           (m_extent[1] <= 1 || m_strides[1] == m_strides[0] * static_cast<ptrdiff_t>(m_extent[0])) &&
+           (m_extent[2] <= 1 || m_strides[2] == static_cast<ptrdiff_t>(m_bytesPerPixel * m_extent[0] * m_extent[1]));
+  }
+
+  //----------------------------------------------------------------------------
+  byte* VolumeView::GetOrigin() const
+  {
+    return m_origin.get();
+  }
+
+  //----------------------------------------------------------------------------
+  byte* VolumeView::GetPixel(size_t x, size_t y, size_t z) const
+  {
+    return m_origin.get() + static_cast<ptrdiff_t>(x) * m_strides[0] + static_cast<ptrdiff_t>(y) * m_strides[1] + static_cast<ptrdiff_t>(z) * m_strides[2];
+  }
+
+  //----------------------------------------------------------------------------
+  const VolumeView::Extent& VolumeView::GetExtent() const
+  {
+    return m_extent;
+  }
+
+  //----------------------------------------------------------------------------
+  const VolumeView::Strides& VolumeView::GetStrides() const
+  {
+    return m_strides;
+  }
+
+  //----------------------------------------------------------------------------
+  size_t VolumeView::GetNumberOfPixels() const
+  {
+    return m_extent[0] * m_extent[1] * m_extent[2];
+  }
+
+  //----------------------------------------------------------------------------
+  size_t VolumeView::GetBytesPerPixel() const
+  {
+    return m_bytesPerPixel;
+  }
+
+  //----------------------------------------------------------------------------
+  uint16 VolumeView::GetNumberOfScalarComponents() const
+  {
+    return m_numberOfScalarComponents;
+  }
+
+  //----------------------------------------------------------------------------
+  IGTL_SCALAR_TYPE VolumeView::GetScalarType() const
+  {
+    return m_scalarType;
+  }
+
+  //----------------------------------------------------------------------------
+  VolumeView VolumeView::Crop(const Extent& origin, const Extent& extent) const
+  {
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      if (extent[axis] == 0 || origin[axis] >= m_extent[axis] || extent[axis] > m_extent[axis] - origin[axis])
+      {
+        return VolumeView();
+      }
+    }
+    if (!IsValid())
+    {
+      return VolumeView();
+    }
+
+    VolumeView view(*this);
+    view.m_origin = std::shared_ptr<byte>(m_origin, GetPixel(origin[0], origin[1], origin[2]));
+    view.m_extent = extent;
+    return view;
+  }
+
+  //----------------------------------------------------------------------------
+  VolumeView VolumeView::Slice(int axis, size_t index) const
+  {
+    if (!IsValid() || axis < 0 || axis > 2 || index >= m_extent[axis])
+    {
+      return VolumeView();
+    }
+
+    Extent origin = { 0, 0, 0 };
+    origin[axis] = index;
+    Extent extent = m_extent;
+    extent[axis] = 1;
+    VolumeView view = Crop(origin, extent);
+
+    // Move the sliced axis last so the slice spans x and y
+    for (int i = axis; i < 2; ++i)
+    {
+      std::swap(view.m_extent[i], view.m_extent[i + 1]);
+      std::swap(view.m_strides[i], view.m_strides[i + 1]);
+    }
+    return view;
+  }
+
+  //----------------------------------------------------------------------------
+  bool VolumeView::CopyTo(byte* destination) const
+  {
+    if (!IsValid() || destination == nullptr)
+    {
+      return false;
+    }
+
+    if (IsContiguous())
+    {
+      memcpy(destination, GetOrigin(), GetNumberOfPixels() * m_bytesPerPixel);
+      return true;
+    }
+
+    const size_t rowSize = m_extent[0] * m_bytesPerPixel;
+    for (size_t z = 0; z < m_extent[2]; ++z)
+    {
+      for (size_t y = 0; y < m_extent[1]; ++y)
+      {
+        const byte* row = GetPixel(0, y, z);
+        if (m_strides[0] == static_cast<ptrdiff_t>(m_bytesPerPixel))
+        {
+          // Rows of a crop are contiguous
+          memcpy(destination, row, rowSize);
+          destination += rowSize;
+          continue;
+        }
+
+        // Rows of a slice across x or y gather pixels a stride apart
+        for (size_t x = 0; x < m_extent[0]; ++x, row += m_strides[0], destination += m_bytesPerPixel)
+        {
+          memcpy(destination, row, m_bytesPerPixel);
+        }
+      }
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  Image^ VolumeView::ToImage() const
+  {
+    if (!IsValid())
+    {
+      return nullptr;
+    }
+
+    auto data = ImageBufferPool::GetInstance()->Acquire(GetNumberOfPixels() * m_bytesPerPixel);
+    CopyTo(data.get());
+
+    auto image = ref new Image();
+    image->SetImageData(data, m_numberOfScalarComponents, m_scalarType, FrameSize{ static_cast<uint32>(m_extent[0]), static_cast<uint32>(m_extent[1]), static_cast<uint32>(m_extent[2]) });
+    return image;
+  }
+}
@@ -0,0 +1,85 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+#pragma once
+
+// Local includes
+#include "IGTCommon.h"
+
+// STL includes
+#include <array>
+#include <cstddef>
+#include <memory>
+
+namespace UWPOpenIGTLink
+{
+  ref class Image;
+
+  /// A strided view of the pixels of an image volume, the view shares ownership of the image's pixel buffer
+  /// Cropping and slicing return new views without touching the pixels, only CopyTo and ToImage copy (just the viewed pixels).
+  class VolumeView
+  {
+  public:
+    typedef std::array<size_t, 3>     Extent;
+    typedef std::array<ptrdiff_t, 3>  Strides;
+
+    /// An invalid view
+    VolumeView();
+    /// A view of every pixel of image
+    explicit VolumeView(Image^ image);
+    /// A view of a contiguous volume of size pixels
+    VolumeView(std::shared_ptr<byte> data, const FrameSize& size, uint16 numberOfScalarComponents, IGTL_SCALAR_TYPE scalarType);
+
+    bool IsValid() const;
+    /// True if the pixels of the view are stored in x, y, z order without gaps
+    bool IsContiguous() const;
+
+    byte* GetOrigin() const;
+    byte* GetPixel(size_t x, size_t y, size_t z) const;
+    const Extent& GetExtent() const;
+    /// Distance in bytes between neighbouring pixels along each axis
+    const Strides& GetStrides() const;
+    size_t GetNumberOfPixels() const;
+    size_t GetBytesPerPixel() const;
+    uint16 GetNumberOfScalarComponents() const;
+    IGTL_SCALAR_TYPE GetScalarType() const;
+
+    /// The sub volume of extent pixels starting at origin, an invalid view if it is not inside this view
+    VolumeView Crop(const Extent& origin, const Extent& extent) const;
+    /// The 2D view of slice index along axis (0, 1 or 2). The remaining axes keep their order, e.g. a slice along x spans (y, z).
+    VolumeView Slice(int axis, size_t index) const;
+
+    /// Copy the viewed pixels to destination (GetNumberOfPixels() * GetBytesPerPixel() bytes), contiguous in x, y, z order
+    bool CopyTo(byte* destination) const;
+    /// Copy the viewed pixels into a new image
+    Image^ ToImage() const;
+
+  protected:
+    std::shared_ptr<byte>   m_origin = nullptr; // aliases the parent buffer
+    Extent                  m_extent;
+    Strides                 m_strides;
+    uint16                  m_numberOfScalarComponents = 0;
+    IGTL_SCALAR_TYPE        m_scalarType = IGTL_SCALARTYPE_UNKNOWN;
+    size_t                  m_bytesPerPixel = 0;
+  };
+}
@@ -0,0 +1,390 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+// Local includes
+#include "pch.h"
+#include "Image.h"
+#include "NativeBuffer.h"
+#include "PixelConversion.h"
+#include "WindowLevel.h"
+
+// STL includes
+#include <cmath>
+
+// Windows includes
+#include <ppl.h>
+
+#if defined(_M_IX86) || defined(_M_X64)
+  #define WINDOW_LEVEL_X86
+  #include <emmintrin.h>
+#endif
+
+namespace UWPOpenIGTLink
+{
+  namespace
+  {
+    static const size_t LOOKUP_TABLE_ENTRIES = 256;
+    static const size_t VALUE_TABLE_ENTRIES = 65536;
+    // Pixels per band when mapping in parallel
+    static const size_t PARALLEL_BAND_SIZE = 64 * 1024;
+
+    //----------------------------------------------------------------------------
+    inline uint32 FloatToIndex(float value, float minimum, float scale)
+    {
+      value = (value - minimum) * scale;
+      // Written so NaN maps to 0, same as the vector path
+      value = value > 0.f ? (value < 65535.f ? value : 65535.f) : 0.f;
+      return static_cast<uint32>(std::lrint(value));
+    }
+
+    //----------------------------------------------------------------------------
+    template<typename OutputType>
+    void MapValues(const byte* source, size_t count, IGTL_SCALAR_TYPE scalarType, const OutputType* table, float minimum, float scale, OutputType* destination, bool useSSE2)
+    {
+      switch (scalarType)
+      {
+        case IGTL_SCALARTYPE_UINT8:
+          for (size_t i = 0; i < count; ++i)
+          {
+            destination[i] = table[source[i]];
+          }
+          break;
+        case IGTL_SCALARTYPE_UINT16:
+        case IGTL_SCALARTYPE_INT16:
+        {
+          // Signed values are offset by 2^15 to index the table
+          const uint16 offset = scalarType == IGTL_SCALARTYPE_INT16 ? 0x8000 : 0;
+          for (size_t i = 0; i < count; ++i)
+          {
+            uint16 value;
+            memcpy(&value, source + i * sizeof(uint16), sizeof(uint16));
+            destination[i] = table[value ^ offset];
+          }
+          break;
+        }
+        case IGTL_SCALARTYPE_FLOAT32:
+        {
+          const float* values = reinterpret_cast<const float*>(source);
+          size_t i = 0;
+#if defined(WINDOW_LEVEL_X86)
+          if (useSSE2)
+          {
+            const __m128 minimumVector = _mm_set1_ps(minimum);
+            const __m128 scaleVector = _mm_set1_ps(scale);
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 maximum = _mm_set1_ps(65535.f);
+            alignas(16) int32 indices[4];
+            for (; i + 4 <= count; i += 4)
+            {
+              __m128 value = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(values + i), minimumVector), scaleVector);
+              // max returns its second operand for NaN
+              value = _mm_min_ps(_mm_max_ps(value, zero), maximum);
+              _mm_store_si128(reinterpret_cast<__m128i*>(indices), _mm_cvtps_epi32(value));
+              destination[i] = table[indices[0]];
+              destination[i + 1] = table[indices[1]];
+              destination[i + 2] = table[indices[2]];
+              destination[i + 3] = table[indices[3]];
+            }
+          }
+#endif
+          for (; i < count; ++i)
+          {
+            float value;
+            memcpy(&value, values + i, sizeof(float));
+            destination[i] = table[FloatToIndex(value, minimum, scale)];
+          }
+          break;
+        }
+        default:
+          break;
+      }
+    }
+
+    //----------------------------------------------------------------------------
+    template<typename OutputType>
+    void MapBands(const byte* source, size_t pixelCount, IGTL_SCALAR_TYPE scalarType, const OutputType* table, float minimum, float scale, OutputType* destination, bool parallel)
+    {
+      const bool useSSE2 = PixelConversion::GetInstructionSetLevel() >= PIXEL_CONVERSION_ISA_SSE2;
+      const size_t bytesPerScalar = Image::GetNumberOfBytesPerScalar(scalarType);
+      const size_t bandCount = (pixelCount + PARALLEL_BAND_SIZE - 1) / PARALLEL_BAND_SIZE;
+      if (!parallel || bandCount < 2)
+      {
+        MapValues(source, pixelCount, scalarType, table, minimum, scale, destination, useSSE2);
+        return;
+      }
+
+      Concurrency::parallel_for(size_t(0), bandCount, [&](size_t band)
+      {
+        const size_t first = band * PARALLEL_BAND_SIZE;
+        const size_t count = first + PARALLEL_BAND_SIZE < pixelCount ? PARALLEL_BAND_SIZE : pixelCount - first;
+        MapValues(source + first * bytesPerScalar, count, scalarType, table, minimum, scale, destination + first, useSSE2);
+      });
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  WindowLevel::WindowLevel()
+  {
+    m_lookupTable.fill(0);
+  }
+
+  //----------------------------------------------------------------------------
+  double WindowLevel::Window::get()
+  {
+    return m_window;
+  }
+
+  //----------------------------------------------------------------------------
+  void WindowLevel::Window::set(double arg)
+  {
+    m_window = arg;
+    m_tableValid = false;
+  }
+
+  //----------------------------------------------------------------------------
+  double WindowLevel::Level::get()
+  {
+    return m_level;
+  }
+
+  //----------------------------------------------------------------------------
+  void WindowLevel::Level::set(double arg)
+  {
+    m_level = arg;
+    m_tableValid = false;
+  }
+
+  //----------------------------------------------------------------------------
+  int WindowLevel::Function::get()
+  {
+    return m_function;
+  }
+
+  //----------------------------------------------------------------------------
+  void WindowLevel::Function::set(int arg)
+  {
+    m_function = (WINDOW_FUNCTION)arg;
+    m_tableValid = false;
+  }
+
+  //----------------------------------------------------------------------------
+  Windows::Storage::Streams::IBuffer^ WindowLevel::LookupTable::get()
+  {
+    if (!m_hasLookupTable)
+    {
+      return nullptr;
+    }
+
+    std::shared_ptr<byte> entries(new byte[LOOKUP_TABLE_ENTRIES * 4], std::default_delete<byte[]>());
+    memcpy(entries.get(), m_lookupTable.data(), LOOKUP_TABLE_ENTRIES * 4);
+    return CreateNativeBuffer(entries, LOOKUP_TABLE_ENTRIES * 4);
+  }
+
+  //----------------------------------------------------------------------------
+  void WindowLevel::LookupTable::set(Windows::Storage::Streams::IBuffer^ arg)
+  {
+    m_tableValid = false;
+    m_hasLookupTable = false;
+    if (arg == nullptr || arg->Length < LOOKUP_TABLE_ENTRIES * 4)
+    {
+      return;
+    }
+
+    memcpy(m_lookupTable.data(), GetDataFromIBuffer<byte>(arg), LOOKUP_TABLE_ENTRIES * 4);
+    m_hasLookupTable = true;
+  }
+
+  //----------------------------------------------------------------------------
+  bool WindowLevel::Parallel::get()
+  {
+    return m_parallel;
+  }
+
+  //----------------------------------------------------------------------------
+  void WindowLevel::Parallel::set(bool arg)
+  {
+    m_parallel = arg;
+  }
+
+  //----------------------------------------------------------------------------
+  bool WindowLevel::MapToDisplay(Image^ image, Windows::Storage::Streams::IBuffer^ destination, bool outputBGRA)
+  {
+    if (image == nullptr || destination == nullptr || image->GetImageDataInternal() == nullptr ||
+        !IsMappingSupported(image->NumberOfScalarComponents, image->ScalarType))
+    {
+      return false;
+    }
+
+    auto frameSize = image->GetFrameSize();
+    const size_t pixelCount = static_cast<size_t>(frameSize[0]) * frameSize[1] * frameSize[2];
+    if (destination->Length < pixelCount * 4)
+    {
+      return false;
+    }
+
+    return Map(image->GetImageDataInternal().get(), pixelCount, (IGTL_SCALAR_TYPE)image->ScalarType, GetDataFromIBuffer<byte>(destination), false, outputBGRA);
+  }
+
+  //----------------------------------------------------------------------------
+  bool WindowLevel::MapSliceToDisplay(Image^ image, uint32 slice, Windows::Storage::Streams::IBuffer^ destination, bool outputBGRA)
+  {
+    return MapSlice(image, slice, destination, false, outputBGRA);
+  }
+
+  //----------------------------------------------------------------------------
+  bool WindowLevel::MapSliceToGrey(Image^ image, uint32 slice, Windows::Storage::Streams::IBuffer^ destination)
+  {
+    return MapSlice(image, slice, destination, true, false);
+  }
+
+  //----------------------------------------------------------------------------
+  bool WindowLevel::MapSlice(Image^ image, uint32 slice, Windows::Storage::Streams::IBuffer^ destination, bool grey, bool outputBGRA)
+  {
+    if (image == nullptr || destination == nullptr || image->GetImageDataInternal() == nullptr ||
+        !IsMappingSupported(image->NumberOfScalarComponents, image->ScalarType))
+    {
+      return false;
+    }
+
+    auto frameSize = image->GetFrameSize();
+    const size_t pixelCount = static_cast<size_t>(frameSize[0]) * frameSize[1];
+    if (slice >= frameSize[2] || destination->Length < pixelCount * (grey ? 1 : 4))
+    {
+      return false;
+    }
+
+    const size_t sliceOffset = static_cast<size_t>(slice) * pixelCount * Image::GetNumberOfBytesPerScalar(image->ScalarType);
+    return Map(image->GetImageDataInternal().get() + sliceOffset, pixelCount, (IGTL_SCALAR_TYPE)image->ScalarType, GetDataFromIBuffer<byte>(destination), grey, outputBGRA);
+  }
+
+  //----------------------------------------------------------------------------
+  bool WindowLevel::IsMappingSupported(uint16 numberOfScalarComponents, int scalarType)
+  {
+    return numberOfScalarComponents == 1 &&
+           (scalarType == IGTL_SCALARTYPE_UINT8 || scalarType == IGTL_SCALARTYPE_UINT16 || scalarType == IGTL_SCALARTYPE_INT16 || scalarType == IGTL_SCALARTYPE_FLOAT32);
+  }
+
+  //----------------------------------------------------------------------------
+  bool WindowLevel::Map(const byte* source, size_t pixelCount, IGTL_SCALAR_TYPE scalarType, byte* destination, bool grey, bool outputBGRA)
+  {
+    if (source == nullptr || destination == nullptr || !IsMappingSupported(1, scalarType))
+    {
+      return false;
+    }
+
+    UpdateTable(scalarType, grey, outputBGRA);
+    if (grey)
+    {
+      MapBands(source, pixelCount, scalarType, m_greyTable.data(), m_tableMinimum, m_tableScale, destination, m_parallel);
+    }
+    else
+    {
+      // Each entry is a whole pixel
+      MapBands(source, pixelCount, scalarType, m_colourTable.data(), m_tableMinimum, m_tableScale, reinterpret_cast<uint32*>(destination), m_parallel);
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  double WindowLevel::Evaluate(double value) const
+  {
+    const double window = m_window > 1e-6 ? m_window : 1e-6;
+    double result(0.0);
+    if (m_function == WINDOW_FUNCTION_SIGMOID)
+    {
+      result = 255.0 / (1.0 + std::exp(-4.0 * (value - m_level) / window));
+    }
+    else
+    {
+      result = (value - (m_level - window / 2.0)) / window * 255.0;
+    }
+    return result > 0.0 ? (result < 255.0 ? result : 255.0) : 0.0;
+  }
+
+  //----------------------------------------------------------------------------
+  void WindowLevel::UpdateTable(IGTL_SCALAR_TYPE scalarType, bool grey, bool outputBGRA)
+  {
+    if (m_tableValid && m_tableScalarType == scalarType && m_tableGrey == grey && (grey || m_tableBGRA == outputBGRA))
+    {
+      return;
+    }
+
+    // Table index to pixel value
+    size_t entries = VALUE_TABLE_ENTRIES;
+    double firstValue(0.0);
+    double step(1.0);
+    switch (scalarType)
+    {
+      case IGTL_SCALARTYPE_UINT8:
+        entries = 256;
+        break;
+      case IGTL_SCALARTYPE_INT16:
+        firstValue = -32768.0;
+        break;
+      case IGTL_SCALARTYPE_FLOAT32:
+      {
+        // The sigmoid is within rounding of 0 and 255 two windows from the level
+        const double window = m_window > 1e-6 ? m_window : 1e-6;
+        const double halfRange = m_function == WINDOW_FUNCTION_SIGMOID ? 2.0 * window : window / 2.0;
+        firstValue = m_level - halfRange;
+        step = 2.0 * halfRange / (VALUE_TABLE_ENTRIES - 1);
+        break;
+      }
+      default:
+        break;
+    }
+    m_tableMinimum = static_cast<float>(firstValue);
+    m_tableScale = static_cast<float>(1.0 / step);
+
+    m_greyTable.resize(entries);
+    for (size_t i = 0; i < entries; ++i)
+    {
+      m_greyTable[i] = static_cast<byte>(std::lrint(Evaluate(firstValue + i * step)));
+    }
+
+    if (!grey)
+    {
+      const int red = outputBGRA ? 16 : 0;
+      const int blue = outputBGRA ? 0 : 16;
+      m_colourTable.resize(entries);
+      for (size_t i = 0; i < entries; ++i)
+      {
+        const byte value = m_greyTable[i];
+        if (m_hasLookupTable)
+        {
+          const byte* entry = reinterpret_cast<const byte*>(&m_lookupTable[value]);
+          m_colourTable[i] = (entry[0] << red) | (entry[1] << 8) | (entry[2] << blue) | (static_cast<uint32>(entry[3]) << 24);
+        }
+        else
+        {
+          m_colourTable[i] = value | (value << 8) | (value << 16) | 0xFF000000;
+        }
+      }
+    }
+
+    m_tableValid = true;
+    m_tableScalarType = scalarType;
+    m_tableGrey = grey;
+    m_tableBGRA = outputBGRA;
+  }
+}
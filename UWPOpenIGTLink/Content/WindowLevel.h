@@ -0,0 +1,100 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+#pragma once
+
+// Local includes
+#include "IGTCommon.h"
+
+// STL includes
+#include <array>
+#include <vector>
+
+namespace UWPOpenIGTLink
+{
+  ref class Image;
+
+  /// WINDOW_FUNCTION - Defines the curves a window/level maps values with
+  enum WINDOW_FUNCTION
+  {
+    WINDOW_FUNCTION_LINEAR,  /*!< values in [Level - Window/2, Level + Window/2] map linearly to [0, 255], the others are clamped */
+    WINDOW_FUNCTION_SIGMOID  /*!< 255 / (1 + exp(-4 (value - Level) / Window)) */
+  };
+
+  /*!
+    Maps 1 component uint8, uint16, int16 and float32 images to 8 bit grey or 4 channel display pixels through a window/level and an optional colour lookup table.
+    The window, function and lookup table are folded into a single table indexed by the (quantized, for float32) pixel value, which is rebuilt
+    when a parameter changes, so mapping a pixel costs one lookup whichever function is used.
+  */
+  public ref class WindowLevel sealed
+  {
+  public:
+    WindowLevel();
+
+    property double Window { double get(); void set(double arg); }
+    property double Level { double get(); void set(double arg); }
+    /// WINDOW_FUNCTION
+    property int Function { int get(); void set(int arg); }
+    /// 256 RGBA8 entries indexed by the windowed value, used for display output. nullptr maps to grey.
+    property Windows::Storage::Streams::IBuffer^ LookupTable { Windows::Storage::Streams::IBuffer ^ get(); void set(Windows::Storage::Streams::IBuffer ^ arg); }
+    /// Map bands of pixels concurrently
+    property bool Parallel { bool get(); void set(bool arg); }
+
+    /// Map every pixel of image to destination (4 bytes per pixel), BGRA8 if outputBGRA is true, RGBA8 otherwise
+    bool MapToDisplay(Image^ image, Windows::Storage::Streams::IBuffer^ destination, bool outputBGRA);
+    /// Map slice of a volume to destination (width * height * 4 bytes)
+    bool MapSliceToDisplay(Image^ image, uint32 slice, Windows::Storage::Streams::IBuffer^ destination, bool outputBGRA);
+    /// Map slice of a volume to 8 bit grey values in destination (width * height bytes), the lookup table is not applied
+    bool MapSliceToGrey(Image^ image, uint32 slice, Windows::Storage::Streams::IBuffer^ destination);
+
+    static bool IsMappingSupported(uint16 numberOfScalarComponents, int scalarType);
+
+  internal:
+    /// Map pixelCount values of source to destination, 1 byte per pixel if grey is true, 4 bytes (BGRA8 or RGBA8) otherwise
+    bool Map(const byte* source, size_t pixelCount, IGTL_SCALAR_TYPE scalarType, byte* destination, bool grey, bool outputBGRA);
+
+  protected private:
+    void UpdateTable(IGTL_SCALAR_TYPE scalarType, bool grey, bool outputBGRA);
+    double Evaluate(double value) const;
+    bool MapSlice(Image^ image, uint32 slice, Windows::Storage::Streams::IBuffer^ destination, bool grey, bool outputBGRA);
+
+  protected private:
+    double                        m_window = 256.0;
+    double                        m_level = 128.0;
+    WINDOW_FUNCTION               m_function = WINDOW_FUNCTION_LINEAR;
+    std::array<uint32, 256>       m_lookupTable;
+    bool                          m_hasLookupTable = false;
+    bool                          m_parallel = true;
+
+    // Table of the current parameters, indexed by pixel value
+    bool                          m_tableValid = false;
+    IGTL_SCALAR_TYPE              m_tableScalarType = IGTL_SCALARTYPE_UNKNOWN;
+    bool                          m_tableGrey = false;
+    bool                          m_tableBGRA = false;
+    std::vector<byte>             m_greyTable;
+    std::vector<uint32>           m_colourTable;
+    // Float values are quantized to a table index over [m_tableMinimum, m_tableMinimum + 65535 / m_tableScale]
+    float                         m_tableMinimum = 0.f;
+    float                         m_tableScale = 1.f;
+  };
+}
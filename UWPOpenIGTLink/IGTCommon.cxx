@@ -28,6 +28,7 @@ OTHER DEALINGS IN THE SOFTWARE.
 #include "IGTCommon.h"
 
 // STL includes
+#include <cmath>
 #include <limits>
 
 using namespace Windows::Foundation::Numerics;
@@ -40,6 +41,93 @@ namespace
     return ::tolower(a) == ::tolower(b);
   }
 
+  //----------------------------------------------------------------------------
+  // Powers of ten that are exactly representable as a double
+  static const double EXACT_POWERS_OF_TEN[] =
+  {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+  // Integers up to 2^53 convert to double without rounding
+  static const uint64 MAX_EXACT_MANTISSA = 1ull << 53;
+  // Well past the range of double even with 19 mantissa digits, larger decimal exponents are clamped to it
+  static const int64 MAX_DECIMAL_EXPONENT = 100000;
+
+  //----------------------------------------------------------------------------
+  inline bool IsSpace(char c)
+  {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+  }
+
+  //----------------------------------------------------------------------------
+  inline bool IsDigit(char c)
+  {
+    return c >= '0' && c <= '9';
+  }
+
+  //----------------------------------------------------------------------------
+  inline bool MatchInsensitive(const char* first, const char* last, const char* word)
+  {
+    for (; *word != '\0'; ++first, ++word)
+    {
+      if (first == last || (*first | 0x20) != *word)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  const char* SkipSpace(const char* first, const char* last)
+  {
+    while (first != last && IsSpace(*first))
+    {
+      ++first;
+    }
+    return first;
+  }
+
+  //----------------------------------------------------------------------------
+  template<typename IntType>
+  const char* ParseInteger(const char* first, const char* last, IntType& value)
+  {
+    const char* start = first;
+    first = SkipSpace(first, last);
+
+    bool negative = false;
+    if (first != last && (*first == '-' || *first == '+'))
+    {
+      negative = (*first == '-');
+      ++first;
+    }
+    if (negative && !std::numeric_limits<IntType>::is_signed)
+    {
+      return start;
+    }
+
+    // Accumulate as a negative number so that the minimum value of signed types is representable
+    const int64 limit = negative ? static_cast<int64>((std::numeric_limits<IntType>::min)()) : -static_cast<int64>((std::numeric_limits<IntType>::max)());
+    int64 result = 0;
+    const char* digits = first;
+    for (; first != last && IsDigit(*first); ++first)
+    {
+      result = result * 10 - (*first - '0');
+      if (result < limit)
+      {
+        return start;
+      }
+    }
+
+    if (first == digits)
+    {
+      return start;
+    }
+
+    value = static_cast<IntType>(negative ? result : -result);
+    return first;
+  }
+
   //----------------------------------------------------------------------------
   bool wcompare_pred(std::wstring::value_type a, std::wstring::value_type b)
   {
@@ -182,4 +270,188 @@ namespace UWPOpenIGTLink
 
     return dot(aQuat, bQuat);
   }
+
+  //----------------------------------------------------------------------------
+  const char* ParseNumber(const char* first, const char* last, double& value)
+  {
+    const char* start = first;
+    first = SkipSpace(first, last);
+
+    bool negative = false;
+    if (first != last && (*first == '-' || *first == '+'))
+    {
+      negative = (*first == '-');
+      ++first;
+    }
+
+    if (MatchInsensitive(first, last, "nan"))
+    {
+      value = std::numeric_limits<double>::quiet_NaN();
+      return first + 3;
+    }
+    if (MatchInsensitive(first, last, "inf"))
+    {
+      value = negative ? -std::numeric_limits<double>::infinity() : std::numeric_limits<double>::infinity();
+      first += 3;
+      return MatchInsensitive(first, last, "inity") ? first + 5 : first;
+    }
+
+    // Mantissa, keep the first 19 significant digits and track the decimal exponent of the rest
+    uint64 mantissa = 0;
+    int32 significantDigits = 0;
+    int64 exponent = 0;
+    bool anyDigits = false;
+    for (; first != last && IsDigit(*first); ++first)
+    {
+      anyDigits = true;
+      if (significantDigits < 19)
+      {
+        mantissa = mantissa * 10 + (*first - '0');
+        significantDigits += (mantissa != 0) ? 1 : 0;
+      }
+      else
+      {
+        ++exponent;
+      }
+    }
+    if (first != last && *first == '.')
+    {
+      ++first;
+      for (; first != last && IsDigit(*first); ++first)
+      {
+        anyDigits = true;
+        if (significantDigits < 19)
+        {
+          mantissa = mantissa * 10 + (*first - '0');
+          significantDigits += (mantissa != 0) ? 1 : 0;
+          --exponent;
+        }
+      }
+    }
+    if (!anyDigits)
+    {
+      return start;
+    }
+
+    if (first != last && (*first == 'e' || *first == 'E'))
+    {
+      // Any exponent beyond MAX_DECIMAL_EXPONENT overflows to infinity or underflows to zero, saturate rather than overflow
+      const char* exponentEnd = first + 1;
+      bool negativeExponent = false;
+      if (exponentEnd != last && (*exponentEnd == '-' || *exponentEnd == '+'))
+      {
+        negativeExponent = (*exponentEnd == '-');
+        ++exponentEnd;
+      }
+      int64 explicitExponent = 0;
+      const char* exponentDigits = exponentEnd;
+      for (; exponentEnd != last && IsDigit(*exponentEnd); ++exponentEnd)
+      {
+        explicitExponent = (explicitExponent < MAX_DECIMAL_EXPONENT) ? explicitExponent * 10 + (*exponentEnd - '0') : MAX_DECIMAL_EXPONENT;
+      }
+      if (exponentEnd != exponentDigits)
+      {
+        exponent += negativeExponent ? -explicitExponent : explicitExponent;
+        first = exponentEnd;
+      }
+    }
+    if (exponent > MAX_DECIMAL_EXPONENT)
+    {
+      exponent = MAX_DECIMAL_EXPONENT;
+    }
+    else if (exponent < -MAX_DECIMAL_EXPONENT)
+    {
+      exponent = -MAX_DECIMAL_EXPONENT;
+    }
+
+    double result = static_cast<double>(mantissa);
+    if (mantissa != 0 && exponent != 0)
+    {
+      // Correctly rounded when the mantissa fits in 53 bits and the power of ten is exactly representable,
+      // otherwise the mantissa conversion and the scaling each round once and the result may be off by a few ulps
+      if (mantissa <= MAX_EXACT_MANTISSA && exponent > 0 && exponent <= 22)
+      {
+        result *= EXACT_POWERS_OF_TEN[exponent];
+      }
+      else if (mantissa <= MAX_EXACT_MANTISSA && exponent < 0 && exponent >= -22)
+      {
+        result /= EXACT_POWERS_OF_TEN[-exponent];
+      }
+      else
+      {
+        result *= std::pow(10.0, static_cast<double>(exponent));
+      }
+    }
+
+    value = negative ? -result : result;
+    return first;
+  }
+
+  //----------------------------------------------------------------------------
+  const char* ParseNumber(const char* first, const char* last, float& value)
+  {
+    double result(0.0);
+    const char* end = ParseNumber(first, last, result);
+    if (end != first)
+    {
+      value = static_cast<float>(result);
+    }
+    return end;
+  }
+
+  //----------------------------------------------------------------------------
+  const char* ParseNumber(const char* first, const char* last, int32& value)
+  {
+    return ParseInteger(first, last, value);
+  }
+
+  //----------------------------------------------------------------------------
+  const char* ParseNumber(const char* first, const char* last, uint32& value)
+  {
+    return ParseInteger(first, last, value);
+  }
+
+  //----------------------------------------------------------------------------
+  size_t ParseFloats(const char* first, const char* last, float* values, size_t count)
+  {
+    size_t parsed = 0;
+    for (; parsed < count; ++parsed)
+    {
+      const char* end = ParseNumber(first, last, values[parsed]);
+      if (end == first)
+      {
+        break;
+      }
+      first = end;
+    }
+    return parsed;
+  }
+
+  //----------------------------------------------------------------------------
+  size_t ParseFloats(const std::string& str, float* values, size_t count)
+  {
+    return ParseFloats(str.data(), str.data() + str.size(), values, count);
+  }
+
+  //----------------------------------------------------------------------------
+  bool ParseMatrix(const char* first, const char* last, float4x4& matrix)
+  {
+    float values[16];
+    if (ParseFloats(first, last, values, 16) != 16)
+    {
+      return false;
+    }
+
+    matrix = float4x4(values[0], values[1], values[2], values[3],
+                      values[4], values[5], values[6], values[7],
+                      values[8], values[9], values[10], values[11],
+                      values[12], values[13], values[14], values[15]);
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  bool ParseMatrix(const std::string& str, float4x4& matrix)
+  {
+    return ParseMatrix(str.data(), str.data() + str.size(), matrix);
+  }
 }
\ No newline at end of file
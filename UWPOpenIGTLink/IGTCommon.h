@@ -82,6 +82,7 @@ namespace UWPOpenIGTLink
     IGTL_SCALARTYPE_UINT32 = IGTL_SCALAR_UINT32,
     IGTL_SCALARTYPE_FLOAT32 = IGTL_SCALAR_FLOAT32,
     IGTL_SCALARTYPE_FLOAT64 = IGTL_SCALAR_FLOAT64,
+    IGTL_SCALARTYPE_FLOAT16 = 12, /*!< IEEE 754 half precision, not defined by OpenIGTLink (12 is unassigned), only understood by peers built with this library */
     IGTL_SCALARTYPE_COMPLEX = IGTL_SCALAR_COMPLEX
   };
 
@@ -155,8 +156,13 @@ namespace UWPOpenIGTLink
   typedef Platform::Collections::Map<Platform::String^, Platform::String^> StringMap;
   typedef Windows::Foundation::Collections::IMap<Platform::String^, Platform::String^> FrameFieldsABI;
   typedef std::map<std::wstring, std::wstring> FrameFields;
-  typedef Platform::Array<uint16> FrameSizeABI;
-  typedef std::array<uint16, 3> FrameSize;
+  // Image extents are 32 bit per axis, byte and pixel counts are computed from them in 64 bit (see Image::ComputeImageSizeBytes).
+  // 32 bit extents already describe volumes far beyond what a 64 bit size_t byte count can address (and what the TRACKEDFRAME and
+  // IMAGE wire formats carry), the overflows that matter are in the products, which is where the 64 bit arithmetic is.
+  // FrameSizeABI was Platform::Array<uint16> before, this changes the metadata of every public member that takes or returns it
+  // (e.g. Image::Dimensions, VideoFrame::Dimensions, Image::AllocateScalars), consumers of the component must be rebuilt.
+  typedef Platform::Array<uint32> FrameSizeABI;
+  typedef std::array<uint32, 3> FrameSize;
 
 #ifdef _WIN64
   typedef int64 SharedBytePtr;
@@ -200,6 +206,24 @@ namespace UWPOpenIGTLink
   //--------------------------------------------------------
   std::wstring PrintMatrix(const Windows::Foundation::Numerics::float4x4& matrix);
 
+  //----------------------------------------------------------------------------
+  /// Locale independent, non-allocating number parsing in the spirit of std::from_chars
+  /// Leading whitespace is skipped. Returns one past the last consumed character, or first if no number could be parsed
+  /// Doubles are correctly rounded when the digits, read as an integer, are at most 2^53 (15 digits always are) and the decimal exponent
+  /// is at most 22, otherwise they may be off by a few ulps. Digits past the 19th are ignored and out of range exponents give infinity or zero.
+  const char* ParseNumber(const char* first, const char* last, double& value);
+  const char* ParseNumber(const char* first, const char* last, float& value);
+  const char* ParseNumber(const char* first, const char* last, int32& value);
+  const char* ParseNumber(const char* first, const char* last, uint32& value);
+
+  /// Parse up to count whitespace separated floats, returns the number of values parsed
+  size_t ParseFloats(const char* first, const char* last, float* values, size_t count);
+  size_t ParseFloats(const std::string& str, float* values, size_t count);
+
+  /// Parse 16 whitespace separated values in row-major order, as written in TRACKEDFRAME transform fields
+  bool ParseMatrix(const char* first, const char* last, Windows::Foundation::Numerics::float4x4& matrix);
+  bool ParseMatrix(const std::string& str, Windows::Foundation::Numerics::float4x4& matrix);
+
   //----------------------------------------------------------------------------
   float GetOrientationDifference(const Windows::Foundation::Numerics::float4x4& aMatrix, const Windows::Foundation::Numerics::float4x4& bMatrix);
 
@@ -0,0 +1,69 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+#pragma once
+
+// STL includes
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace UWPOpenIGTLinkTests
+{
+  /// Median duration of function in microseconds over repetitions calls, after one warm up call
+  template<typename Function>
+  double MeasureMicroseconds(Function function, int repetitions = 15)
+  {
+    function();
+    std::vector<double> durations(repetitions);
+    for (auto& duration : durations)
+    {
+      auto start = std::chrono::high_resolution_clock::now();
+      function();
+      duration = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+    std::nth_element(durations.begin(), durations.begin() + durations.size() / 2, durations.end());
+    return durations[durations.size() / 2];
+  }
+
+  /// Write a timing to the test output, with the throughput if the call processed bytes bytes
+  inline void ReportBenchmark(const std::wstring& name, double microseconds, double bytes = 0.0)
+  {
+    std::wstring line = name + L": " + std::to_wstring(microseconds) + L" us";
+    if (bytes > 0.0 && microseconds > 0.0)
+    {
+      line += L", " + std::to_wstring(bytes / microseconds) + L" MB/s";
+    }
+    Microsoft::VisualStudio::CppUnitTestFramework::Logger::WriteMessage((line + L"\n").c_str());
+  }
+
+  /// Write how much faster the new path is than the path it replaced
+  inline void ReportSpeedup(const std::wstring& name, double baselineMicroseconds, double microseconds)
+  {
+    if (microseconds > 0.0)
+    {
+      Microsoft::VisualStudio::CppUnitTestFramework::Logger::WriteMessage((name + L": " + std::to_wstring(baselineMicroseconds / microseconds) + L"x\n").c_str());
+    }
+  }
+}
@@ -0,0 +1,159 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+// Local includes
+#include "pch.h"
+#include "Benchmark.h"
+#include "FastCopy.h"
+
+// STL includes
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace UWPOpenIGTLinkTests;
+
+namespace
+{
+  // A 1920x1080 RGBA frame, about 8 MB
+  static const size_t FRAME_SIZE = 1920 * 1080 * 4;
+  static const int COPIES = 30;
+  // Tracking state that fits in L2/L3, walked in a dependent random order so every cache miss stalls the walk
+  static const size_t WORKING_SET_ENTRIES = 256 * 1024;
+  static const size_t STEPS_PER_PASS = 16 * 1024;
+
+  //----------------------------------------------------------------------------
+  // A single cycle through every entry, next[i] is the entry visited after i
+  std::vector<uint32_t> CreateWorkingSet()
+  {
+    std::vector<uint32_t> order(WORKING_SET_ENTRIES);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin() + 1, order.end(), std::mt19937(1));
+    std::vector<uint32_t> next(WORKING_SET_ENTRIES);
+    for (size_t i = 0; i < WORKING_SET_ENTRIES; ++i)
+    {
+      next[order[i]] = order[(i + 1) % WORKING_SET_ENTRIES];
+    }
+    return next;
+  }
+
+  //----------------------------------------------------------------------------
+  // Median time in microseconds of a pass over the working set on another thread while work runs
+  double MeasureTrackingPass(const std::vector<uint32_t>& workingSet, const std::function<void()>& work)
+  {
+    std::atomic<bool> running(true);
+    std::atomic<uint32_t> position(0);
+    std::vector<double> passes;
+    std::thread tracker([&]()
+    {
+      uint32_t index = 0;
+      while (running)
+      {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < STEPS_PER_PASS; ++i)
+        {
+          index = workingSet[index];
+        }
+        passes.push_back(std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count());
+      }
+      position = index;
+    });
+
+    work();
+    running = false;
+    tracker.join();
+
+    if (passes.empty())
+    {
+      return 0.0;
+    }
+    std::nth_element(passes.begin(), passes.begin() + passes.size() / 2, passes.end());
+    return passes[passes.size() / 2];
+  }
+}
+
+namespace UWPOpenIGTLinkTests
+{
+  TEST_CLASS(FastCopyBenchmarks)
+  {
+  public:
+    BEGIN_TEST_CLASS_ATTRIBUTE()
+    TEST_CLASS_ATTRIBUTE(L"TestCategory", L"Benchmark")
+    END_TEST_CLASS_ATTRIBUTE()
+
+    TEST_METHOD(FrameCopyBesideTracking)
+    {
+      std::vector<byte> source(FRAME_SIZE);
+      std::mt19937 generator(2);
+      for (auto& value : source)
+      {
+        value = static_cast<byte>(generator());
+      }
+      std::vector<byte> destination(FRAME_SIZE);
+      const auto workingSet = CreateWorkingSet();
+
+      const double memcpyMicroseconds = MeasureMicroseconds([&]()
+      {
+        memcpy(destination.data(), source.data(), FRAME_SIZE);
+      });
+      const double fastCopyMicroseconds = MeasureMicroseconds([&]()
+      {
+        UWPOpenIGTLink::FastCopy(destination.data(), source.data(), FRAME_SIZE);
+      });
+      Assert::IsTrue(destination == source);
+
+      // The tracking pass alone, then while frames are copied back to back with each copy
+      const double idlePass = MeasureTrackingPass(workingSet, [&]()
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+      });
+      const double memcpyPass = MeasureTrackingPass(workingSet, [&]()
+      {
+        for (int i = 0; i < COPIES; ++i)
+        {
+          memcpy(destination.data(), source.data(), FRAME_SIZE);
+        }
+      });
+      const double fastCopyPass = MeasureTrackingPass(workingSet, [&]()
+      {
+        for (int i = 0; i < COPIES; ++i)
+        {
+          UWPOpenIGTLink::FastCopy(destination.data(), source.data(), FRAME_SIZE);
+        }
+      });
+
+      ReportBenchmark(L"8 MB frame, memcpy", memcpyMicroseconds, static_cast<double>(FRAME_SIZE));
+      ReportBenchmark(L"8 MB frame, FastCopy", fastCopyMicroseconds, static_cast<double>(FRAME_SIZE));
+      ReportBenchmark(L"Tracking pass, idle", idlePass);
+      ReportBenchmark(L"Tracking pass, during memcpy", memcpyPass);
+      ReportBenchmark(L"Tracking pass, during FastCopy", fastCopyPass);
+
+      Assert::IsTrue(destination == source);
+    }
+  };
+}
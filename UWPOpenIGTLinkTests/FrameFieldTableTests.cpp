@@ -0,0 +1,134 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+// Local includes
+#include "pch.h"
+#include "FrameFieldTable.h"
+
+// STL includes
+#include <cstring>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  std::shared_ptr<const char> MakeXml(const std::string& xml)
+  {
+    char* data = new char[xml.size()];
+    memcpy(data, xml.data(), xml.size());
+    return std::shared_ptr<const char>(data, std::default_delete<char[]>());
+  }
+
+  //----------------------------------------------------------------------------
+  bool Parse(UWPOpenIGTLink::FrameFieldTable& table, const std::string& xml)
+  {
+    return table.Parse(MakeXml(xml), xml.size());
+  }
+}
+
+namespace UWPOpenIGTLinkTests
+{
+  TEST_CLASS(FrameFieldTableTests)
+  {
+  public:
+    TEST_METHOD(ParsesFlatFields)
+    {
+      UWPOpenIGTLink::FrameFieldTable table;
+      Assert::IsTrue(Parse(table, "<?xml version=\"1.0\"?><TrackedFrame ImageDataValid=\"true\">"
+                           "<CustomFrameField Name=\"Depth\" Value=\"40\" />"
+                           "<CustomFrameField Name=\"ProbeToTrackerTransform\" Value=\"1 0 0 0 0 1 0 0 0 0 1 0 0 0 0 1\" />"
+                           "</TrackedFrame>"));
+
+      std::string valid;
+      Assert::IsTrue(table.GetRootAttribute("ImageDataValid", valid));
+      Assert::AreEqual(std::string("true"), valid);
+      Assert::AreEqual(size_t(2), table.GetFieldCount());
+      Assert::AreEqual(size_t(0), table.FindField(std::string("Depth")));
+      Assert::AreEqual(std::string("40"), table.GetFieldValue(0));
+      Assert::IsTrue(table.IsTransformField(1));
+    }
+
+    TEST_METHOD(RejectsTruncatedRootTag)
+    {
+      // The root tag ends exactly at the end of the buffer, the character after the name must not be read
+      UWPOpenIGTLink::FrameFieldTable table;
+      Assert::IsFalse(Parse(table, "<TrackedFrame"));
+      Assert::IsFalse(Parse(table, "<TrackedFrame ImageDataValid=\"true\">"));
+    }
+
+    TEST_METHOD(SkipsNestedElements)
+    {
+      // Closing tags of nested children must not end the root element
+      UWPOpenIGTLink::FrameFieldTable table;
+      Assert::IsTrue(Parse(table, "<TrackedFrame>"
+                           "<Segment><CustomFrameField Name=\"Nested\" Value=\"0\" /></Segment>"
+                           "<CustomFrameField Name=\"First\" Value=\"1\"><Note>text</Note></CustomFrameField>"
+                           "<CustomFrameField Name=\"Second\" Value=\"2\" />"
+                           "</TrackedFrame>"));
+
+      Assert::AreEqual(size_t(2), table.GetFieldCount());
+      Assert::AreEqual(std::string("First"), table.GetFieldName(0));
+      Assert::AreEqual(std::string("Second"), table.GetFieldName(1));
+      Assert::AreEqual(table.GetFieldCount(), table.FindField(std::string("Nested")));
+
+      Assert::IsFalse(Parse(table, "<TrackedFrame><Segment><CustomFrameField Name=\"First\" Value=\"1\" /></Segment>"));
+    }
+
+    TEST_METHOD(SkipsComments)
+    {
+      UWPOpenIGTLink::FrameFieldTable table;
+      Assert::IsTrue(Parse(table, "<!-- <TrackedFrame Commented=\"true\"/> --><TrackedFrame>"
+                           "<!-- <CustomFrameField Name=\"Commented\" Value=\"0\" /> -->"
+                           "<CustomFrameField Name=\"First\" Value=\"1\" />"
+                           "<!-- </TrackedFrame> -->"
+                           "<CustomFrameField Name=\"Second\" Value=\"2\" />"
+                           "</TrackedFrame>"));
+
+      std::string commented;
+      Assert::IsFalse(table.GetRootAttribute("Commented", commented));
+      Assert::AreEqual(size_t(2), table.GetFieldCount());
+      Assert::AreEqual(std::string("Second"), table.GetFieldName(1));
+
+      Assert::IsFalse(Parse(table, "<TrackedFrame><!-- unterminated </TrackedFrame>"));
+    }
+
+    TEST_METHOD(WidensCharacterReferences)
+    {
+      UWPOpenIGTLink::FrameFieldTable table;
+      Assert::IsTrue(Parse(table, "<TrackedFrame>"
+                           "<CustomFrameField Name=\"Operator\" Value=\"Ren&#233;e &amp; &#x1F600;\" />"
+                           "</TrackedFrame>"));
+
+      const std::wstring expected = std::wstring(L"Ren\u00E9e & ") + wchar_t(0xD83D) + wchar_t(0xDE00);
+      Assert::AreEqual(expected, table.GetWideFieldValue(0));
+
+      UWPOpenIGTLink::FrameFields fields;
+      table.GetFields(fields);
+      Assert::AreEqual(expected, fields[L"Operator"]);
+
+      // The narrow accessors keep returning UTF-8
+      Assert::AreEqual(std::string("Ren\xC3\xA9" "e & \xF0\x9F\x98\x80"), table.GetFieldValue(0));
+    }
+  };
+}
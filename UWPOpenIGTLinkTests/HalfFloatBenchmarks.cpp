@@ -0,0 +1,126 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+// Local includes
+#include "pch.h"
+#include "Benchmark.h"
+#include "HalfFloat.h"
+#include "PixelConversion.h"
+
+// STL includes
+#include <cmath>
+#include <cstring>
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace UWPOpenIGTLink;
+using namespace UWPOpenIGTLinkTests;
+
+namespace
+{
+  // 4096x4096 float32 image, 64 MB
+  static const size_t VALUE_COUNT = 4096 * 4096;
+  // Smallest normal half, smaller values lose significand bits
+  static const float MIN_NORMAL_FLOAT16 = 6.103515625e-05f;
+
+  //----------------------------------------------------------------------------
+  // Magnitudes spread over the normal half range, as elastography and probability maps span several decades
+  std::vector<float> CreateValues()
+  {
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<float> exponent(-14.f, 15.f);
+    std::vector<float> values(VALUE_COUNT);
+    for (auto& value : values)
+    {
+      value = ((generator() & 1) ? 1.f : -1.f) * std::exp2(exponent(generator));
+    }
+    return values;
+  }
+}
+
+namespace UWPOpenIGTLinkTests
+{
+  TEST_CLASS(HalfFloatBenchmarks)
+  {
+  public:
+    BEGIN_TEST_CLASS_ATTRIBUTE()
+    TEST_CLASS_ATTRIBUTE(L"TestCategory", L"Benchmark")
+    END_TEST_CLASS_ATTRIBUTE()
+
+    TEST_METHOD(ConvertSixtyFourMegabytes)
+    {
+      const auto values = CreateValues();
+      std::vector<float> copied(VALUE_COUNT), restored(VALUE_COUNT), scalarRestored(VALUE_COUNT);
+      std::vector<uint16_t> halves(VALUE_COUNT), scalarHalves(VALUE_COUNT);
+
+      // Float32 images are copied as they are, float16 ones are half the bytes to send and store
+      const double copyMicroseconds = MeasureMicroseconds([&]()
+      {
+        memcpy(copied.data(), values.data(), VALUE_COUNT * sizeof(float));
+      });
+
+      // Lowering the PixelConversion level below AVX2 disables F16C and selects the scalar conversion
+      const PIXEL_CONVERSION_ISA best = PixelConversion::GetInstructionSetLevel();
+      PixelConversion::SetInstructionSetLevel(PIXEL_CONVERSION_ISA_SCALAR);
+      const double scalarToHalfMicroseconds = MeasureMicroseconds([&]()
+      {
+        ConvertFloat32ToFloat16(values.data(), scalarHalves.data(), VALUE_COUNT);
+      });
+      const double scalarToFloatMicroseconds = MeasureMicroseconds([&]()
+      {
+        ConvertFloat16ToFloat32(scalarHalves.data(), scalarRestored.data(), VALUE_COUNT);
+      });
+      PixelConversion::SetInstructionSetLevel(best);
+
+      const double toHalfMicroseconds = MeasureMicroseconds([&]()
+      {
+        ConvertFloat32ToFloat16(values.data(), halves.data(), VALUE_COUNT);
+      });
+      const double toFloatMicroseconds = MeasureMicroseconds([&]()
+      {
+        ConvertFloat16ToFloat32(halves.data(), restored.data(), VALUE_COUNT);
+      });
+
+      const double bytes = static_cast<double>(VALUE_COUNT * sizeof(float));
+      ReportBenchmark(L"64 MB float32, memcpy", copyMicroseconds, bytes);
+      ReportBenchmark(L"64 MB float32, ConvertFloat32ToFloat16 scalar", scalarToHalfMicroseconds, bytes);
+      ReportBenchmark(L"64 MB float32, ConvertFloat32ToFloat16 " + std::wstring(PixelConversion::InstructionSet->Data()), toHalfMicroseconds, bytes);
+      ReportBenchmark(L"64 MB float32, ConvertFloat16ToFloat32 scalar", scalarToFloatMicroseconds, bytes);
+      ReportBenchmark(L"64 MB float32, ConvertFloat16ToFloat32 " + std::wstring(PixelConversion::InstructionSet->Data()), toFloatMicroseconds, bytes);
+
+      // Both directions are rounded the same way by every kernel, and round to nearest keeps normal values within half an ulp
+      double maximumRelativeError = 0.0;
+      for (size_t i = 0; i < VALUE_COUNT; ++i)
+      {
+        Assert::AreEqual(scalarHalves[i], halves[i]);
+        Assert::AreEqual(scalarRestored[i], restored[i]);
+        if (std::abs(values[i]) >= MIN_NORMAL_FLOAT16)
+        {
+          maximumRelativeError = std::max(maximumRelativeError, std::abs(static_cast<double>(restored[i]) - values[i]) / std::abs(values[i]));
+        }
+      }
+      Logger::WriteMessage((L"64 MB float32, maximum relative error of normal values: " + std::to_wstring(maximumRelativeError) + L"\n").c_str());
+      Assert::IsTrue(maximumRelativeError <= std::exp2(-11.0));
+    }
+  };
+}
@@ -0,0 +1,243 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+// Local includes
+#include "pch.h"
+#include "Benchmark.h"
+#include "ImageCodec.h"
+
+// STL includes
+#include <cmath>
+#include <cstring>
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace UWPOpenIGTLinkTests;
+
+namespace
+{
+  static const int FRAME_WIDTH = 640;
+  static const int FRAME_HEIGHT = 480;
+  static const size_t FRAME_SIZE = FRAME_WIDTH * FRAME_HEIGHT;
+  static const int SEQUENCE_LENGTH = 30;
+
+  //----------------------------------------------------------------------------
+  // 8 bit B-mode like frame, speckle inside a fan shaped sector with depth attenuation, black outside it
+  std::vector<byte> CreateSpeckleFrame()
+  {
+    std::mt19937 generator(1);
+    std::exponential_distribution<float> speckle(1.f);
+    std::vector<byte> frame(FRAME_SIZE, 0);
+    for (int y = 0; y < FRAME_HEIGHT; ++y)
+    {
+      const float halfWidth = 0.5f * FRAME_WIDTH * y / FRAME_HEIGHT;
+      const float gain = 120.f * (1.f - 0.6f * y / FRAME_HEIGHT);
+      for (int x = 0; x < FRAME_WIDTH; ++x)
+      {
+        if (std::abs(x - 0.5f * FRAME_WIDTH) < halfWidth)
+        {
+          frame[y * FRAME_WIDTH + x] = static_cast<byte>(std::min(255.f, gain * speckle(generator)));
+        }
+      }
+    }
+    return frame;
+  }
+
+  //----------------------------------------------------------------------------
+  // Sequence of a still probe, each frame re-speckles a 48x48 block (0.75% of the pixels) at a moving position of the previous one
+  std::vector<std::vector<byte>> CreateStaticProbeSequence()
+  {
+    std::mt19937 generator(3);
+    std::exponential_distribution<float> speckle(1.f);
+    std::vector<std::vector<byte>> frames(1, CreateSpeckleFrame());
+    for (int i = 1; i < SEQUENCE_LENGTH; ++i)
+    {
+      std::vector<byte> frame(frames.back());
+      const int left = FRAME_WIDTH / 2 - 24 + 4 * (i % 8);
+      const int top = FRAME_HEIGHT / 2 + 2 * i;
+      for (int y = top; y < top + 48; ++y)
+      {
+        for (int x = left; x < left + 48; ++x)
+        {
+          frame[y * FRAME_WIDTH + x] = static_cast<byte>(std::min(255.f, 80.f * speckle(generator)));
+        }
+      }
+      frames.push_back(std::move(frame));
+    }
+    return frames;
+  }
+
+  //----------------------------------------------------------------------------
+  std::vector<byte> CreateGradientFrame()
+  {
+    std::vector<byte> frame(FRAME_SIZE);
+    for (int y = 0; y < FRAME_HEIGHT; ++y)
+    {
+      for (int x = 0; x < FRAME_WIDTH; ++x)
+      {
+        frame[y * FRAME_WIDTH + x] = static_cast<byte>((x + y) / 8);
+      }
+    }
+    return frame;
+  }
+
+  //----------------------------------------------------------------------------
+  std::vector<byte> CreateNoiseFrame()
+  {
+    std::mt19937 generator(2);
+    std::vector<byte> frame(FRAME_SIZE);
+    for (auto& value : frame)
+    {
+      value = static_cast<byte>(generator());
+    }
+    return frame;
+  }
+
+  //----------------------------------------------------------------------------
+  // Compress and decompress frame, reports throughput and ratio against sending it raw
+  void BenchmarkLZ4(const std::wstring& name, const std::vector<byte>& frame)
+  {
+    std::vector<byte> compressed(UWPOpenIGTLink::LZ4CompressBound(frame.size()));
+    std::vector<byte> decompressed(frame.size());
+
+    size_t compressedSize = 0;
+    const double copyMicroseconds = MeasureMicroseconds([&]()
+    {
+      memcpy(decompressed.data(), frame.data(), frame.size());
+    });
+    const double compressMicroseconds = MeasureMicroseconds([&]()
+    {
+      compressedSize = UWPOpenIGTLink::LZ4Compress(frame.data(), frame.size(), compressed.data(), compressed.size());
+    });
+    Assert::IsTrue(compressedSize > 0);
+
+    bool decoded = false;
+    const double decompressMicroseconds = MeasureMicroseconds([&]()
+    {
+      decoded = UWPOpenIGTLink::LZ4Decompress(compressed.data(), compressedSize, decompressed.data(), decompressed.size());
+    });
+    Assert::IsTrue(decoded);
+    Assert::IsTrue(decompressed == frame);
+
+    ReportBenchmark(name + L", memcpy", copyMicroseconds, static_cast<double>(frame.size()));
+    ReportBenchmark(name + L", LZ4Compress", compressMicroseconds, static_cast<double>(frame.size()));
+    ReportBenchmark(name + L", LZ4Decompress", decompressMicroseconds, static_cast<double>(frame.size()));
+    Logger::WriteMessage((name + L", ratio: " + std::to_wstring(static_cast<double>(frame.size()) / compressedSize) + L"\n").c_str());
+  }
+
+  //----------------------------------------------------------------------------
+  // Delta encode every frame against the previous one, reports the bytes sent and decode cost per frame against raw transport
+  void BenchmarkDelta(const std::wstring& name, const std::vector<std::vector<byte>>& frames)
+  {
+    const size_t deltaFrames = frames.size() - 1;
+    std::vector<std::vector<byte>> residuals(frames.size());
+    std::vector<byte> decoded(FRAME_SIZE);
+
+    const double copyMicroseconds = MeasureMicroseconds([&]()
+    {
+      for (size_t i = 1; i < frames.size(); ++i)
+      {
+        memcpy(decoded.data(), frames[i].data(), FRAME_SIZE);
+      }
+    }) / deltaFrames;
+    const double encodeMicroseconds = MeasureMicroseconds([&]()
+    {
+      for (size_t i = 1; i < frames.size(); ++i)
+      {
+        UWPOpenIGTLink::DeltaEncode(frames[i].data(), frames[i - 1].data(), FRAME_SIZE, residuals[i]);
+      }
+    }) / deltaFrames;
+    const double decodeMicroseconds = MeasureMicroseconds([&]()
+    {
+      for (size_t i = 1; i < frames.size(); ++i)
+      {
+        UWPOpenIGTLink::DeltaDecode(residuals[i].data(), residuals[i].size(), frames[i - 1].data(), decoded.data(), FRAME_SIZE);
+      }
+    }) / deltaFrames;
+
+    // Residuals are LZ4 compressed as well when the message is
+    size_t residualBytes = 0;
+    size_t compressedBytes = 0;
+    std::vector<byte> compressed(UWPOpenIGTLink::LZ4CompressBound(UWPOpenIGTLink::DeltaEncodeBound(FRAME_SIZE)));
+    for (size_t i = 1; i < frames.size(); ++i)
+    {
+      Assert::IsTrue(UWPOpenIGTLink::DeltaDecode(residuals[i].data(), residuals[i].size(), frames[i - 1].data(), decoded.data(), FRAME_SIZE));
+      Assert::IsTrue(decoded == frames[i]);
+      residualBytes += residuals[i].size();
+      compressedBytes += UWPOpenIGTLink::LZ4Compress(residuals[i].data(), residuals[i].size(), compressed.data(), compressed.size());
+    }
+
+    ReportBenchmark(name + L", memcpy per frame", copyMicroseconds, static_cast<double>(FRAME_SIZE));
+    ReportBenchmark(name + L", DeltaEncode per frame", encodeMicroseconds, static_cast<double>(FRAME_SIZE));
+    ReportBenchmark(name + L", DeltaDecode per frame", decodeMicroseconds, static_cast<double>(FRAME_SIZE));
+    Logger::WriteMessage((name + L", bytes per frame: raw " + std::to_wstring(FRAME_SIZE) + L", residual " + std::to_wstring(residualBytes / deltaFrames) +
+                          L", LZ4 residual " + std::to_wstring(compressedBytes / deltaFrames) + L"\n").c_str());
+  }
+}
+
+namespace UWPOpenIGTLinkTests
+{
+  TEST_CLASS(ImageCodecBenchmarks)
+  {
+  public:
+    BEGIN_TEST_CLASS_ATTRIBUTE()
+    TEST_CLASS_ATTRIBUTE(L"TestCategory", L"Benchmark")
+    END_TEST_CLASS_ATTRIBUTE()
+
+    TEST_METHOD(LZ4SpeckleFrame)
+    {
+      BenchmarkLZ4(L"640x480 speckle", CreateSpeckleFrame());
+    }
+
+    TEST_METHOD(LZ4GradientFrame)
+    {
+      BenchmarkLZ4(L"640x480 gradient", CreateGradientFrame());
+    }
+
+    TEST_METHOD(LZ4NoiseFrame)
+    {
+      BenchmarkLZ4(L"640x480 noise", CreateNoiseFrame());
+    }
+
+    TEST_METHOD(LZ4BlankFrame)
+    {
+      BenchmarkLZ4(L"640x480 blank", std::vector<byte>(FRAME_SIZE, 0));
+    }
+
+    TEST_METHOD(DeltaStaticProbe)
+    {
+      BenchmarkDelta(L"640x480 static probe", CreateStaticProbeSequence());
+    }
+
+    TEST_METHOD(DeltaMovingProbe)
+    {
+      // Every pixel changes between frames, the worst case for the residual
+      std::vector<std::vector<byte>> frames;
+      for (int i = 0; i < SEQUENCE_LENGTH; ++i)
+      {
+        frames.push_back(i % 2 == 0 ? CreateSpeckleFrame() : CreateNoiseFrame());
+      }
+      BenchmarkDelta(L"640x480 moving probe", frames);
+    }
+  };
+}
@@ -0,0 +1,97 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+// Local includes
+#include "pch.h"
+#include "Image.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UWPOpenIGTLinkTests
+{
+  namespace
+  {
+    UWPOpenIGTLink::Image^ CreateImage(byte value)
+    {
+      auto image = ref new UWPOpenIGTLink::Image();
+      image->AllocateScalars(UWPOpenIGTLink::FrameSize{ 4, 4, 1 }, 1, UWPOpenIGTLink::IGTL_SCALARTYPE_UINT8);
+      memset(image->GetMutableImageDataInternal().get(), value, 16);
+      return image;
+    }
+  }
+
+  TEST_CLASS(ImageCopyOnWriteTests)
+  {
+  public:
+    TEST_METHOD(MutableImageDataDoesNotAliasCopies)
+    {
+      auto image = CreateImage(1);
+      auto copy = ref new UWPOpenIGTLink::Image();
+      copy->DeepCopy(image);
+      Assert::IsTrue(copy->IsImageDataShared());
+
+      // Writes through the buffer only reach the image it was taken from
+      UWPOpenIGTLink::GetDataFromIBuffer<byte>(image->MutableImageData)[0] = 2;
+      Assert::AreEqual<int>(1, copy->GetImageDataInternal().get()[0]);
+      Assert::AreEqual<int>(2, image->GetImageDataInternal().get()[0]);
+    }
+
+    TEST_METHOD(ExposedPixelsAreNotShared)
+    {
+      auto image = CreateImage(1);
+      auto buffer = image->MutableImageData;
+      auto copy = ref new UWPOpenIGTLink::Image();
+      copy->DeepCopy(image);
+      Assert::IsTrue(copy->GetImageDataInternal() != image->GetImageDataInternal());
+
+      UWPOpenIGTLink::GetDataFromIBuffer<byte>(buffer)[0] = 2;
+      Assert::AreEqual<int>(1, copy->GetImageDataInternal().get()[0]);
+    }
+
+    TEST_METHOD(GetMutableImageDataDetaches)
+    {
+      auto image = CreateImage(1);
+      auto copy = ref new UWPOpenIGTLink::Image();
+      copy->DeepCopy(image);
+
+      auto pixels = reinterpret_cast<std::shared_ptr<byte>*>(image->GetMutableImageData());
+      (*pixels).get()[0] = 2;
+      Assert::AreEqual<int>(1, copy->GetImageDataInternal().get()[0]);
+    }
+
+    TEST_METHOD(ImageDataReadsDoNotCopy)
+    {
+      auto image = CreateImage(1);
+      auto copy = ref new UWPOpenIGTLink::Image();
+      copy->DeepCopy(image);
+
+      const uint64 detachedBytes = UWPOpenIGTLink::Image::CopyOnWriteDetachedBytes;
+      const uint64 reads = UWPOpenIGTLink::Image::ImageDataReadCount;
+      auto buffer = image->ImageData;
+      Assert::IsTrue(UWPOpenIGTLink::GetDataFromIBuffer<byte>(buffer) == copy->GetImageDataInternal().get());
+      Assert::IsTrue(reinterpret_cast<std::shared_ptr<byte>*>(image->GetImageData())->get() == copy->GetImageDataInternal().get());
+      Assert::AreEqual(detachedBytes, UWPOpenIGTLink::Image::CopyOnWriteDetachedBytes);
+      Assert::AreEqual(reads + 2, UWPOpenIGTLink::Image::ImageDataReadCount);
+    }
+  };
+}
@@ -0,0 +1,80 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+// Local includes
+#include "pch.h"
+#include "HalfFloat.h"
+#include "ImagePyramid.h"
+
+// STL includes
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UWPOpenIGTLinkTests
+{
+  TEST_CLASS(ImagePyramidTests)
+  {
+  public:
+    TEST_METHOD(Float16MatchesFloat32)
+    {
+      // Half levels are the float32 levels rounded to half
+      const UWPOpenIGTLink::FrameSize size = { 5, 3, 2 };
+      std::vector<float> values(size[0] * size[1] * size[2]);
+      std::vector<uint16_t> halfValues(values.size());
+      for (size_t i = 0; i < values.size(); ++i)
+      {
+        values[i] = 0.5f * i;
+        halfValues[i] = UWPOpenIGTLink::Float32ToFloat16(values[i]);
+      }
+
+      for (auto filter : { UWPOpenIGTLink::PYRAMID_FILTER_BOX, UWPOpenIGTLink::PYRAMID_FILTER_GAUSSIAN })
+      {
+        auto pyramid = UWPOpenIGTLink::ImagePyramid::Generate(reinterpret_cast<const byte*>(values.data()), size, 1, UWPOpenIGTLink::IGTL_SCALARTYPE_FLOAT32, filter, 8);
+        auto halfPyramid = UWPOpenIGTLink::ImagePyramid::Generate(reinterpret_cast<const byte*>(halfValues.data()), size, 1, UWPOpenIGTLink::IGTL_SCALARTYPE_FLOAT16, filter, 8);
+        Assert::IsNotNull(pyramid.get());
+        Assert::IsNotNull(halfPyramid.get());
+        Assert::AreEqual(pyramid->GetNumberOfLevels(), halfPyramid->GetNumberOfLevels());
+
+        for (size_t level = 0; level < pyramid->GetNumberOfLevels(); ++level)
+        {
+          auto& levelSize = pyramid->GetLevel(level).Size;
+          const float* expected = reinterpret_cast<const float*>(pyramid->GetLevel(level).Data.get());
+          const uint16_t* actual = reinterpret_cast<const uint16_t*>(halfPyramid->GetLevel(level).Data.get());
+          for (size_t i = 0; i < size_t(levelSize[0]) * levelSize[1] * levelSize[2]; ++i)
+          {
+            Assert::AreEqual(UWPOpenIGTLink::Float32ToFloat16(expected[i]), actual[i]);
+          }
+        }
+      }
+    }
+
+    TEST_METHOD(RejectsUnknownScalarType)
+    {
+      std::vector<byte> pixels(16);
+      const UWPOpenIGTLink::FrameSize size = { 4, 4, 1 };
+      Assert::IsFalse(UWPOpenIGTLink::ImagePyramid::IsFilterSupported(1, UWPOpenIGTLink::IGTL_SCALARTYPE_UNKNOWN));
+      Assert::IsNull(UWPOpenIGTLink::ImagePyramid::Generate(pixels.data(), size, 1, UWPOpenIGTLink::IGTL_SCALARTYPE_UNKNOWN, UWPOpenIGTLink::PYRAMID_FILTER_BOX, 8).get());
+    }
+  };
+}
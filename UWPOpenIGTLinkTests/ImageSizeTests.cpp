@@ -0,0 +1,120 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+// Local includes
+#include "pch.h"
+#include "Image.h"
+#include "TrackedFrameMessage.h"
+#include "VolumeView.h"
+
+// STL includes
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace UWPOpenIGTLink;
+
+namespace UWPOpenIGTLinkTests
+{
+  TEST_CLASS(ImageSizeTests)
+  {
+  public:
+    TEST_METHOD(ComputesSizesAbove4GB)
+    {
+      uint64 sizeBytes(0);
+
+      // 1024x1024x1200 16 bit, overflowed the old 32 bit byte count arithmetic
+      Assert::IsTrue(Image::ComputeImageSizeBytes({ 1024, 1024, 1200 }, 1, IGTL_SCALARTYPE_UINT16, sizeBytes));
+      Assert::AreEqual(uint64(2516582400), sizeBytes);
+
+#ifdef _WIN64
+      // Exactly 2^32 bytes, a 32 bit product is 0
+      Assert::IsTrue(Image::ComputeImageSizeBytes({ 65536, 65536, 1 }, 1, IGTL_SCALARTYPE_UINT8, sizeBytes));
+      Assert::AreEqual(uint64(1) << 32, sizeBytes);
+
+      Assert::IsTrue(Image::ComputeImageSizeBytes({ 2048, 2048, 1200 }, 3, IGTL_SCALARTYPE_FLOAT32, sizeBytes));
+      Assert::AreEqual(uint64(2048) * 2048 * 1200 * 3 * 4, sizeBytes);
+
+      // Extents above 65535
+      Assert::IsTrue(Image::ComputeImageSizeBytes({ 100000, 70000, 1 }, 1, IGTL_SCALARTYPE_UINT8, sizeBytes));
+      Assert::AreEqual(uint64(7000000000), sizeBytes);
+#else
+      // size_t can't address these on 32 bit platforms
+      Assert::IsFalse(Image::ComputeImageSizeBytes({ 65536, 65536, 1 }, 1, IGTL_SCALARTYPE_UINT8, sizeBytes));
+      Assert::IsFalse(Image::ComputeImageSizeBytes({ 2048, 2048, 1200 }, 3, IGTL_SCALARTYPE_FLOAT32, sizeBytes));
+#endif
+    }
+
+    TEST_METHOD(RejectsSizesThatOverflow64Bit)
+    {
+      uint64 sizeBytes(42);
+      Assert::IsFalse(Image::ComputeImageSizeBytes({ 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF }, 4, IGTL_SCALARTYPE_FLOAT64, sizeBytes));
+      // 2^31 * 2^31 * 4 is exactly 2^64
+      Assert::IsFalse(Image::ComputeImageSizeBytes({ 0x80000000, 0x80000000, 4 }, 1, IGTL_SCALARTYPE_UINT8, sizeBytes));
+      Assert::AreEqual(uint64(42), sizeBytes);
+
+      Assert::IsTrue(Image::ComputeImageSizeBytes({ 0xFFFFFFFF, 0xFFFFFFFF, 0 }, 4, IGTL_SCALARTYPE_FLOAT64, sizeBytes));
+      Assert::AreEqual(uint64(0), sizeBytes);
+    }
+
+#ifdef _WIN64
+    TEST_METHOD(AddressesSparseVolumeAbove4GB)
+    {
+      // 5 GB of address space is reserved, only the last page is backed by memory
+      const FrameSize size = { 65536, 16384, 5 };
+      const size_t sizeBytes = size_t(size[0]) * size[1] * size[2];
+      const size_t pageSize = 4096;
+      byte* base = static_cast<byte*>(VirtualAllocFromApp(nullptr, sizeBytes, MEM_RESERVE, PAGE_READWRITE));
+      Assert::IsNotNull(base);
+      std::shared_ptr<byte> data(base, [](byte * address) { VirtualFree(address, 0, MEM_RELEASE); });
+      Assert::IsNotNull(VirtualAllocFromApp(base + sizeBytes - pageSize, pageSize, MEM_COMMIT, PAGE_READWRITE));
+
+      VolumeView view(data, size, 1, IGTL_SCALARTYPE_UINT8);
+      Assert::IsTrue(view.IsValid());
+      Assert::AreEqual(sizeBytes, view.GetNumberOfPixels());
+      Assert::IsTrue(view.GetPixel(65535, 16383, 4) == base + sizeBytes - 1);
+
+      *view.GetPixel(65535, 16383, 4) = 42;
+      VolumeView slice = view.Slice(2, 4);
+      Assert::IsTrue(slice.GetPixel(65535, 16383, 0) == base + sizeBytes - 1);
+
+      byte corner[16];
+      VolumeView crop = view.Crop({ 65536 - 16, 16383, 4 }, { 16, 1, 1 });
+      Assert::IsTrue(crop.CopyTo(corner));
+      Assert::AreEqual(byte(42), corner[15]);
+    }
+#endif
+
+    TEST_METHOD(TrackedFrameMessageRejectsImagesItCannotDescribe)
+    {
+      auto message = igtl::TrackedFrameMessage::New();
+      std::shared_ptr<byte> pixels(new byte[16], std::default_delete<byte[]>());
+      Assert::IsTrue(message->SetImage(pixels, { 4, 4, 1 }, 1, IGTL_SCALARTYPE_UINT8, US_IMG_BRIGHTNESS, US_IMG_ORIENT_MF));
+      Assert::AreEqual(igtl_uint32(16), message->GetImageSizeInBytes());
+
+      // The header holds 16 bit extents, the earlier image must not be packed instead
+      Assert::IsFalse(message->SetImage(pixels, { 70000, 1, 1 }, 1, IGTL_SCALARTYPE_UINT8, US_IMG_BRIGHTNESS, US_IMG_ORIENT_MF));
+      Assert::IsNull(message->GetImage().get());
+      Assert::AreEqual(igtl_uint32(0), message->GetImageSizeInBytes());
+    }
+  };
+}
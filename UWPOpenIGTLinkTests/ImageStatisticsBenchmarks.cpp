@@ -0,0 +1,207 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+// Local includes
+#include "pch.h"
+#include "Benchmark.h"
+#include "ImageStatistics.h"
+#include "VolumeView.h"
+
+// STL includes
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <type_traits>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace UWPOpenIGTLink;
+using namespace UWPOpenIGTLinkTests;
+
+namespace
+{
+  static const uint32 ROW_LENGTH = 1024;
+  static const size_t MEGABYTE = 1024 * 1024;
+
+  //----------------------------------------------------------------------------
+  struct ScalarStatistics
+  {
+    double Minimum = 0.0;
+    double Maximum = 0.0;
+    double Mean = 0.0;
+    double Variance = 0.0;
+    std::vector<uint64> Histogram;
+  };
+
+  //----------------------------------------------------------------------------
+  // The loop each consumer wrote before ImageStatistics, one value at a time, with a per value histogram of uint8 images
+  template<typename ScalarType>
+  void ComputeWithScalarLoop(const ScalarType* values, size_t count, ScalarStatistics& statistics)
+  {
+    double minimum = values[0];
+    double maximum = values[0];
+    double sum = 0.0;
+    double sumOfSquares = 0.0;
+    statistics.Histogram.assign(sizeof(ScalarType) == 1 ? 256 : 0, 0);
+    for (size_t i = 0; i < count; ++i)
+    {
+      const double value = values[i];
+      minimum = std::min(minimum, value);
+      maximum = std::max(maximum, value);
+      sum += value;
+      sumOfSquares += value * value;
+      if (sizeof(ScalarType) == 1)
+      {
+        ++statistics.Histogram[static_cast<size_t>(values[i])];
+      }
+    }
+    statistics.Minimum = minimum;
+    statistics.Maximum = maximum;
+    statistics.Mean = sum / count;
+    statistics.Variance = sumOfSquares / count - statistics.Mean * statistics.Mean;
+  }
+
+  //----------------------------------------------------------------------------
+  template<typename ScalarType>
+  std::shared_ptr<byte> CreateValues(size_t count)
+  {
+    std::mt19937 generator(1);
+    std::shared_ptr<byte> data(new byte[count * sizeof(ScalarType)], std::default_delete<byte[]>());
+    ScalarType* values = reinterpret_cast<ScalarType*>(data.get());
+    if (std::is_floating_point<ScalarType>::value)
+    {
+      std::uniform_real_distribution<float> distribution(-1000.f, 1000.f);
+      std::generate(values, values + count, [&]() { return static_cast<ScalarType>(distribution(generator)); });
+    }
+    else
+    {
+      std::generate(values, values + count, [&]() { return static_cast<ScalarType>(generator()); });
+    }
+    return data;
+  }
+
+  //----------------------------------------------------------------------------
+  // Statistics of a sizeBytes image of 1024 pixel rows, the scalar loop against ImageStatistics on one thread and on bands of rows
+  template<typename ScalarType>
+  void BenchmarkStatistics(const std::wstring& name, IGTL_SCALAR_TYPE scalarType, size_t sizeBytes)
+  {
+    const size_t count = sizeBytes / sizeof(ScalarType);
+    auto data = CreateValues<ScalarType>(count);
+    VolumeView view(data, { ROW_LENGTH, static_cast<uint32>(count / ROW_LENGTH), 1 }, 1, scalarType);
+    const int repetitions = sizeBytes > 100 * MEGABYTE ? 3 : 15;
+
+    // The histogram of uint8 images is per value, comparable with the scalar loop
+    auto statistics = ref new ImageStatistics();
+    statistics->NumberOfBins = sizeof(ScalarType) == 1 ? 256 : 0;
+    statistics->AutomaticHistogramRange = false;
+    statistics->HistogramMinimum = 0.0;
+    statistics->HistogramMaximum = 255.0;
+
+    ScalarStatistics expected;
+    const double scalarMicroseconds = MeasureMicroseconds([&]()
+    {
+      ComputeWithScalarLoop(reinterpret_cast<const ScalarType*>(data.get()), count, expected);
+    }, repetitions);
+
+    bool computed = true;
+    statistics->Parallel = false;
+    const double serialMicroseconds = MeasureMicroseconds([&]()
+    {
+      computed = statistics->Compute(view, 1) && computed;
+    }, repetitions);
+    statistics->Parallel = true;
+    const double parallelMicroseconds = MeasureMicroseconds([&]()
+    {
+      computed = statistics->Compute(view, 1) && computed;
+    }, repetitions);
+
+    ReportBenchmark(name + L", scalar loop", scalarMicroseconds, static_cast<double>(sizeBytes));
+    ReportBenchmark(name + L", ImageStatistics", serialMicroseconds, static_cast<double>(sizeBytes));
+    ReportBenchmark(name + L", ImageStatistics parallel", parallelMicroseconds, static_cast<double>(sizeBytes));
+    ReportSpeedup(name + L", parallel ImageStatistics versus scalar loop", scalarMicroseconds, parallelMicroseconds);
+
+    Assert::IsTrue(computed);
+    Assert::AreEqual(uint64(count), statistics->PixelCount);
+    Assert::AreEqual(expected.Minimum, statistics->Minimum);
+    Assert::AreEqual(expected.Maximum, statistics->Maximum);
+    Assert::AreEqual(expected.Mean, statistics->Mean, 1e-6 * (1.0 + std::sqrt(expected.Variance)));
+    Assert::AreEqual(expected.Variance, statistics->Variance, 1e-6 * expected.Variance);
+    if (sizeof(ScalarType) == 1)
+    {
+      auto histogram = statistics->Histogram;
+      Assert::AreEqual(expected.Histogram.size(), size_t(histogram->Length));
+      Assert::IsTrue(std::equal(expected.Histogram.begin(), expected.Histogram.end(), histogram->Data));
+    }
+  }
+}
+
+namespace UWPOpenIGTLinkTests
+{
+  TEST_CLASS(ImageStatisticsBenchmarks)
+  {
+  public:
+    BEGIN_TEST_CLASS_ATTRIBUTE()
+    TEST_CLASS_ATTRIBUTE(L"TestCategory", L"Benchmark")
+    END_TEST_CLASS_ATTRIBUTE()
+
+    TEST_METHOD(U8OneMegabyte)
+    {
+      BenchmarkStatistics<uint8>(L"1 MB U8", IGTL_SCALARTYPE_UINT8, MEGABYTE);
+    }
+
+    TEST_METHOD(U8SixteenMegabytes)
+    {
+      BenchmarkStatistics<uint8>(L"16 MB U8", IGTL_SCALARTYPE_UINT8, 16 * MEGABYTE);
+    }
+
+    TEST_METHOD(U8HundredMegabytes)
+    {
+      BenchmarkStatistics<uint8>(L"100 MB U8", IGTL_SCALARTYPE_UINT8, 100 * MEGABYTE);
+    }
+
+    TEST_METHOD(U8FiveHundredMegabytes)
+    {
+#ifdef _WIN64
+      BenchmarkStatistics<uint8>(L"500 MB U8", IGTL_SCALARTYPE_UINT8, 500 * MEGABYTE);
+#else
+      // A contiguous 500 MB buffer does not reliably fit in a 32 bit address space
+      Logger::WriteMessage(L"500 MB U8 is only run on 64 bit builds\n");
+#endif
+    }
+
+    TEST_METHOD(U16SixtyFourMegabytes)
+    {
+      BenchmarkStatistics<uint16>(L"64 MB U16", IGTL_SCALARTYPE_UINT16, 64 * MEGABYTE);
+    }
+
+    TEST_METHOD(S16SixtyFourMegabytes)
+    {
+      BenchmarkStatistics<int16>(L"64 MB S16", IGTL_SCALARTYPE_INT16, 64 * MEGABYTE);
+    }
+
+    TEST_METHOD(F32SixtyFourMegabytes)
+    {
+      BenchmarkStatistics<float>(L"64 MB F32", IGTL_SCALARTYPE_FLOAT32, 64 * MEGABYTE);
+    }
+  };
+}
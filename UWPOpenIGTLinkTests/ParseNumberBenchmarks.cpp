@@ -0,0 +1,147 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+// Local includes
+#include "pch.h"
+#include "Benchmark.h"
+#include "IGTCommon.h"
+
+// STL includes
+#include <cmath>
+#include <sstream>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Windows::Foundation::Numerics;
+
+namespace
+{
+  static const int TRANSFORMS_PER_FRAME = 10;
+  static const int FRAMES = 1000;
+
+  //----------------------------------------------------------------------------
+  // Transform fields as a server writes them, rotations and translations with 6 significant digits
+  std::vector<std::string> CreateTransformFields()
+  {
+    std::vector<std::string> fields;
+    for (int i = 0; i < TRANSFORMS_PER_FRAME; ++i)
+    {
+      const float angle = 0.1f * (i + 1);
+      std::ostringstream oss;
+      oss << std::cos(angle) << " " << -std::sin(angle) << " 0 " << 12.3456f * (i + 1) << " "
+          << std::sin(angle) << " " << std::cos(angle) << " 0 " << -98.7654f * (i + 1) << " "
+          << "0 0 1 " << 1234.56f + i << " 0 0 0 1";
+      fields.push_back(oss.str());
+    }
+    return fields;
+  }
+
+  //----------------------------------------------------------------------------
+  // The path ParseMatrix replaced, widened to a wstring and read with a wistringstream
+  void ParseWithStream(const std::string& field, float4x4& matrix)
+  {
+    std::wistringstream wiss(std::wstring(field.begin(), field.end()));
+    float* values = &matrix.m11;
+    for (int i = 0; i < 16; ++i)
+    {
+      wiss >> values[i];
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  void ParseWithStod(const std::string& field, float4x4& matrix)
+  {
+    float* values = &matrix.m11;
+    size_t position = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+      size_t consumed = 0;
+      values[i] = static_cast<float>(std::stod(field.substr(position), &consumed));
+      position += consumed;
+    }
+  }
+}
+
+namespace UWPOpenIGTLinkTests
+{
+  TEST_CLASS(ParseNumberBenchmarks)
+  {
+  public:
+    BEGIN_TEST_CLASS_ATTRIBUTE()
+    TEST_CLASS_ATTRIBUTE(L"TestCategory", L"Benchmark")
+    END_TEST_CLASS_ATTRIBUTE()
+
+    TEST_METHOD(TenTransformFrame)
+    {
+      const auto fields = CreateTransformFields();
+      std::vector<float4x4> parsed(TRANSFORMS_PER_FRAME), baseline(TRANSFORMS_PER_FRAME), stod(TRANSFORMS_PER_FRAME);
+
+      // Per frame cost, each measurement parses FRAMES frames
+      const double streamMicroseconds = MeasureMicroseconds([&]()
+      {
+        for (int frame = 0; frame < FRAMES; ++frame)
+        {
+          for (int i = 0; i < TRANSFORMS_PER_FRAME; ++i)
+          {
+            ParseWithStream(fields[i], baseline[i]);
+          }
+        }
+      }) / FRAMES;
+      const double stodMicroseconds = MeasureMicroseconds([&]()
+      {
+        for (int frame = 0; frame < FRAMES; ++frame)
+        {
+          for (int i = 0; i < TRANSFORMS_PER_FRAME; ++i)
+          {
+            ParseWithStod(fields[i], stod[i]);
+          }
+        }
+      }) / FRAMES;
+      const double parseMicroseconds = MeasureMicroseconds([&]()
+      {
+        for (int frame = 0; frame < FRAMES; ++frame)
+        {
+          for (int i = 0; i < TRANSFORMS_PER_FRAME; ++i)
+          {
+            UWPOpenIGTLink::ParseMatrix(fields[i], parsed[i]);
+          }
+        }
+      }) / FRAMES;
+
+      ReportBenchmark(L"wistringstream, per 10 transform frame", streamMicroseconds);
+      ReportBenchmark(L"std::stod, per 10 transform frame", stodMicroseconds);
+      ReportBenchmark(L"ParseMatrix, per 10 transform frame", parseMicroseconds);
+      ReportSpeedup(L"ParseMatrix versus wistringstream", streamMicroseconds, parseMicroseconds);
+
+      for (int i = 0; i < TRANSFORMS_PER_FRAME; ++i)
+      {
+        const float* expected = &baseline[i].m11;
+        const float* actual = &parsed[i].m11;
+        for (int j = 0; j < 16; ++j)
+        {
+          Assert::AreEqual(expected[j], actual[j], 1e-6f * (1.f + std::abs(expected[j])));
+          Assert::AreEqual(expected[j], (&stod[i].m11)[j], 1e-6f * (1.f + std::abs(expected[j])));
+        }
+      }
+    }
+  };
+}
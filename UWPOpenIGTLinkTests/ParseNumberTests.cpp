@@ -0,0 +1,76 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+// Local includes
+#include "pch.h"
+#include "IGTCommon.h"
+
+// STL includes
+#include <cstring>
+#include <limits>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UWPOpenIGTLinkTests
+{
+  namespace
+  {
+    const char* Parse(const char* text, double& value)
+    {
+      return UWPOpenIGTLink::ParseNumber(text, text + strlen(text), value);
+    }
+  }
+
+  TEST_CLASS(ParseNumberTests)
+  {
+  public:
+    TEST_METHOD(ExtremeExponentsSaturate)
+    {
+      double value(0.0);
+      const char* text = "1e2147483647";
+      Assert::IsTrue(Parse(text, value) == text + strlen(text));
+      Assert::AreEqual(std::numeric_limits<double>::infinity(), value);
+
+      text = "1e-2147483648";
+      Assert::IsTrue(Parse(text, value) == text + strlen(text));
+      Assert::AreEqual(0.0, value);
+
+      // Digits past the 19th add to an exponent that is already past the int32 range
+      text = "12345678901234567890123e99999999999999999999";
+      Assert::IsTrue(Parse(text, value) == text + strlen(text));
+      Assert::AreEqual(std::numeric_limits<double>::infinity(), value);
+    }
+
+    TEST_METHOD(ParsesDecimals)
+    {
+      // 2^53 + 1 is not representable, it rounds to 2^53
+      double value(0.0);
+      Parse("9007199254740993", value);
+      Assert::AreEqual(9007199254740992.0, value);
+      Parse("0.1", value);
+      Assert::AreEqual(0.1, value);
+      Parse("-2.5E-3", value);
+      Assert::AreEqual(-0.0025, value);
+    }
+  };
+}
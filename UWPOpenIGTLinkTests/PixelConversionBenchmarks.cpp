@@ -0,0 +1,167 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+// Local includes
+#include "pch.h"
+#include "Benchmark.h"
+#include "HalfFloat.h"
+#include "PixelConversion.h"
+
+// STL includes
+#include <cstring>
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace UWPOpenIGTLink;
+using namespace UWPOpenIGTLinkTests;
+
+namespace
+{
+  static const size_t PIXEL_COUNT = 1920 * 1080;
+
+  //----------------------------------------------------------------------------
+  // Random pixels, float values span [-0.1, 1.1] so that clamping is exercised
+  std::vector<byte> CreatePixels(uint16 numberOfScalarComponents, IGTL_SCALAR_TYPE scalarType)
+  {
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<float> distribution(-0.1f, 1.1f);
+    const size_t valueCount = PIXEL_COUNT * numberOfScalarComponents;
+    std::vector<byte> pixels;
+    if (scalarType == IGTL_SCALARTYPE_FLOAT32)
+    {
+      std::vector<float> values(valueCount);
+      for (auto& value : values)
+      {
+        value = distribution(generator);
+      }
+      pixels.resize(valueCount * sizeof(float));
+      memcpy(pixels.data(), values.data(), pixels.size());
+    }
+    else if (scalarType == IGTL_SCALARTYPE_FLOAT16)
+    {
+      std::vector<uint16_t> values(valueCount);
+      for (auto& value : values)
+      {
+        value = Float32ToFloat16(distribution(generator));
+      }
+      pixels.resize(valueCount * sizeof(uint16_t));
+      memcpy(pixels.data(), values.data(), pixels.size());
+    }
+    else
+    {
+      pixels.resize(valueCount * (scalarType == IGTL_SCALARTYPE_UINT8 ? 1 : 2));
+      for (auto& value : pixels)
+      {
+        value = static_cast<byte>(generator());
+      }
+    }
+    return pixels;
+  }
+
+  //----------------------------------------------------------------------------
+  // Convert a 1920x1080 image to BGRA8 with every instruction set up to the best one, each must match the scalar kernels
+  void BenchmarkFormat(const std::wstring& name, uint16 numberOfScalarComponents, IGTL_SCALAR_TYPE scalarType)
+  {
+    const auto source = CreatePixels(numberOfScalarComponents, scalarType);
+    std::vector<byte> destination(PIXEL_COUNT * 4);
+    std::vector<byte> scalarDestination;
+    bool converted = true;
+    bool matchesScalar = true;
+
+    const PIXEL_CONVERSION_ISA best = PixelConversion::GetInstructionSetLevel();
+    for (int level = PIXEL_CONVERSION_ISA_SCALAR; level <= best; ++level)
+    {
+      PixelConversion::SetInstructionSetLevel(static_cast<PIXEL_CONVERSION_ISA>(level));
+      if (PixelConversion::GetInstructionSetLevel() != level)
+      {
+        continue;
+      }
+
+      std::fill(destination.begin(), destination.end(), byte(0));
+      const double microseconds = MeasureMicroseconds([&]()
+      {
+        converted = PixelConversion::Convert(source.data(), destination.data(), PIXEL_COUNT, numberOfScalarComponents, scalarType, DISPLAY_PIXEL_FORMAT_BGRA8) && converted;
+      });
+      ReportBenchmark(name + L", " + PixelConversion::InstructionSet->Data(), microseconds, static_cast<double>(source.size()));
+
+      if (level == PIXEL_CONVERSION_ISA_SCALAR)
+      {
+        scalarDestination = destination;
+      }
+      else
+      {
+        matchesScalar = matchesScalar && destination == scalarDestination;
+      }
+    }
+    PixelConversion::SetInstructionSetLevel(best);
+
+    Assert::IsTrue(converted);
+    Assert::IsTrue(matchesScalar);
+  }
+}
+
+namespace UWPOpenIGTLinkTests
+{
+  TEST_CLASS(PixelConversionBenchmarks)
+  {
+  public:
+    BEGIN_TEST_CLASS_ATTRIBUTE()
+    TEST_CLASS_ATTRIBUTE(L"TestCategory", L"Benchmark")
+    END_TEST_CLASS_ATTRIBUTE()
+
+    TEST_METHOD(GreyU8)
+    {
+      BenchmarkFormat(L"1920x1080 U8", 1, IGTL_SCALARTYPE_UINT8);
+    }
+
+    TEST_METHOD(GreyU16)
+    {
+      BenchmarkFormat(L"1920x1080 U16", 1, IGTL_SCALARTYPE_UINT16);
+    }
+
+    TEST_METHOD(GreyS16)
+    {
+      BenchmarkFormat(L"1920x1080 S16", 1, IGTL_SCALARTYPE_INT16);
+    }
+
+    TEST_METHOD(GreyF32)
+    {
+      BenchmarkFormat(L"1920x1080 F32", 1, IGTL_SCALARTYPE_FLOAT32);
+    }
+
+    TEST_METHOD(GreyF16)
+    {
+      BenchmarkFormat(L"1920x1080 F16", 1, IGTL_SCALARTYPE_FLOAT16);
+    }
+
+    TEST_METHOD(RGB24)
+    {
+      BenchmarkFormat(L"1920x1080 RGB24", 3, IGTL_SCALARTYPE_UINT8);
+    }
+
+    TEST_METHOD(RGBA)
+    {
+      BenchmarkFormat(L"1920x1080 RGBA", 4, IGTL_SCALARTYPE_UINT8);
+    }
+  };
+}
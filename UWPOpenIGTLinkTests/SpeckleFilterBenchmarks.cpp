@@ -0,0 +1,116 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+// Local includes
+#include "pch.h"
+#include "Benchmark.h"
+#include "PixelConversion.h"
+#include "SpeckleFilter.h"
+
+// STL includes
+#include <algorithm>
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace UWPOpenIGTLink;
+using namespace UWPOpenIGTLinkTests;
+
+namespace
+{
+  // A frame period at 30 frames per second, the filter has to fit well inside it on the decode worker
+  static const double FRAME_PERIOD_MICROSECONDS = 33333.0;
+
+  //----------------------------------------------------------------------------
+  // 8 bit B-mode like frame, speckle with depth attenuation and a brighter horizontal band of tissue
+  std::vector<byte> CreateSpeckleFrame(const FrameSize& size)
+  {
+    std::mt19937 generator(1);
+    std::exponential_distribution<float> speckle(1.f);
+    std::vector<byte> frame(size[0] * size[1]);
+    for (uint32 y = 0; y < size[1]; ++y)
+    {
+      const float gain = (y > size[1] / 3 && y < size[1] / 2 ? 160.f : 80.f) * (1.f - 0.5f * y / size[1]);
+      for (uint32 x = 0; x < size[0]; ++x)
+      {
+        frame[y * size[0] + x] = static_cast<byte>(std::min(255.f, gain * speckle(generator)));
+      }
+    }
+    return frame;
+  }
+
+  //----------------------------------------------------------------------------
+  // Filter latency of one 8 bit frame with the scalar code and with the best instruction set, which must give the same pixels
+  void BenchmarkFrame(const std::wstring& name, const FrameSize& size)
+  {
+    const auto source = CreateSpeckleFrame(size);
+    std::vector<byte> scalarDestination(source.size()), destination(source.size());
+    SpeckleFilter::Parameters parameters;
+    bool filtered = true;
+
+    const PIXEL_CONVERSION_ISA best = PixelConversion::GetInstructionSetLevel();
+    PixelConversion::SetInstructionSetLevel(PIXEL_CONVERSION_ISA_SCALAR);
+    const double scalarMicroseconds = MeasureMicroseconds([&]()
+    {
+      filtered = SpeckleFilter::Apply(source.data(), size, 1, IGTL_SCALARTYPE_UINT8, parameters, scalarDestination.data()) && filtered;
+    });
+    PixelConversion::SetInstructionSetLevel(best);
+    const double microseconds = MeasureMicroseconds([&]()
+    {
+      filtered = SpeckleFilter::Apply(source.data(), size, 1, IGTL_SCALARTYPE_UINT8, parameters, destination.data()) && filtered;
+    });
+
+    ReportBenchmark(name + L", scalar", scalarMicroseconds, static_cast<double>(source.size()));
+    ReportBenchmark(name + L", " + PixelConversion::InstructionSet->Data(), microseconds, static_cast<double>(source.size()));
+    Logger::WriteMessage((name + L", share of a 30 fps frame period: " + std::to_wstring(100.0 * microseconds / FRAME_PERIOD_MICROSECONDS) + L"%\n").c_str());
+
+    Assert::IsTrue(filtered);
+    Assert::IsTrue(destination == scalarDestination);
+    Assert::IsTrue(destination != source);
+  }
+}
+
+namespace UWPOpenIGTLinkTests
+{
+  TEST_CLASS(SpeckleFilterBenchmarks)
+  {
+  public:
+    BEGIN_TEST_CLASS_ATTRIBUTE()
+    TEST_CLASS_ATTRIBUTE(L"TestCategory", L"Benchmark")
+    END_TEST_CLASS_ATTRIBUTE()
+
+    TEST_METHOD(Frame640x480)
+    {
+      BenchmarkFrame(L"640x480", { 640, 480, 1 });
+    }
+
+    TEST_METHOD(Frame1280x720)
+    {
+      BenchmarkFrame(L"1280x720", { 1280, 720, 1 });
+    }
+
+    TEST_METHOD(Frame1920x1080)
+    {
+      BenchmarkFrame(L"1920x1080", { 1920, 1080, 1 });
+    }
+  };
+}
@@ -0,0 +1,226 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+// Local includes
+#include "pch.h"
+#include "Image.h"
+#include "TrackedFrameMessage.h"
+#include "Transform.h"
+#include "TransformName.h"
+
+// IGT includes
+#include <igtlMessageHeader.h>
+
+// STL includes
+#include <cstring>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace Windows::Foundation::Numerics;
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  // Pack message and copy the bytes into a new message, as the receiver does
+  igtl::TrackedFrameMessage::Pointer Receive(igtl::TrackedFrameMessage::Pointer message)
+  {
+    message->Pack();
+
+    auto header = igtl::MessageHeader::New();
+    header->InitBuffer();
+    memcpy(header->GetBufferPointer(), message->GetBufferPointer(), header->GetBufferSize());
+    header->Unpack();
+
+    auto received = igtl::TrackedFrameMessage::New();
+    received->SetMessageHeader(header);
+    received->AllocateBuffer();
+    memcpy(received->GetBufferBodyPointer(), static_cast<const byte*>(message->GetBufferPointer()) + header->GetBufferSize(), received->GetBufferBodySize());
+    return received;
+  }
+
+  //----------------------------------------------------------------------------
+  // Pack message and unpack the bytes into a new message, as the receiver does
+  igtl::TrackedFrameMessage::Pointer RoundTrip(igtl::TrackedFrameMessage::Pointer message)
+  {
+    auto received = Receive(message);
+    Assert::IsTrue((received->Unpack(1) & igtl::MessageHeader::UNPACK_BODY) != 0);
+    return received;
+  }
+
+  //----------------------------------------------------------------------------
+  igtl::TrackedFrameMessage::Pointer CreateMessage(const UWPOpenIGTLink::TransformListInternal& transforms, bool binaryTransforms)
+  {
+    auto message = igtl::TrackedFrameMessage::New();
+    message->SetDeviceName("Test");
+    std::shared_ptr<byte> pixels(new byte[16], std::default_delete<byte[]>());
+    for (byte i = 0; i < 16; ++i)
+    {
+      pixels.get()[i] = i;
+    }
+    message->SetImage(pixels, { 4, 4, 1 }, 1, UWPOpenIGTLink::IGTL_SCALARTYPE_UINT8, UWPOpenIGTLink::US_IMG_BRIGHTNESS, UWPOpenIGTLink::US_IMG_ORIENT_MF);
+    message->SetFrameTransforms(transforms);
+    message->SetBinaryTransformsEnabled(binaryTransforms);
+    return message;
+  }
+
+  //----------------------------------------------------------------------------
+  igtl::TrackedFrameMessage::Pointer CreateDeltaMessage(byte firstValue, std::shared_ptr<UWPOpenIGTLink::DeltaStreamState> stream)
+  {
+    auto message = igtl::TrackedFrameMessage::New();
+    message->SetDeviceName("Test");
+    std::shared_ptr<byte> pixels(new byte[16], std::default_delete<byte[]>());
+    for (byte i = 0; i < 16; ++i)
+    {
+      pixels.get()[i] = firstValue + i;
+    }
+    message->SetImage(pixels, { 4, 4, 1 }, 1, UWPOpenIGTLink::IGTL_SCALARTYPE_UINT8, UWPOpenIGTLink::US_IMG_BRIGHTNESS, UWPOpenIGTLink::US_IMG_ORIENT_MF);
+    message->SetImageDeltaStream(stream);
+    return message;
+  }
+
+  //----------------------------------------------------------------------------
+  void AssertTransformsEqual(const UWPOpenIGTLink::TransformListInternal& expected, const UWPOpenIGTLink::TransformListInternal& actual)
+  {
+    Assert::AreEqual(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+      Assert::IsTrue(expected[i]->Name->GetTransformName() == actual[i]->Name->GetTransformName());
+      Assert::AreEqual(expected[i]->Valid, actual[i]->Valid);
+      Assert::IsTrue(expected[i]->Matrix == actual[i]->Matrix);
+    }
+  }
+}
+
+namespace UWPOpenIGTLinkTests
+{
+  TEST_CLASS(TrackedFrameMessageTests)
+  {
+  public:
+    TEST_METHOD(BinaryTransformsRoundTrip)
+    {
+      // Values that are not exact in 6 significant digits, the text fields would round them
+      UWPOpenIGTLink::TransformListInternal transforms;
+      transforms.push_back(ref new UWPOpenIGTLink::Transform(ref new UWPOpenIGTLink::TransformName(L"Probe", L"Reference"),
+                           float4x4(0.1234567f, -0.9876543f, 0.f, 12.345678f,
+                                    0.9876543f, 0.1234567f, 0.f, -98.765432f,
+                                    0.f, 0.f, 1.f, 1234.5678f,
+                                    0.f, 0.f, 0.f, 1.f), true, 0.0));
+      transforms.push_back(ref new UWPOpenIGTLink::Transform(ref new UWPOpenIGTLink::TransformName(L"Stylus", L"Reference"),
+                           make_float4x4_translation(1.f / 3.f, 2.f / 3.f, 4.f / 3.f), false, 0.0));
+
+      auto received = RoundTrip(CreateMessage(transforms, true));
+      AssertTransformsEqual(transforms, received->GetFrameTransforms());
+
+      // The pixels follow the same path as without the block
+      Assert::AreEqual(igtl_uint32(16), received->GetImageSizeInBytes());
+      Assert::AreEqual(byte(15), received->GetImage().get()[15]);
+    }
+
+    TEST_METHOD(NonAffineTransformsAreSentAsText)
+    {
+      // The block drops the last row, a projective transform must fall back to text fields
+      UWPOpenIGTLink::TransformListInternal transforms;
+      transforms.push_back(ref new UWPOpenIGTLink::Transform(ref new UWPOpenIGTLink::TransformName(L"Image", L"Probe"), make_float4x4_scale(2.f), true, 0.0));
+      transforms.push_back(ref new UWPOpenIGTLink::Transform(ref new UWPOpenIGTLink::TransformName(L"Probe", L"Reference"),
+                           float4x4(1.f, 0.f, 0.f, 0.f,
+                                    0.f, 1.f, 0.f, 0.f,
+                                    0.f, 0.f, 1.f, 0.f,
+                                    0.f, 0.f, 0.5f, 0.25f), true, 0.0));
+
+      auto received = RoundTrip(CreateMessage(transforms, true));
+      AssertTransformsEqual(transforms, received->GetFrameTransforms());
+    }
+
+    TEST_METHOD(DroppedImageKeepsTransforms)
+    {
+      UWPOpenIGTLink::TransformListInternal transforms;
+      transforms.push_back(ref new UWPOpenIGTLink::Transform(ref new UWPOpenIGTLink::TransformName(L"Probe", L"Reference"), make_float4x4_translation(1.f, 2.f, 3.f), true, 0.0));
+      auto received = RoundTrip(CreateMessage(transforms, false));
+
+      // A duplicate dropped by the receiver loses its image only
+      received->DropImage();
+      Assert::IsNull(received->GetImage().get());
+      AssertTransformsEqual(transforms, received->GetFrameTransforms());
+      Assert::IsNotNull(received->GetFrameFields().get());
+    }
+
+    TEST_METHOD(HugeXmlSizeIsRejected)
+    {
+      UWPOpenIGTLink::TransformListInternal transforms;
+      auto received = Receive(CreateMessage(transforms, false));
+
+      // Overwrite the xml size of the frame header (after scalar type, components, image type, frame size and image size) with a value that wraps a 32 bit size_t
+      byte* body = static_cast<byte*>(received->GetBufferBodyPointer());
+      const size_t contentOffset = received->GetHeaderVersion() >= IGTL_HEADER_VERSION_2 ? (static_cast<size_t>(body[0]) << 8 | body[1]) : 0;
+      const byte hugeSize[] = { 0xFF, 0xFF, 0xFF, 0xF0 };
+      memcpy(body + contentOffset + 16, hugeSize, sizeof(hugeSize));
+
+      Assert::IsFalse(received->UnpackFrameDescription(received->GetBufferBodySize()));
+      Assert::IsTrue((received->Unpack(0) & igtl::MessageHeader::UNPACK_BODY) == 0);
+    }
+
+    TEST_METHOD(ReadingReceivedImageDoesNotCopy)
+    {
+      UWPOpenIGTLink::TransformListInternal transforms;
+      auto received = RoundTrip(CreateMessage(transforms, false));
+
+      auto image = ref new UWPOpenIGTLink::Image();
+      image->SetImageData(received->GetImage(), 1, UWPOpenIGTLink::IGTL_SCALARTYPE_UINT8, UWPOpenIGTLink::FrameSize{ 4, 4, 1 });
+
+      // The first buffer is still referenced when the property is read again, as the UI does on every tick
+      const uint64 detachedBytes = UWPOpenIGTLink::Image::CopyOnWriteDetachedBytes;
+      auto first = image->ImageData;
+      auto second = image->ImageData;
+      Assert::AreEqual(detachedBytes, UWPOpenIGTLink::Image::CopyOnWriteDetachedBytes);
+      Assert::IsTrue(UWPOpenIGTLink::GetDataFromIBuffer<byte>(first) == received->GetImage().get());
+      Assert::IsTrue(UWPOpenIGTLink::GetDataFromIBuffer<byte>(second) == received->GetImage().get());
+    }
+
+    TEST_METHOD(WritingKeyFrameKeepsDeltaReference)
+    {
+      auto sendStream = std::make_shared<UWPOpenIGTLink::DeltaStreamState>();
+      UWPOpenIGTLink::DeltaStreamState receiveStream;
+
+      auto keyFrame = CreateDeltaMessage(0, sendStream);
+      auto receivedKeyFrame = RoundTrip(keyFrame);
+      keyFrame->CommitImageDelta(true);
+      Assert::IsTrue(receivedKeyFrame->DecodeImageDelta(receiveStream));
+
+      // The image aliases the message body that is also the stream's reference, writing it must copy the pixels first
+      auto image = ref new UWPOpenIGTLink::Image();
+      image->SetImageData(receivedKeyFrame->GetImage(), 1, UWPOpenIGTLink::IGTL_SCALARTYPE_UINT8, UWPOpenIGTLink::FrameSize{ 4, 4, 1 });
+      Assert::IsTrue(image->IsImageDataShared());
+      memset(image->GetMutableImageDataInternal().get(), 0xFF, 16);
+      Assert::AreEqual(byte(5), receivedKeyFrame->GetImage().get()[5]);
+
+      auto deltaFrame = CreateDeltaMessage(1, sendStream);
+      auto receivedDeltaFrame = RoundTrip(deltaFrame);
+      deltaFrame->CommitImageDelta(true);
+      Assert::IsTrue(receivedDeltaFrame->IsImageDeltaEncoded());
+      Assert::IsTrue(receivedDeltaFrame->DecodeImageDelta(receiveStream));
+      for (byte i = 0; i < 16; ++i)
+      {
+        Assert::AreEqual(byte(i + 1), receivedDeltaFrame->GetImage().get()[i]);
+      }
+    }
+  };
+}
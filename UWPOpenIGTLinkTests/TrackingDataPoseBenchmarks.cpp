@@ -0,0 +1,179 @@
+/*====================================================================
+Copyright(c) 2018 Adam Rankin
+
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files(the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and / or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included
+in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL
+THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+OTHER DEALINGS IN THE SOFTWARE.
+====================================================================*/
+
+// Local includes
+#include "pch.h"
+#include "Benchmark.h"
+#include "TrackingDataPoseMessage.h"
+
+// IGT includes
+#include <igtlMessageHeader.h>
+#include <igtlTrackingDataMessage.h>
+
+// STL includes
+#include <cmath>
+#include <cstring>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace UWPOpenIGTLinkTests;
+using namespace Windows::Foundation::Numerics;
+
+namespace
+{
+  static const int ELEMENTS = 1000;
+  static const int MESSAGES = 100;
+  static const float UNIT_SCALE = 0.001f;
+
+  //----------------------------------------------------------------------------
+  igtl::TrackingDataMessage::Pointer CreateMessage()
+  {
+    auto message = igtl::TrackingDataMessage::New();
+    message->SetDeviceName("Tracker");
+    for (int i = 0; i < ELEMENTS; ++i)
+    {
+      const float angle = 0.001f * i;
+      igtl::Matrix4x4 matrix =
+      {
+        { std::cos(angle), -std::sin(angle), 0.f, 12.345f * i },
+        { std::sin(angle), std::cos(angle), 0.f, -98.765f * i },
+        { 0.f, 0.f, 1.f, 1234.5f + i },
+        { 0.f, 0.f, 0.f, 1.f }
+      };
+      auto element = igtl::TrackingDataElement::New();
+      element->SetName(("Tool" + std::to_string(i)).c_str());
+      element->SetType(igtl::TrackingDataElement::TYPE_6D);
+      element->SetMatrix(matrix);
+      message->AddTrackingDataElement(element);
+    }
+    message->Pack();
+    return message;
+  }
+
+  //----------------------------------------------------------------------------
+  // Copy the packed bytes of sent into received, as the receiver does before Unpack
+  void Receive(igtl::TrackingDataMessage::Pointer sent, igtl::MessageBase* received)
+  {
+    auto header = igtl::MessageHeader::New();
+    header->InitBuffer();
+    memcpy(header->GetBufferPointer(), sent->GetBufferPointer(), header->GetBufferSize());
+    header->Unpack();
+
+    received->SetMessageHeader(header);
+    received->AllocateBuffer();
+    memcpy(received->GetBufferBodyPointer(), static_cast<const byte*>(sent->GetBufferPointer()) + header->GetBufferSize(), received->GetBufferBodySize());
+  }
+
+  //----------------------------------------------------------------------------
+  // The path TrackingDataPoseMessage replaced, unpack, scale every translation with GetMatrix/SetMatrix, then read every matrix again
+  void DecodeWithTrackingDataMessage(igtl::TrackingDataMessage::Pointer sent, std::vector<std::string>& names, std::vector<float4x4>& poses)
+  {
+    auto message = igtl::TrackingDataMessage::New();
+    Receive(sent, message);
+    message->Unpack(1);
+
+    auto element = igtl::TrackingDataElement::New();
+    igtl::Matrix4x4 matrix;
+    for (int i = 0; i < message->GetNumberOfTrackingDataElements(); ++i)
+    {
+      message->GetTrackingDataElement(i, element);
+      element->GetMatrix(matrix);
+      matrix[0][3] = matrix[0][3] * UNIT_SCALE;
+      matrix[1][3] = matrix[1][3] * UNIT_SCALE;
+      matrix[2][3] = matrix[2][3] * UNIT_SCALE;
+      element->SetMatrix(matrix);
+    }
+
+    names.resize(message->GetNumberOfTrackingDataElements());
+    poses.resize(message->GetNumberOfTrackingDataElements());
+    for (int i = 0; i < message->GetNumberOfTrackingDataElements(); ++i)
+    {
+      message->GetTrackingDataElement(i, element);
+      names[i] = element->GetName();
+      element->GetMatrix(matrix);
+      memcpy(&poses[i], &matrix[0][0], sizeof(float4x4));
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  void DecodeWithTrackingDataPoseMessage(igtl::TrackingDataMessage::Pointer sent, std::vector<std::string>& names, std::vector<float4x4>& poses)
+  {
+    auto message = igtl::TrackingDataPoseMessage::New();
+    Receive(sent, message);
+    message->SetTranslationScale(UNIT_SCALE);
+    message->Unpack(1);
+
+    names.resize(message->GetNumberOfPoses());
+    poses.resize(message->GetNumberOfPoses());
+    for (size_t i = 0; i < message->GetNumberOfPoses(); ++i)
+    {
+      names[i] = message->GetPoseName(i);
+      poses[i] = message->GetPose(i);
+    }
+  }
+}
+
+namespace UWPOpenIGTLinkTests
+{
+  TEST_CLASS(TrackingDataPoseBenchmarks)
+  {
+  public:
+    BEGIN_TEST_CLASS_ATTRIBUTE()
+    TEST_CLASS_ATTRIBUTE(L"TestCategory", L"Benchmark")
+    END_TEST_CLASS_ATTRIBUTE()
+
+    TEST_METHOD(ThousandElementMessage)
+    {
+      auto sent = CreateMessage();
+      std::vector<std::string> baselineNames, names;
+      std::vector<float4x4> baseline, poses;
+
+      // Per message cost, each measurement receives MESSAGES messages
+      const double baselineMicroseconds = MeasureMicroseconds([&]()
+      {
+        for (int i = 0; i < MESSAGES; ++i)
+        {
+          DecodeWithTrackingDataMessage(sent, baselineNames, baseline);
+        }
+      }) / MESSAGES;
+      const double poseMicroseconds = MeasureMicroseconds([&]()
+      {
+        for (int i = 0; i < MESSAGES; ++i)
+        {
+          DecodeWithTrackingDataPoseMessage(sent, names, poses);
+        }
+      }) / MESSAGES;
+
+      ReportBenchmark(L"TrackingDataMessage, unpack, scale and read, per 1000 element message", baselineMicroseconds);
+      ReportBenchmark(L"TrackingDataPoseMessage, per 1000 element message", poseMicroseconds);
+      ReportSpeedup(L"TrackingDataPoseMessage versus TrackingDataMessage", baselineMicroseconds, poseMicroseconds);
+
+      Assert::AreEqual(size_t(ELEMENTS), poses.size());
+      Assert::AreEqual(baseline.size(), poses.size());
+      for (size_t i = 0; i < poses.size(); ++i)
+      {
+        Assert::IsTrue(baselineNames[i] == names[i]);
+        Assert::IsTrue(baseline[i] == poses[i]);
+      }
+    }
+  };
+}
@@ -0,0 +1,23 @@
+﻿//
+// pch.h
+// Header for standard system include files.
+//
+
+#pragma once
+
+// The library sources are compiled into the test application, they expect the library's precompiled includes
+#include <concrt.h>
+#include <WindowsNumerics.h>
+#include <wrl.h>
+#include <memory>
+#include <map>
+#include <mutex>
+#include <string>
+#include <collection.h>
+#include <ppltasks.h>
+
+#include <wrl\client.h>
+#include <wrl\implements.h>
+
+#include <CppUnitTest.h>
+#include "UnitTestApp.xaml.h"
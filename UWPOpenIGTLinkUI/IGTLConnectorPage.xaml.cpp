@@ -45,35 +45,6 @@ using namespace Windows::UI::Xaml::Controls;
 using namespace Windows::UI::Xaml::Media::Imaging;
 using namespace Windows::UI::Xaml;
 
-namespace
-{
-  //----------------------------------------------------------------------------
-  inline void ThrowIfFailed(HRESULT hr)
-  {
-    if (FAILED(hr))
-    {
-      throw Platform::Exception::CreateException(hr);
-    }
-  }
-
-  //----------------------------------------------------------------------------
-  byte* GetPointerToPixelData(IBuffer^ buffer)
-  {
-    // Cast to Object^, then to its underlying IInspectable interface.
-    Platform::Object^ obj = buffer;
-    Microsoft::WRL::ComPtr<IInspectable> insp(reinterpret_cast<IInspectable*>(obj));
-
-    // Query the IBufferByteAccess interface.
-    Microsoft::WRL::ComPtr<IBufferByteAccess> bufferByteAccess;
-    ThrowIfFailed(insp.As(&bufferByteAccess));
-
-    // Retrieve the buffer data.
-    byte* pixels = nullptr;
-    ThrowIfFailed(bufferByteAccess->Buffer(&pixels));
-    return pixels;
-  }
-}
-
 namespace UWPOpenIGTLinkUI
 {
   //----------------------------------------------------------------------------
@@ -102,7 +73,7 @@ namespace UWPOpenIGTLinkUI
         m_WriteableBitmap = ref new WriteableBitmap(frame->Dimensions[0], frame->Dimensions[1]);
       }
 
-      if (!IBufferToWriteableBitmap(frame->Frame->Image->ImageData, frame->Dimensions[0], frame->Dimensions[1], frame->Frame->NumberOfScalarComponents))
+      if (!IBufferToWriteableBitmap(frame->Frame->Image->ImageData, frame->Dimensions[0], frame->Dimensions[1], frame->Frame->NumberOfScalarComponents, frame->Frame->ScalarType))
       {
         return;
       }
@@ -205,10 +176,10 @@ namespace UWPOpenIGTLinkUI
   }
 
   //----------------------------------------------------------------------------
-  bool IGTLConnectorPage::IBufferToWriteableBitmap(IBuffer^ data, uint32 width, uint32 height, uint16 numberOfcomponents)
+  bool IGTLConnectorPage::IBufferToWriteableBitmap(IBuffer^ data, uint32 width, uint32 height, uint16 numberOfcomponents, int scalarType)
   {
-    auto divisor = numberOfcomponents / 4.0; // WriteableBitmap has 4 8-bit components BGRA
-    if (data->Length * 1.0 != m_WriteableBitmap->PixelBuffer->Length * divisor)
+    // WriteableBitmap has 4 8-bit components BGRA
+    if (m_WriteableBitmap->PixelBuffer->Length != width * height * 4)
     {
       OutputDebugStringA("Buffers do not contain the same number of pixels.");
       return false;
@@ -216,30 +187,11 @@ namespace UWPOpenIGTLinkUI
 
     try
     {
-      byte* sourceImageData = GetPointerToPixelData(data);
-      byte* targetImageData = GetPointerToPixelData(m_WriteableBitmap->PixelBuffer);
-
-      for (unsigned int j = 0; j < height; j++)
+      // Only the first slice of a volume is displayed
+      if (!PixelConversion::ConvertToDisplay(data, m_WriteableBitmap->PixelBuffer, width * height, numberOfcomponents, scalarType, true))
       {
-        for (unsigned int i = 0; i < width; i++)
-        {
-          if (numberOfcomponents == 3)
-          {
-            targetImageData[0] = sourceImageData[0];
-            targetImageData[1] = sourceImageData[1];
-            targetImageData[2] = sourceImageData[2];
-          }
-          else if (numberOfcomponents == 1)
-          {
-            targetImageData[0] = *sourceImageData;
-            targetImageData[1] = *sourceImageData;
-            targetImageData[2] = *sourceImageData;
-          }
-          targetImageData[3] = 255U; // set to full alpha
-
-          sourceImageData += numberOfcomponents;
-          targetImageData += 4;
-        }
+        OutputDebugStringA("Unsupported pixel format or buffer too small.\n");
+        return false;
       }
     }
     catch (Platform::Exception^ e)
@@ -40,8 +40,8 @@ namespace UWPOpenIGTLinkUI
     void ConnectButton_Click(Platform::Object^ sender, Windows::UI::Xaml::RoutedEventArgs^ e);
     void ProcessConnectionResult(bool result);
 
-    /// Copy the contents of an incoming data buffer to our stored writeable bitmap
-    bool IBufferToWriteableBitmap(Windows::Storage::Streams::IBuffer^ data, uint32 width, uint32 height, uint16 numberOfcomponents);
+    /// Convert the contents of an incoming data buffer to our stored writeable bitmap
+    bool IBufferToWriteableBitmap(Windows::Storage::Streams::IBuffer^ data, uint32 width, uint32 height, uint16 numberOfcomponents, int scalarType);
 
   protected private:
     UWPOpenIGTLink::IGTClient^                              m_IGTClient = ref new UWPOpenIGTLink::IGTClient();